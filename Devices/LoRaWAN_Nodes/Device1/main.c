@@ -27,7 +27,8 @@
 #include "msg.h"
 #include "shell.h"
 #include "fmt.h"
-#include "xtimer.h"
+#include "periodic.h"
+#include "fixp.h"
 
 #include "net/loramac.h"
 #include "semtech_loramac.h"
@@ -81,13 +82,8 @@ int generate_random_rain(void) { //this will generate random number in range l a
     return rand_num;
 }
 
-int genNextValue(int prevValue, int min, int max){ //generate a new value not too different from the last one.
-    int value = prevValue + ((max - min) * (((rand() % 11) - 5))) * 0.003;
-    if(value > max) value=max;
-    else if (value < min) value=min;
-    else value=value;
-
-    return value;
+fixp_t genNextValue(int prevValue, int min, int max){ //generate a new value not too different from the last one.
+    return fixp_random_walk(fixp_from_int(prevValue), min, max);
 }
 
 semtech_loramac_t loramac;
@@ -548,16 +544,20 @@ static int _cmd_loramac(int argc, char **argv)
         int inte = generate_random_int();
         int rain = generate_random_rain();
         int device = 1;
+        //one message every 5 seconds, however long the send takes, the
+        //schedule statistics every 5 minutes
+        periodic_task_t tx_task;
+        periodic_init(&tx_task, "tx", 5000, NULL, NULL);
 
         while (true)
         {
 
             //generating new values
-            int new_temp = genNextValue(temp, -50, 50);
-            int new_hum = genNextValue(hum, 0, 100);
-            int new_dir = genNextValue(dir, 0, 360);
-            int new_inte = genNextValue(inte, 0, 100);
-            int new_rain = genNextValue(rain, 0, 50);
+            fixp_t new_temp = genNextValue(temp, -50, 50);
+            fixp_t new_hum = genNextValue(hum, 0, 100);
+            fixp_t new_dir = genNextValue(dir, 0, 360);
+            fixp_t new_inte = genNextValue(inte, 0, 100);
+            fixp_t new_rain = genNextValue(rain, 0, 50);
             /*printf("%d° \t", new_temp);
             printf("%d%% \t", new_hum);
             printf("%d° \t", new_dir);
@@ -572,7 +572,7 @@ static int _cmd_loramac(int argc, char **argv)
             //store the values in a variable so we can pass it in the publish
 
             char argomento[200];// = "{\"device\": 5.2,\"temperature\": 33, \"humidity\": 22}";
-            sprintf(argomento, "{\"device\": \"%d\", \"temperature\": \"%d\", \"humidity\": \"%d\", \"windDirection\": \"%d\", \"windIntensity\": \"%d\", \"rainHeight\": \"%d\"}", device, new_temp, new_hum, new_dir, new_inte, new_rain); //creating the argument to pass it in the tx
+            sprintf(argomento, "{\"device\": \"%d\", \"temperature\": \"%d\", \"humidity\": \"%d\", \"windDirection\": \"%d\", \"windIntensity\": \"%d\", \"rainHeight\": \"%d\"}", device, (int)fixp_to_int(new_temp), (int)fixp_to_int(new_hum), (int)fixp_to_int(new_dir), (int)fixp_to_int(new_inte), (int)fixp_to_int(new_rain)); //creating the argument to pass it in the tx
 
             uint8_t cnf = LORAMAC_DEFAULT_TX_MODE;  /* Default: confirmable */
             uint8_t port = LORAMAC_DEFAULT_TX_PORT; /* Default: 2 */
@@ -654,7 +654,10 @@ static int _cmd_loramac(int argc, char **argv)
                     loramac.link_chk.nb_gateways);
             }
 
-            xtimer_sleep(5);
+            if ((tx_task.runs % 60) == 0) {
+                periodic_print_stats(&tx_task, 1);
+            }
+            periodic_wait(&tx_task);
         }
         return 0;
         
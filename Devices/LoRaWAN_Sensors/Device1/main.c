@@ -19,7 +19,8 @@
 
 #include <string.h>
 
-#include "xtimer.h"
+#include "oneshot.h"
+#include "periodic.h"
 
 #include "net/loramac.h"
 #include "semtech_loramac.h"
@@ -28,8 +29,22 @@
 #include "hts221_params.h"
 
 #include "board.h"
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
+/* STOP is only allowed while the node waits for the next uplink: the join
+ * and the send need the radio and its timers running */
+#if defined(MODULE_PM_LAYERED) && defined(STM32_PM_STOP)
+#define STOP_BLOCK()        pm_block(STM32_PM_STOP)
+#define STOP_UNBLOCK()      pm_unblock(STM32_PM_STOP)
+#else
+#define STOP_BLOCK()
+#define STOP_UNBLOCK()
+#endif
 
 static hts221_t hts221;
+static oneshot_energy_t hts221_energy;
 
 static semtech_loramac_t loramac;
 
@@ -37,36 +52,52 @@ static const uint8_t deveui[LORAMAC_DEVEUI_LEN] = { 0x00, 0x27, 0x0A, 0x9B, 0xCC
 static const uint8_t appeui[LORAMAC_APPEUI_LEN] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x02, 0xD4, 0xAC };
 static const uint8_t appkey[LORAMAC_APPKEY_LEN] = { 0x35, 0x38, 0xF4, 0x18, 0xC1, 0xB6, 0xD2, 0x77, 0x4D, 0x31, 0x02, 0x57, 0x32, 0x1D, 0x5A, 0x5E };
 
-static void sender(void)
+/* one uplink every 20 secs, measured from the start and not from the
+ * end of the previous send */
+#define UPLINK_PERIOD       (20U * 1000U)
+/* the schedule statistics once an hour, not after every uplink */
+#define STATS_EVERY         (180U)
+
+static periodic_task_t tasks[1];
+
+static void send_measurement(void *arg)
 {
-    while (1) {
-        char message[32];
-        /* sleep 20 secs */
-        xtimer_sleep(20);
-
-        /* do some measurements */
-        uint16_t humidity = 0;
-        int16_t temperature = 0;
-        if (hts221_read_humidity(&hts221, &humidity) != HTS221_OK) {    //reads humidity
-            puts(" -- failed to read humidity!");
-        }
-        if (hts221_read_temperature(&hts221, &temperature) != HTS221_OK) {  //reads temperature
-            puts(" -- failed to read temperature!");
-        }
-
-        sprintf(message, "{\"humidity\": \"%u.%u\", \"temperature\": \"%u.%u\", \"device\": \"1\"}",    //prepare the message for the send
-                (humidity / 10), (humidity % 10),
-                (temperature / 10), (temperature % 10));
-        printf("Sending data: %s\n", message);  //prints on terminal
-
-        /* send the LoRaWAN message */
-        uint8_t ret = semtech_loramac_send(&loramac, (uint8_t *)message,
-                                           strlen(message));
-        if (ret != SEMTECH_LORAMAC_TX_DONE) {
-            printf("Cannot send message '%s', ret code: %d\n", message, ret);
-        }
+    (void)arg;
+    char message[32];
+
+    /* do some measurements */
+    uint16_t humidity = 0;
+    int16_t temperature = 0;
+    /* the sensor is only powered for this one conversion */
+    if (oneshot_hts221_read(&hts221, &humidity, &temperature,
+                            &hts221_energy) != HTS221_OK) {
+        puts(" -- failed to read humidity and temperature!");
     }
 
+    sprintf(message, "{\"humidity\": \"%u.%u\", \"temperature\": \"%u.%u\", \"device\": \"1\"}",    //prepare the message for the send
+            (humidity / 10), (humidity % 10),
+            (temperature / 10), (temperature % 10));
+    printf("Sending data: %s\n", message);  //prints on terminal
+
+    /* send the LoRaWAN message */
+    STOP_BLOCK();
+    uint8_t ret = semtech_loramac_send(&loramac, (uint8_t *)message,
+                                       strlen(message));
+    STOP_UNBLOCK();
+    if (ret != SEMTECH_LORAMAC_TX_DONE) {
+        printf("Cannot send message '%s', ret code: %d\n", message, ret);
+    }
+    if ((tasks[0].runs % STATS_EVERY) == 0) {
+        periodic_print_stats(tasks, 1);
+    }
+    oneshot_energy_print(&hts221_energy);
+}
+
+static void sender(void)
+{
+    periodic_init(&tasks[0], "uplink", UPLINK_PERIOD, send_measurement, NULL);
+    periodic_run(tasks, 1);
+
     /* this should never be reached */
     return;
 }
@@ -78,17 +109,12 @@ int main(void)
         LED3_TOGGLE;
         return 1;
     }
-    if (hts221_power_on(&hts221) != HTS221_OK) {
-        puts("Sensor initialization power on failed");
+    /* no continuous mode, the sensor sleeps until the next uplink */
+    if (oneshot_hts221_init(&hts221, &hts221_energy) != HTS221_OK) {
+        puts("Sensor one-shot mode setup failed");
         LED3_TOGGLE;
         return 1;
     }
-    if (hts221_set_rate(&hts221, hts221.p.rate) != HTS221_OK) {
-        puts("Sensor continuous mode setup failed");
-        LED3_TOGGLE;
-        return 1;
-    }
-
 
     /* 1. initialize the LoRaMAC MAC layer */
     semtech_loramac_init(&loramac);
@@ -105,6 +131,8 @@ int main(void)
         return 1;
     }
     puts("Join procedure succeeded");
+    /* nothing runs between two uplinks, let the MCU enter STOP */
+    STOP_UNBLOCK();
 
     puts("All up, running the shell now");
     
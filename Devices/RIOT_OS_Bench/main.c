@@ -0,0 +1,604 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       Benchmarks of the per-sample hot path of the firmwares
+ *
+ * Every benchmark runs in a fresh thread with a stack test pattern, so the
+ * peak stack can be measured afterwards. Results are printed as a table and
+ * as one JSON object per line starting with {"bench", for scripts.
+ *
+ * Topic lookup and publishing need a gateway and only run when the
+ * application is built with BENCH_GW. The wake benchmarks compare a node
+ * that connects, publishes once and disconnects against a single QoS -1
+ * message, and also print the radio energy of one reading. The pub_json
+ * benchmarks compare a JSON payload built on the stack and copied into the
+ * transmit buffer by emcute or qosm1 against one written in place with
+ * qosm1_pub_begin(), with the payload copies of every publish.
+ *
+ * With BENCH_LORA the LoRaWAN send path of LoRaWAN_Nodes runs on the
+ * sx127x_stub radio: semtech_loramac_send() is timed until the frame reaches
+ * the radio, the receive windows after it are left out.
+ *
+ * The _float benchmarks keep the floating point generator and %.2f of the
+ * clients before the fixp module, next to their fixed-point replacements,
+ * unless the application is built with BENCH_FLOAT=0.
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mutex.h"
+#include "thread.h"
+#include "xtimer.h"
+#include "periph/pm.h"
+#include "fixp.h"
+#include "telemetry.h"
+#ifdef BENCH_GW
+#include "net/emcute.h"
+#include "net/ipv6/addr.h"
+#include "topic_cache.h"
+#include "predefined_topics.h"
+#include "qosm1.h"
+#endif
+#ifdef BENCH_LORA
+#include "net/loramac.h"
+#include "semtech_loramac.h"
+#include "sx127x_stub.h"
+#endif
+
+/* iterations of the cheap benchmarks, the network ones do fewer */
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    (10000U)
+#endif
+
+#define BENCH_STACKSIZE     (THREAD_STACKSIZE_DEFAULT)
+
+/* radio of the wake benchmarks, the AT86RF231 of the M3 at 3 V: 32 us per
+ * byte at 250 kbit/s, 14 mA sending and 12.3 mA listening for the answer */
+#define BENCH_RADIO_NJ_PER_BYTE     (1344U)
+#define BENCH_RADIO_LISTEN_NJ_PER_US (37U)
+/* 802.15.4 PHY and MAC header plus compressed IPv6 and UDP, per frame */
+#define BENCH_FRAME_OVERHEAD        (40U)
+
+typedef struct {
+    const char *name;
+    /* runs the operation n times, returns the bytes of one message or 0 */
+    int (*run)(unsigned n);
+    unsigned n;
+    unsigned packets;   /* frames per op of the wake benchmarks, 0 = others */
+    int copies;         /* payload copies per publish, -1 = no publish */
+} bench_t;
+
+static char bench_stack[BENCH_STACKSIZE];
+static mutex_t done = MUTEX_INIT_LOCKED;
+
+/* state of the simulated sensors, like the MQTT-SN clients */
+static int temp = 20, hum = 50, dir = 180, inte = 10, rain = 5;
+static telemetry_sample_t sample;
+
+/* keeps the compiler from dropping the work */
+static volatile int sink;
+
+/* usec the operations of a benchmark waited for the protocol rather than
+ * worked, left out of its ns/op */
+static uint32_t waited;
+
+static void _take_sample(telemetry_sample_t *s)
+{
+    telemetry_sample_init(s, 1, 1600000000);
+    telemetry_sample_set(s, TELEMETRY_TEMPERATURE,
+                         fixp_random_walk(fixp_from_int(temp), -50, 50));
+    telemetry_sample_set(s, TELEMETRY_HUMIDITY,
+                         fixp_random_walk(fixp_from_int(hum), 0, 100));
+    telemetry_sample_set(s, TELEMETRY_WIND_DIRECTION,
+                         fixp_random_walk(fixp_from_int(dir), 0, 360));
+    telemetry_sample_set(s, TELEMETRY_WIND_INTENSITY,
+                         fixp_random_walk(fixp_from_int(inte), 0, 100));
+    telemetry_sample_set(s, TELEMETRY_RAIN_HEIGHT,
+                         fixp_random_walk(fixp_from_int(rain), 0, 50));
+}
+
+/* genNextValue() for the five fields of one sample */
+static int bench_gen(unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        _take_sample(&sample);
+    }
+    sink = sample.value[0];
+    return 0;
+}
+
+#ifdef BENCH_FLOAT
+/* genNextValue() and to_centi() of the clients before the fixp module, the
+ * same walk in float, rounded to hundredths for the telemetry records */
+static float _float_walk(int prev, int min, int max)
+{
+    float value = prev + ((max - min) * (((rand() % 11) - 5))) * 0.003;
+    if (value > max) {
+        value = max;
+    }
+    else if (value < min) {
+        value = min;
+    }
+    return value;
+}
+
+static int32_t _to_centi(float value)
+{
+    return (int32_t)((value * 100) + ((value < 0) ? -0.5f : 0.5f));
+}
+
+static int bench_gen_float(unsigned n)
+{
+    float fvalue[TELEMETRY_FIELD_NUMOF];
+    int32_t sum = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        fvalue[TELEMETRY_TEMPERATURE] = _float_walk(temp, -50, 50);
+        fvalue[TELEMETRY_HUMIDITY] = _float_walk(hum, 0, 100);
+        fvalue[TELEMETRY_WIND_DIRECTION] = _float_walk(dir, 0, 360);
+        fvalue[TELEMETRY_WIND_INTENSITY] = _float_walk(inte, 0, 100);
+        fvalue[TELEMETRY_RAIN_HEIGHT] = _float_walk(rain, 0, 50);
+        for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+            sum += _to_centi(fvalue[f]);
+        }
+    }
+    sink = sum;
+    return 0;
+}
+
+/* the five readings the clients print per sample, with %.2f before the fixp
+ * module and with fixp_to_str() now, of the same sample; the bytes are the
+ * text of all five */
+static int bench_fmt_float(unsigned n)
+{
+    char buf[TELEMETRY_FIELD_NUMOF][FIXP_FMT_MAXLEN];
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        len = 0;
+        for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+            len += snprintf(buf[f], sizeof(buf[f]), "%.2f",
+                            (float)sample.value[f] / FIXP_SCALE);
+        }
+    }
+    return len;
+}
+#endif
+
+static int bench_fmt_fixp(unsigned n)
+{
+    char buf[TELEMETRY_FIELD_NUMOF][FIXP_FMT_MAXLEN];
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        len = 0;
+        for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+            len += fixp_to_str(buf[f], sample.value[f], 2);
+        }
+    }
+    return len;
+}
+
+/* payload of the MQTT-SN clients with fmt=json */
+static int bench_json(unsigned n)
+{
+    char buf[TELEMETRY_JSON_MAXLEN];
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        len = telemetry_json_encode(buf, sizeof(buf), &sample);
+    }
+    return len;
+}
+
+/* payload of the MQTT-SN clients with fmt=bin */
+static int bench_bin(unsigned n)
+{
+    uint8_t buf[TELEMETRY_BIN_MAXLEN];
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        len = telemetry_bin_encode(buf, sizeof(buf), &sample);
+    }
+    return len;
+}
+
+/* one full batch with fmt=delta, n counts samples */
+static int bench_delta(unsigned n)
+{
+    static telemetry_batch_t batch;
+    uint8_t buf[TELEMETRY_BATCH_MAX * TELEMETRY_DELTA_SAMPLE_MAXLEN];
+    int len = 0;
+
+    telemetry_batch_clear(&batch);
+    for (unsigned i = 0; i < TELEMETRY_BATCH_MAX; i++) {
+        _take_sample(&sample);
+        sample.ts += i * 5;
+        telemetry_batch_add(&batch, &sample);
+    }
+    for (unsigned i = 0; i < n; i += TELEMETRY_BATCH_MAX) {
+        len = telemetry_batch_delta_encode(buf, sizeof(buf), &batch);
+    }
+    /* per sample, like the other encoders */
+    return len / (int)TELEMETRY_BATCH_MAX;
+}
+
+/* sprintf payload of LoRaWAN_Nodes */
+static int _lora_nodes_payload(char *buf)
+{
+    return sprintf(buf, "{\"device\": \"%d\", \"temperature\": \"%d\", "
+                   "\"humidity\": \"%d\", \"windDirection\": \"%d\", "
+                   "\"windIntensity\": \"%d\", \"rainHeight\": \"%d\"}", 1,
+                   (int)fixp_to_int(sample.value[TELEMETRY_TEMPERATURE]),
+                   (int)fixp_to_int(sample.value[TELEMETRY_HUMIDITY]),
+                   (int)fixp_to_int(sample.value[TELEMETRY_WIND_DIRECTION]),
+                   (int)fixp_to_int(sample.value[TELEMETRY_WIND_INTENSITY]),
+                   (int)fixp_to_int(sample.value[TELEMETRY_RAIN_HEIGHT]));
+}
+
+static int bench_lora_nodes(unsigned n)
+{
+    char buf[200];
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        len = _lora_nodes_payload(buf);
+    }
+    return len;
+}
+
+/* sprintf payload of LoRaWAN_Sensors, hts221 values in tenths */
+static int bench_lora_sensors(unsigned n)
+{
+    char buf[64];
+    uint16_t humidity = 523;
+    int16_t temperature = 217;
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        len = sprintf(buf, "{\"humidity\": \"%u.%u\", \"temperature\": "
+                      "\"%u.%u\", \"device\": \"1\"}",
+                      (humidity / 10), (humidity % 10),
+                      (temperature / 10), (temperature % 10));
+    }
+    return len;
+}
+
+#ifdef BENCH_LORA
+static semtech_loramac_t loramac;
+
+/* ABP session of the benchmark, the stub radio has no network to join */
+static const uint8_t devaddr[LORAMAC_DEVADDR_LEN] = { 0x26, 0x01, 0x1B, 0x01 };
+static const uint8_t nwkskey[LORAMAC_NWKSKEY_LEN] = {
+    0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+    0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C
+};
+static const uint8_t appskey[LORAMAC_APPSKEY_LEN] = {
+    0x3C, 0x4F, 0xCF, 0x09, 0x88, 0x15, 0xF7, 0xAB,
+    0xA6, 0xD2, 0xAE, 0x28, 0x16, 0x15, 0x7E, 0x2B
+};
+
+/* semtech_loramac_send() of LoRaWAN_Nodes with the payload_lora_nodes
+ * payload, until the frame reaches the radio: MAC header, encryption, MIC
+ * and the radio setup. The receive windows after it take 2 s in EU868 and
+ * are left out. bytes is the PHY payload */
+static int bench_lora_send(unsigned n)
+{
+    char buf[200];
+    int len = _lora_nodes_payload(buf);
+
+    for (unsigned i = 0; i < n; i++) {
+        unsigned frames = sx127x_stub_sent();
+
+        switch (semtech_loramac_send(&loramac, (uint8_t *)buf, len)) {
+            case SEMTECH_LORAMAC_NOT_JOINED:
+            case SEMTECH_LORAMAC_DUTYCYCLE_RESTRICTED:
+            case SEMTECH_LORAMAC_BUSY:
+            case SEMTECH_LORAMAC_TX_ERROR:
+                puts("error: LoRaWAN send failed");
+                return 0;
+        }
+        /* wait for the receive windows, the MAC is busy until then */
+        if ((semtech_loramac_recv(&loramac) != SEMTECH_LORAMAC_TX_DONE) ||
+            (sx127x_stub_sent() == frames)) {
+            puts("error: LoRaWAN frame not sent");
+            return 0;
+        }
+        waited += xtimer_now_usec() - sx127x_stub_sent_at();
+    }
+    return sx127x_stub_sent_len();
+}
+#endif
+
+#ifdef BENCH_GW
+/* local port of emcute, the gateway listens on BENCH_GW_PORT */
+#define EMCUTE_PORT         (1883U)
+
+static char emcute_stack[THREAD_STACKSIZE_DEFAULT];
+static sock_udp_ep_t gw = { .family = AF_INET6, .port = BENCH_GW_PORT };
+
+static void *emcute_thread(void *arg)
+{
+    (void)arg;
+    emcute_run(EMCUTE_PORT, "bench");
+    return NULL;    /* should never be reached */
+}
+
+/* first lookup of a topic on a connection: a REGISTER round trip through
+ * the cache, the gateway hands out the same topic ID every time; bytes is
+ * the REGISTER */
+static int bench_topic_register(unsigned n)
+{
+    emcute_topic_t t;
+    unsigned flags = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        topic_cache_invalidate();
+        if (topic_cache_get(&t, &flags, "riot/bench") != EMCUTE_OK) {
+            puts("error: unable to register the topic");
+            return 0;
+        }
+    }
+    return 6 + strlen("riot/bench");
+}
+
+/* cached topic lookup, topic_register left the topic registered */
+static int bench_topic(unsigned n)
+{
+    emcute_topic_t t;
+    unsigned flags = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        topic_cache_get(&t, &flags, "riot/bench");
+    }
+    return 0;
+}
+
+static int _bench_pub(unsigned n, unsigned qos)
+{
+    emcute_topic_t t = { .name = PREDEF_TOPIC_TELEMETRY_BIN,
+                         .id = PREDEF_TOPIC_TELEMETRY_BIN_ID };
+    uint8_t buf[TELEMETRY_BIN_MAXLEN];
+    int len = telemetry_bin_encode(buf, sizeof(buf), &sample);
+
+    for (unsigned i = 0; i < n; i++) {
+        if (emcute_pub(&t, buf, len, qos | EMCUTE_TIT_PREDEF) != EMCUTE_OK) {
+            puts("error: publish failed");
+        }
+    }
+    /* PUBLISH header with a 2 byte topic ID and message ID */
+    return len + 7;
+}
+
+static int bench_pub_qos0(unsigned n)
+{
+    return _bench_pub(n, EMCUTE_QOS_0);
+}
+
+static int bench_pub_qos1(unsigned n)
+{
+    return _bench_pub(n, EMCUTE_QOS_1);
+}
+
+/* a sleeping node with a session: CONNECT, CONNACK, PUBLISH and DISCONNECT
+ * both ways for every reading, bytes of all five messages */
+static int bench_wake_qos0(unsigned n)
+{
+    emcute_topic_t t = { .name = PREDEF_TOPIC_TELEMETRY_BIN,
+                         .id = PREDEF_TOPIC_TELEMETRY_BIN_ID };
+    uint8_t buf[TELEMETRY_BIN_MAXLEN];
+    int len = telemetry_bin_encode(buf, sizeof(buf), &sample);
+
+    emcute_discon();
+    for (unsigned i = 0; i < n; i++) {
+        if ((emcute_con(&gw, true, NULL, NULL, 0, 0) != EMCUTE_OK) ||
+            (emcute_pub(&t, buf, len, EMCUTE_QOS_0 | EMCUTE_TIT_PREDEF) != EMCUTE_OK)) {
+            puts("error: publish failed");
+        }
+        emcute_discon();
+    }
+    return (6 + strlen("bench")) + 3 + (len + 7) + 2 + 2;
+}
+
+/* the loop before the publisher thread: JSON on the stack, emcute copies
+ * it into its transmit buffer */
+static int bench_pub_json_emcute(unsigned n)
+{
+    emcute_topic_t t = { .name = PREDEF_TOPIC_TELEMETRY_BIN,
+                         .id = PREDEF_TOPIC_TELEMETRY_BIN_ID };
+    char buf[TELEMETRY_JSON_MAXLEN];
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        len = telemetry_json_encode(buf, sizeof(buf), &sample);
+        if (emcute_pub(&t, buf, len, EMCUTE_QOS_0 | EMCUTE_TIT_PREDEF) != EMCUTE_OK) {
+            puts("error: publish failed");
+        }
+    }
+    return len + 7;
+}
+
+/* the same with QoS -1, qosm1_pub() copies it */
+static int bench_pub_json_qosm1(unsigned n)
+{
+    char buf[TELEMETRY_JSON_MAXLEN];
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        len = telemetry_json_encode(buf, sizeof(buf), &sample);
+        if (qosm1_pub(PREDEF_TOPIC_TELEMETRY_BIN, buf, len) != EMCUTE_OK) {
+            puts("error: QoS -1 publish failed");
+        }
+    }
+    return len + QOSM1_HDR_LEN;
+}
+
+/* encoded straight into the transmit buffer of qosm1, like the loop */
+static int bench_pub_json_inplace(unsigned n)
+{
+    int len = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        size_t room;
+        char *buf = qosm1_pub_begin(&room);
+        len = telemetry_json_encode(buf, room, &sample);
+        if (len < 0) {
+            /* begin took the transmit buffer, give it back */
+            qosm1_pub_abort();
+            puts("error: QoS -1 publish failed");
+            continue;
+        }
+        if (qosm1_pub_commit(PREDEF_TOPIC_TELEMETRY_BIN, len) != EMCUTE_OK) {
+            puts("error: QoS -1 publish failed");
+        }
+    }
+    return len + QOSM1_HDR_LEN;
+}
+
+/* the same reading as a single QoS -1 message */
+static int bench_wake_qosm1(unsigned n)
+{
+    uint8_t buf[TELEMETRY_BIN_MAXLEN];
+    int len = telemetry_bin_encode(buf, sizeof(buf), &sample);
+
+    for (unsigned i = 0; i < n; i++) {
+        if (qosm1_pub(PREDEF_TOPIC_TELEMETRY_BIN, buf, len) != EMCUTE_OK) {
+            puts("error: QoS -1 publish failed");
+        }
+    }
+    return len + QOSM1_HDR_LEN;
+}
+#endif
+
+static const bench_t benches[] = {
+    { "gen_next_value",     bench_gen,          BENCH_ITERATIONS, 0, -1 },
+#ifdef BENCH_FLOAT
+    { "gen_next_value_float", bench_gen_float,  BENCH_ITERATIONS, 0, -1 },
+#endif
+    { "fmt_fixp",           bench_fmt_fixp,     BENCH_ITERATIONS, 0, -1 },
+#ifdef BENCH_FLOAT
+    { "fmt_float",          bench_fmt_float,    BENCH_ITERATIONS, 0, -1 },
+#endif
+    { "payload_json",       bench_json,         BENCH_ITERATIONS, 0, -1 },
+    { "payload_bin",        bench_bin,          BENCH_ITERATIONS, 0, -1 },
+    { "payload_delta",      bench_delta,        BENCH_ITERATIONS, 0, -1 },
+    { "payload_lora_nodes", bench_lora_nodes,   BENCH_ITERATIONS, 0, -1 },
+    { "payload_lora_sensors", bench_lora_sensors, BENCH_ITERATIONS, 0, -1 },
+#ifdef BENCH_LORA
+    { "lora_send",          bench_lora_send,    BENCH_ITERATIONS / 2000, 0, -1 },
+#endif
+#ifdef BENCH_GW
+    { "topic_register",     bench_topic_register, BENCH_ITERATIONS / 100, 0, -1 },
+    { "topic_cached",       bench_topic,        BENCH_ITERATIONS, 0, -1 },
+    { "pub_qos0",           bench_pub_qos0,     BENCH_ITERATIONS / 10, 0, 1 },
+    { "pub_qos1",           bench_pub_qos1,     BENCH_ITERATIONS / 100, 0, 1 },
+    { "pub_json_emcute",    bench_pub_json_emcute, BENCH_ITERATIONS / 10, 0, 1 },
+    { "pub_json_qosm1",     bench_pub_json_qosm1, BENCH_ITERATIONS / 10, 0, 1 },
+    { "pub_json_inplace",   bench_pub_json_inplace, BENCH_ITERATIONS / 10, 0, 0 },
+    { "wake_qosm1",         bench_wake_qosm1,   BENCH_ITERATIONS / 10, 1, 1 },
+    /* last, it leaves emcute disconnected */
+    { "wake_qos0",          bench_wake_qos0,    BENCH_ITERATIONS / 100, 5, 1 },
+#endif
+};
+
+static const bench_t *current;
+static uint32_t elapsed;    /* usec */
+static int bytes;
+
+static void *bench_thread(void *arg)
+{
+    (void)arg;
+
+    waited = 0;
+    uint32_t start = xtimer_now_usec();
+    bytes = current->run(current->n);
+    elapsed = xtimer_now_usec() - start - waited;
+
+    mutex_unlock(&done);
+    return NULL;
+}
+
+static void _run(const bench_t *b)
+{
+    current = b;
+    thread_create(bench_stack, sizeof(bench_stack), THREAD_PRIORITY_MAIN - 1,
+                  THREAD_CREATE_STACKTEST, bench_thread, NULL, "bench");
+    mutex_lock(&done);
+
+    unsigned ns = (unsigned)(((uint64_t)elapsed * 1000) / b->n);
+    unsigned stack = sizeof(bench_stack) - thread_measure_stack_free(bench_stack);
+
+    printf("%-22s %8u %10u %8d %8u\n", b->name, b->n, ns, bytes, stack);
+    printf("{\"bench\": \"%s\", \"ops\": %u, \"ns_per_op\": %u, "
+           "\"bytes\": %d, \"stack\": %u", b->name, b->n, ns, bytes, stack);
+    if (b->copies >= 0) {
+        printf(", \"copies\": %d", b->copies);
+    }
+    puts("}");
+
+    if (b->packets > 0) {
+        /* sending every byte, listening for as long as the op took */
+        unsigned air = bytes + (b->packets * BENCH_FRAME_OVERHEAD);
+        unsigned uj = ((air * BENCH_RADIO_NJ_PER_BYTE) +
+                       ((ns / 1000) * BENCH_RADIO_LISTEN_NJ_PER_US)) / 1000;
+        printf("{\"energy\": \"%s\", \"packets\": %u, \"bytes_on_air\": %u, "
+               "\"uj\": %u}\n", b->name, b->packets, air, uj);
+    }
+}
+
+int main(void)
+{
+    puts("Firmware benchmarks\n");
+
+#ifdef BENCH_GW
+    thread_create(emcute_stack, sizeof(emcute_stack), THREAD_PRIORITY_MAIN - 1,
+                  0, emcute_thread, NULL, "emcute");
+    /* give the interface time for its addresses */
+    xtimer_sleep(2);
+    ipv6_addr_from_str((ipv6_addr_t *)&gw.addr.ipv6, BENCH_GW);
+    if (emcute_con(&gw, true, NULL, NULL, 0, 0) != EMCUTE_OK) {
+        printf("error: unable to connect to [%s]:%u\n", BENCH_GW, BENCH_GW_PORT);
+        pm_off();
+    }
+    qosm1_set_gateway(&gw);
+#endif
+#ifdef BENCH_LORA
+    semtech_loramac_init(&loramac);
+    semtech_loramac_set_dr(&loramac, 5);
+    semtech_loramac_set_devaddr(&loramac, devaddr);
+    semtech_loramac_set_nwkskey(&loramac, nwkskey);
+    semtech_loramac_set_appskey(&loramac, appskey);
+    if (semtech_loramac_join(&loramac, LORAMAC_JOIN_ABP) !=
+        SEMTECH_LORAMAC_JOIN_SUCCEEDED) {
+        puts("error: ABP join failed");
+        pm_off();
+    }
+#endif
+
+    _take_sample(&sample);
+    printf("%-22s %8s %10s %8s %8s\n", "benchmark", "ops", "ns/op", "bytes",
+           "stack");
+    for (unsigned i = 0; i < (sizeof(benches) / sizeof(benches[0])); i++) {
+        _run(&benches[i]);
+    }
+
+#ifdef BENCH_GW
+    emcute_discon();
+#endif
+    /* ends the native process, make bench waits for it */
+    pm_off();
+    return 0;
+}
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+# Counts the REGISTER frames behind repeated publishes: one per topic and
+# connection, none for a predefined topic. Needs the tap bridge described in
+# dist/pythonlibs/mqttsn_fakegw.py.
+
+import os
+import sys
+
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'dist',
+                             'pythonlibs'))
+from mqttsn_fakegw import PUBLISH, REGISTER, FakeGateway, node_ifconfig  # noqa
+
+PUBS = 5
+PREDEFINED = 'riot/telemetry/bin'
+
+
+def connect(child, gw):
+    child.sendline('con {} {}'.format(gw.addr, gw.port))
+    child.expect_exact('Successfully connected to gateway')
+
+
+def publish(child, topic, n):
+    for i in range(n):
+        child.sendline('pub {} {}'.format(topic, i))
+        child.expect(r"Published \d+ bytes to topic '{} \[(\d+)\]'"
+                     .format(topic))
+    return int(child.match.group(1))
+
+
+def testfunc(child):
+    gw = FakeGateway().start()
+    node_ifconfig(child)
+    connect(child, gw)
+
+    # a plain topic is registered by the first publish only
+    tid = publish(child, 'riot/a', PUBS)
+    publish(child, 'riot/b', PUBS)
+    assert gw.wait_for(lambda: gw.counts[PUBLISH] == 2 * PUBS)
+    assert gw.count(REGISTER) == 2
+    assert all(p[1] == tid for p in gw.published[:PUBS])
+
+    # a predefined topic never is
+    assert publish(child, PREDEFINED, PUBS) == 3
+    assert gw.wait_for(lambda: gw.counts[PUBLISH] == 3 * PUBS)
+    assert gw.count(REGISTER) == 2
+
+    # the cached IDs belong to the connection, a new one registers again
+    child.sendline('discon')
+    child.expect_exact('Disconnect successful')
+    connect(child, gw)
+    publish(child, 'riot/a', PUBS)
+    publish(child, PREDEFINED, PUBS)
+    assert gw.wait_for(lambda: gw.counts[PUBLISH] == 5 * PUBS)
+    assert gw.count(REGISTER) == 3
+
+    # the node counts the same
+    child.sendline('stats')
+    child.expect(r'topic cache: (\d+) predefined, (\d+) hits, '
+                 r'(\d+) registrations')
+    assert int(child.match.group(1)) == 2 * PUBS
+    assert int(child.match.group(2)) == 3 * (PUBS - 1)
+    assert int(child.match.group(3)) == 3
+    gw.stop()
+    print('{} publishes, {} REGISTER frames'.format(5 * PUBS,
+                                                  gw.count(REGISTER)))
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
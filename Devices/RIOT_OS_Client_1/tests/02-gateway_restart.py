@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+# Kills the gateway under a running QoS 1 loop, once publishing with emcute
+# and once through the PUBACK window of pubwin: the loop keeps the samples,
+# reconnects once the gateway is back and replays them, so every sample
+# taken arrives exactly once. Needs the tap bridge described in
+# dist/pythonlibs/mqttsn_fakegw.py.
+
+import os
+import sys
+import time
+
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'dist',
+                             'pythonlibs'))
+from mqttsn_fakegw import CONNECT, FakeGateway, node_ifconfig  # noqa
+
+TOPIC = 'riot/telemetry/bin'
+DOWN = 8                # seconds without a gateway
+HDR_LEN = 7             # binary telemetry record, see telemetry.h
+
+
+def records(payload):
+    """(device, timestamp) of every binary record in a payload."""
+    res = []
+    while payload:
+        length = HDR_LEN + 2 * bin(payload[6]).count('1')
+        res.append((payload[1], int.from_bytes(payload[2:6], 'big')))
+        payload = payload[length:]
+    return res
+
+
+def restart(child, gw, opts):
+    """Kills the gateway under a loop started with opts, returns the number
+    of samples taken and replayed."""
+    gw.reset()
+    child.sendline('loop start {} 1 fmt=bin period=1 {}'.format(TOPIC, opts))
+    child.expect_exact('loop started')
+    assert gw.wait_for(lambda: len(gw.published) >= 3)
+
+    gw.stop()
+    # pubwin gives up after PUBWIN_N_RETRY retransmissions
+    child.expect_exact('gateway lost, keeping samples', timeout=30)
+    time.sleep(DOWN)
+    gw.start()
+
+    child.expect(r'reconnected to the gateway, (\d+) samples to replay',
+                 timeout=90)
+    assert int(child.match.group(1)) >= DOWN
+    child.expect(r'backlog replayed, (\d+) samples in total, 0 discarded',
+                 timeout=30)
+
+    child.sendline('loop stop')
+    child.expect_exact('loop stopped')
+    time.sleep(2)
+    child.sendline('loop status')
+    child.expect(r'sampled (\d+),')
+    sampled = int(child.match.group(1))
+    child.expect(r'gateway online, backlog 0/\d+, \d+ buffered, '
+                 r'(\d+) replayed, 0 discarded, 0 dropped')
+    replayed = int(child.match.group(1))
+
+    samples = [r for p in gw.published for r in records(p[3])]
+    assert len(samples) == sampled, (len(samples), sampled)
+    assert len(set(samples)) == len(samples)
+    print('{}: {} samples, {} of them replayed after {} s without gateway'
+          .format(opts or 'emcute', sampled, replayed, DOWN))
+
+
+def testfunc(child):
+    gw = FakeGateway().start()
+    node_ifconfig(child)
+    child.sendline('con {} {}'.format(gw.addr, gw.port))
+    child.expect_exact('Successfully connected to gateway')
+
+    restart(child, gw, '')
+    assert gw.count(CONNECT) == 1
+    # the messages in the window when the gateway goes away are kept too
+    restart(child, gw, 'window=4')
+    gw.stop()
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
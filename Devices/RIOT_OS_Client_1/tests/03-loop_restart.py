@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+# Stops and starts the loop: a start with a bad option leaves the
+# parameters of the last run alone, and a stopped loop neither reconnects
+# nor replays until it is started again. Needs the tap bridge described in
+# dist/pythonlibs/mqttsn_fakegw.py.
+
+import os
+import sys
+
+import pexpect
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'dist',
+                             'pythonlibs'))
+from mqttsn_fakegw import FakeGateway, node_ifconfig  # noqa
+
+TOPIC = 'riot/telemetry/bin'
+STATUS = (r'loop stopped on riot/telemetry/bin, bin, period 1s, batch 1, '
+          r'maxage 0s, window 0, flags 0x20')
+
+
+def testfunc(child):
+    gw = FakeGateway().start()
+    node_ifconfig(child)
+    child.sendline('con {} {}'.format(gw.addr, gw.port))
+    child.expect_exact('Successfully connected to gateway')
+
+    child.sendline('loop start {} 1 fmt=bin period=1 db=all:0'.format(TOPIC))
+    child.expect_exact('loop started')
+    assert gw.wait_for(lambda: len(gw.published) >= 2)
+    child.sendline('loop stop')
+    child.expect_exact('loop stopped')
+
+    # the options are checked one after the other, the topic and db= come
+    # before the bad one
+    for opts in ('riot/other fmt=json db=all:5 period=0',
+                 'riot/other batch=2 window=9',
+                 'riot/other db=none'):
+        child.sendline('loop start ' + opts)
+        child.expect(r'error: \S+')
+        child.sendline('loop status')
+        child.expect(STATUS)
+        child.expect_exact('deadband: ')
+
+    # offline when stopped: no reconnect until the next start
+    child.sendline('loop start {} 1 fmt=bin period=1'.format(TOPIC))
+    child.expect_exact('loop started')
+    gw.stop()
+    child.expect_exact('gateway lost, keeping samples', timeout=30)
+    child.sendline('loop stop')
+    child.expect_exact('loop stopped')
+    gw.start()
+    assert child.expect([r'reconnect', pexpect.TIMEOUT], timeout=8) == 1
+    child.sendline('loop status')
+    child.expect(r'gateway offline, backlog [1-9]\d*/')
+
+    child.sendline('loop start {} 1 fmt=bin period=1'.format(TOPIC))
+    child.expect_exact('loop started')
+    child.expect(r'backlog replayed, \d+ samples in total, 0 discarded',
+                 timeout=30)
+    child.sendline('loop stop')
+    child.expect_exact('loop stopped')
+    gw.stop()
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
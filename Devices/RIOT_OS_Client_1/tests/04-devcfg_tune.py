@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+# Sends a config to the running loop: devcfg acknowledges the new values,
+# the publisher applies them and the messages at the gateway follow the new
+# batch size. A config before loop start is rejected. Needs the tap bridge described in
+# dist/pythonlibs/mqttsn_fakegw.py.
+
+import os
+import sys
+
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'dist',
+                             'pythonlibs'))
+from mqttsn_fakegw import FakeGateway, node_ifconfig  # noqa
+
+CLIENT_ID = 'edward'
+TOPIC = 'riot/telemetry/bin'
+HDR_LEN = 7             # binary telemetry record, see telemetry.h
+
+
+def numof(payload):
+    """Number of binary records in a payload."""
+    n = 0
+    while payload:
+        payload = payload[HDR_LEN + 2 * bin(payload[6]).count('1'):]
+        n += 1
+    return n
+
+
+def testfunc(child):
+    gw = FakeGateway().start()
+    node_ifconfig(child)
+    child.sendline('con {} {}'.format(gw.addr, gw.port))
+    child.expect_exact('Successfully connected to gateway')
+
+    # devcfg listens from the connection on, but there is no loop to tune
+    # yet and loop start would drop the values anyway
+    gw.queue(CLIENT_ID, 'riot/{}/config'.format(CLIENT_ID), b'{"batch": 3}')
+    child.expect_exact('{"cfg": "rejected", "cfg_error": -11}')
+
+    child.sendline('loop start {} 1 fmt=bin period=1'.format(TOPIC))
+    child.expect_exact('loop started')
+    assert gw.wait_for(lambda: len(gw.published) >= 2)
+
+    gw.queue(CLIENT_ID, 'riot/{}/config'.format(CLIENT_ID),
+             b'{"period": 2, "batch": 3}')
+    child.expect_exact('{"period": 2, "batch": 3, "qos": 1, "cfg": "ok"}')
+    child.sendline('loop status')
+    child.expect(r'loop running on \S+, bin, period 2s, batch 3, ')
+
+    # the batch in progress may still be cut short by the old size
+    gw.reset()
+    assert gw.wait_for(lambda: len(gw.published) >= 3, timeout=30)
+    with gw.lock:
+        sizes = [numof(p[3]) for p in gw.published if p[1] == 3]
+    assert sizes[1:3] == [3, 3], sizes
+
+    # a rejected config changes nothing
+    gw.queue(CLIENT_ID, 'riot/{}/config'.format(CLIENT_ID),
+             b'{"batch": 999}')
+    child.expect_exact('"cfg": "rejected"')
+    child.sendline('loop status')
+    child.expect(r'period 2s, batch 3, ')
+
+    child.sendline('loop stop')
+    child.expect_exact('loop stopped')
+    gw.stop()
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
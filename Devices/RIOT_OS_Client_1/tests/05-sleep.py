@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+# Runs the loop in a sleeping session against the scripted gateway: every
+# message is a CONNECT, PUBLISH and DISCONNECT with a duration, a config
+# kept by the gateway while the node sleeps arrives with the next wake up,
+# also after a gateway restart lost the subscription, and a node held back
+# by its deadband polls with PINGREQ before the sleep duration runs out.
+# 06-sleep_paho.py runs the same cycle against the Paho gateway. Needs the
+# tap bridge described in dist/pythonlibs/mqttsn_fakegw.py.
+
+import os
+import sys
+import time
+
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'dist',
+                             'pythonlibs'))
+from mqttsn_fakegw import (FakeGateway, node_ifconfig,  # noqa
+                           CONNECT, DISCONNECT, PINGREQ, SUBSCRIBE)
+
+CLIENT_ID = 'edward'
+TOPIC = 'riot/telemetry/bin'
+RUN = 30                # seconds between the two readings
+MARGIN = 5              # SENSOR_LOOP_SLEEP_MARGIN
+
+
+def connect(child, gw):
+    child.sendline('con {} {}'.format(gw.addr, gw.port))
+    child.expect_exact('Successfully connected to gateway')
+
+
+def radio(child):
+    child.sendline('loop status')
+    child.expect(r'sleep: radio on (\d+) ms in (\d+) s, (\d+) ms per hour '
+                 r'\((\d+\.\d+)% of always on\), (\d+) wakes, (\d+) sleeps, '
+                 r'(\d+) polls, (\d+) downlink')
+    return [int(g) for i, g in enumerate(child.match.groups()) if i != 3]
+
+
+def per_hour(before, after, what):
+    """Radio-on ms per hour between two readings."""
+    ms = (after[0] - before[0]) * 3600 // (after[1] - before[1])
+    print('{}: radio on {} ms in {} s, {} ms per hour ({:.2f}% of always '
+          'on)'.format(what, after[0] - before[0], after[1] - before[1], ms,
+                       ms / 36000))
+    return ms
+
+
+def testfunc(child):
+    gw = FakeGateway().start()
+    node_ifconfig(child)
+    connect(child, gw)
+
+    # a message every 2 s, the node sleeps for 2 + MARGIN s after each
+    child.sendline('loop start {} 1 fmt=bin period=1 batch=2 sleep'
+                   .format(TOPIC))
+    child.expect_exact('loop started')
+    gw.reset()
+    assert gw.wait_for(lambda: gw.counts[DISCONNECT] >= 3, timeout=20)
+    with gw.lock:
+        assert gw.counts[CONNECT] >= 3, gw.counts
+        assert len(gw.published) >= 3, gw.published
+
+    # queued while the node sleeps, delivered after its next CONNECT
+    gw.queue(CLIENT_ID, 'riot/{}/config'.format(CLIENT_ID), b'{"batch": 4}')
+    child.expect_exact('"cfg": "ok"', timeout=15)
+
+    before = radio(child)
+    time.sleep(RUN)
+    after = radio(child)
+    wakes, sleeps, polls, downlink = after[3:]
+    assert wakes >= before[3] + RUN // 4 - 1, (before, after)
+    assert sleeps >= before[4] + RUN // 4 - 1, (before, after)
+    assert downlink == 1, downlink
+    # awake only for the exchanges, far from the 3600000 ms of always on
+    assert per_hour(before, after, 'batch every 4 s') < 3600000 // 10
+
+    # restarted while the node sleeps, the gateway accepts the next CONNECT
+    # but has no subscription left until the node subscribes again
+    gw.stop()
+    gw.start()
+    gw.reset()
+    assert gw.wait_for(lambda: gw.counts[SUBSCRIBE] >= 1, timeout=15)
+    gw.queue(CLIENT_ID, 'riot/{}/config'.format(CLIENT_ID), b'{"batch": 2}')
+    child.expect_exact('"batch": 2, "qos": 1, "cfg": "ok"', timeout=15)
+    # the sleeping session has no QoS 2
+    gw.queue(CLIENT_ID, 'riot/{}/config'.format(CLIENT_ID), b'{"qos": 2}')
+    child.expect_exact('{"cfg": "rejected", "cfg_error": -22}', timeout=15)
+    child.sendline('loop status')
+    child.expect(r'batch 2, maxage \d+s, window 0, flags 0x20')
+    child.sendline('loop stop')
+    child.expect_exact('sleeping session closed')
+
+    # nothing passes the deadband after the first sample, so the node has
+    # to show up with PINGREQ before the gateway gives up on it
+    connect(child, gw)
+    child.sendline('loop start {} 1 fmt=bin period=1 batch=1 sleep '
+                   'db=all:100000'.format(TOPIC))
+    child.expect_exact('loop started')
+    gw.reset()
+    assert gw.wait_for(lambda: gw.counts[PINGREQ] >= 2,
+                       timeout=3 * (1 + MARGIN))
+    with gw.lock:
+        assert len(gw.published) == 1, gw.published
+    before = radio(child)
+    time.sleep(RUN)
+    after = radio(child)
+    assert after[5] >= before[5] + RUN // MARGIN - 1, (before, after)
+    assert after[3] == before[3], (before, after)
+    assert per_hour(before, after, 'PINGREQ every 5 s') < 3600000 // 10
+    child.sendline('loop stop')
+    child.expect_exact('sleeping session closed')
+    gw.stop()
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+# Runs the sleep cycle of 05-sleep.py against the Paho gateway of
+# Gateway/MQTT-SNGateway instead of the scripted one: CONNECT, PUBLISH and
+# DISCONNECT with a duration per message, a config published to the broker
+# while the node sleeps, taken at the next CONNECT or at a PINGREQ, and the
+# radio-on time per hour between two `loop status` readings. Only runs with
+# PAHO_GW set, see dist/pythonlibs/paho_gateway.py.
+
+import os
+import sys
+import time
+
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'dist',
+                             'pythonlibs'))
+from mqttsn_fakegw import node_ifconfig  # noqa
+import paho_gateway  # noqa
+
+CLIENT_ID = 'edward'
+TOPIC = 'riot/telemetry/bin'
+CONFIG = 'riot/{}/config'.format(CLIENT_ID)
+RUN = 60                # seconds between the two readings
+MARGIN = 5              # SENSOR_LOOP_SLEEP_MARGIN
+T_RETRY = 2             # SLEEPCL_T_RETRY
+
+
+def radio(child):
+    child.sendline('loop status')
+    child.expect(r'gateway (\w+),')
+    assert child.match.group(1) == 'online'
+    child.expect(r'sleep: radio on (\d+) ms in (\d+) s, \d+ ms per hour '
+                 r'\(\d+\.\d+% of always on\), (\d+) wakes, (\d+) sleeps, '
+                 r'(\d+) polls, (\d+) downlink')
+    return [int(g) for g in child.match.groups()]
+
+
+def per_hour(before, after, what):
+    """Radio-on ms per hour between two readings."""
+    ms = (after[0] - before[0]) * 3600 // (after[1] - before[1])
+    print('{}: radio on {} ms in {} s, {} ms per hour ({:.2f}% of always '
+          'on)'.format(what, after[0] - before[0], after[1] - before[1], ms,
+                       ms / 36000))
+    return ms
+
+
+def start(child, options):
+    child.sendline('con {} {}'.format(paho_gateway.PAHO_GW,
+                                      paho_gateway.PAHO_PORT))
+    child.expect_exact('Successfully connected to gateway')
+    child.sendline('loop start {} 1 fmt=bin period=1 {} sleep'
+                   .format(TOPIC, options))
+    child.expect_exact('loop started')
+
+
+def stop(child):
+    child.sendline('loop stop')
+    child.expect_exact('sleeping session closed')
+    child.expect_exact('loop stopped')
+
+
+def testfunc(child):
+    if not paho_gateway.enabled():
+        return
+    node_ifconfig(child)
+
+    # a message every 2 s, the node sleeps for 2 + MARGIN s after each
+    start(child, 'batch=2')
+    for _ in range(3):
+        child.expect_exact("while awake", timeout=10)
+
+    # Paho keeps it for the sleeping node and sends it after the CONNECT
+    # of the next message
+    time.sleep(0.5)
+    paho_gateway.mqtt_publish(CONFIG, b'{"batch": 4}')
+    child.expect_exact('"batch": 4, "qos": 1, "cfg": "ok"', timeout=15)
+
+    before = radio(child)
+    time.sleep(RUN)
+    after = radio(child)
+    assert after[2] - before[2] >= RUN // 4 - 1, (before, after)
+    assert after[5] == 1, after
+    wake = (after[0] - before[0]) / (after[2] - before[2])
+    print('{:.1f} ms radio on per wake-up'.format(wake))
+    assert per_hour(before, after, 'batch every 4 s') < 3600000 // 10
+    stop(child)
+
+    # nothing passes the deadband after the first sample, the node only
+    # shows up with PINGREQ, which also fetches what Paho kept for it
+    start(child, 'batch=1 db=all:100000')
+    child.expect_exact("while awake", timeout=10)
+    before = radio(child)
+    paho_gateway.mqtt_publish(CONFIG, b'{"period": 2}')
+    child.expect_exact('"period": 2, "batch": 1, "qos": 1, "cfg": "ok"',
+                       timeout=2 * (1 + MARGIN))
+    time.sleep(RUN)
+    after = radio(child)
+    assert after[2] == before[2], (before, after)
+    polls = after[4] - before[4]
+    assert polls >= RUN // (2 + MARGIN), (before, after)
+    print('{:.1f} ms radio on per PINGREQ'.format(
+        (after[0] - before[0]) / polls))
+    # Paho holds the PINGRESP of the poll that took the config until the
+    # next PINGREQ, the node must not wait for the retry timer to send it
+    assert after[0] - before[0] < T_RETRY * 1000, (before, after)
+    assert per_hour(before, after, 'PINGREQ polls') < 3600000 // 10
+    stop(child)
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
@@ -29,6 +29,15 @@
 #include "msg.h"
 #include "net/emcute.h"
 #include "net/ipv6/addr.h"
+#include "topic_cache.h"
+#include "perf.h"
+#include "devcfg.h"
+#include "pubstats.h"
+#include "subreg.h"
+#include "qosm1.h"
+#include "telemetry.h"
+#include "fixp.h"
+#include "sensor_loop.h"
 #include "xtimer.h"
 
 #define EMCUTE_PORT         (1883U)
@@ -38,7 +47,6 @@
 #endif
 #define EMCUTE_PRIO         (THREAD_PRIORITY_MAIN - 1)
 
-#define NUMOFSUBS           (16U)
 #define TOPIC_MAXLEN        (64U)
 
 int generate_random_temp(void) { //this will generate random number in range l and r
@@ -90,21 +98,42 @@ int generate_random_rain(void) { //this will generate random number in range l a
     return rand_num;
 }
 
-float genNextValue(int prevValue, int min, int max){
-    float value = prevValue + ((max - min) * (((rand() % 11) - 5))) * 0.003;
-    if(value > max) value=max;
-    else if (value < min) value=min;
-    else value=value;
+fixp_t genNextValue(int prevValue, int min, int max){
+    return fixp_random_walk(fixp_from_int(prevValue), min, max);
+}
+
+//start values of the simulated sensors, set in main
+static int temp, hum, dir, inte, rain;
+static const int device = 2;
 
-    return value;
+static void take_sample(telemetry_sample_t *s) //called by the sampler thread of the loop command
+{
+    //generating new values
+    fixp_t new_temp = genNextValue(temp, -50, 50);
+    fixp_t new_hum = genNextValue(hum, 0, 100);
+    fixp_t new_dir = genNextValue(dir, 0, 360);
+    fixp_t new_inte = genNextValue(inte, 0, 100);
+    fixp_t new_rain = genNextValue(rain, 0, 50);
+    char str[5][FIXP_FMT_MAXLEN];
+    fixp_to_str(str[0], new_temp, 2);
+    fixp_to_str(str[1], new_hum, 2);
+    fixp_to_str(str[2], new_dir, 2);
+    fixp_to_str(str[3], new_inte, 2);
+    fixp_to_str(str[4], new_rain, 2);
+    printf("%s° \t%s%% \t%s° \t%sm/s \t%smm/h \n",
+           str[0], str[1], str[2], str[3], str[4]);
+
+    telemetry_sample_init(s, device, (uint32_t)time(NULL));
+    telemetry_sample_set(s, TELEMETRY_TEMPERATURE, new_temp);
+    telemetry_sample_set(s, TELEMETRY_HUMIDITY, new_hum);
+    telemetry_sample_set(s, TELEMETRY_WIND_DIRECTION, new_dir);
+    telemetry_sample_set(s, TELEMETRY_WIND_INTENSITY, new_inte);
+    telemetry_sample_set(s, TELEMETRY_RAIN_HEIGHT, new_rain);
 }
 
 static char stack[THREAD_STACKSIZE_DEFAULT];
 static msg_t queue[8];
 
-static emcute_sub_t subscriptions[NUMOFSUBS];
-static char topics[NUMOFSUBS][TOPIC_MAXLEN];
-
 static void *emcute_thread(void *arg)
 {
     (void)arg;
@@ -112,16 +141,12 @@ static void *emcute_thread(void *arg)
     return NULL;    /* should never be reached */
 }
 
-static void on_pub(const emcute_topic_t *topic, void *data, size_t len)
+static void on_pub(const char *topic, const void *data, size_t len, void *arg)
 {
-    char *in = (char *)data;
+    (void)arg;
 
-    printf("### got publication for topic '%s' [%i] ###\n",
-           topic->name, (int)topic->id);
-    for (size_t i = 0; i < len; i++) {
-        printf("%c", in[i]);
-    }
-    puts("");
+    printf("### got publication for topic '%s' ###\n", topic);
+    printf("%.*s\n", (int)len, (const char *)data);
 }
 
 static unsigned get_qos(const char *str)
@@ -162,12 +187,19 @@ static int cmd_con(int argc, char **argv) //shell command for connection
         len = strlen(message);
     }
 
+    /* topic IDs registered on a previous connection are no longer valid */
+    topic_cache_invalidate();
+
     if (emcute_con(&gw, true, topic, message, len, 0) != EMCUTE_OK) {
         printf("error: unable to connect to [%s]:%i\n", argv[1], (int)gw.port);
         return 1;
     }
     printf("Successfully connected to gateway at [%s]:%i\n",
            argv[1], (int)gw.port);
+    sensor_loop_set_gateway(&gw, EMCUTE_ID);
+    if (devcfg_start(EMCUTE_ID) != 0) {
+        puts("warning: unable to subscribe to the config topic");
+    }
 
     return 0;
 }
@@ -177,7 +209,11 @@ static int cmd_discon(int argc, char **argv) //shell command for disconnection
     (void)argc;
     (void)argv;
 
+    /* the gateway has to confirm the unsubscribe */
+    devcfg_stop();
     int res = emcute_discon();
+    topic_cache_invalidate();
+    sensor_loop_set_gateway(NULL, NULL);
     if (res == EMCUTE_NOGW) {
         puts("error: not connected to any broker");
         return 1;
@@ -190,117 +226,67 @@ static int cmd_discon(int argc, char **argv) //shell command for disconnection
     return 0;
 }
 
-static int cmd_pub(int argc, char **argv) //shell command to publish
+/* no CONNECT and no REGISTER, the gateway is set with the qosm1 command */
+static int pub_qosm1(const char *topic, const char *data)
 {
-    emcute_topic_t t;
-    unsigned flags = EMCUTE_QOS_0;
-
-    if (argc < 3) {
-        printf("usage: %s <topic name> <data> [QoS level]\n", argv[0]);
+    uint32_t start = xtimer_now_usec();
+    int res = qosm1_pub(topic, data, strlen(data));
+    pubstats_record(PUBSTATS_PUBLISH, topic, strlen(data),
+                    xtimer_now_usec() - start, res);
+    if (res == EMCUTE_NOTSUP) {
+        puts("error: QoS -1 needs a predefined topic or a short topic name");
         return 1;
     }
-
-    /* parse QoS level */
-    if (argc >= 4) {
-        flags |= get_qos(argv[3]);
-    }
-
-    printf("pub with topic: %s and name %s and flags 0x%02x\n", argv[1], argv[2], (int)flags);
-
-    /* step 1: get topic id */
-    t.name = argv[1];
-    if (emcute_reg(&t) != EMCUTE_OK) {
-        puts("error: unable to obtain topic ID");
+    if (res != EMCUTE_OK) {
+        printf("error: unable to send QoS -1 message to '%s' (%i)\n", topic, res);
         return 1;
     }
 
-    /* step 2: publish data */
-    if (emcute_pub(&t, argv[2], strlen(argv[2]), flags) != EMCUTE_OK) {
-        printf("error: unable to publish data to topic '%s [%i]'\n",
-                t.name, (int)t.id);
-        return 1;
-    }
-
-    printf("Published %i bytes to topic '%s [%i]'\n",
-            (int)strlen(argv[2]), t.name, t.id);
-
+    printf("Sent %i bytes to topic '%s' with QoS -1\n", (int)strlen(data), topic);
     return 0;
 }
 
-static int cmd_loop(int argc, char **argv)  /*argv[0] = command, argv[1] = topic, argv[2] = data, argv[3] = flags, the new function to start looping data*/
+static int cmd_pub(int argc, char **argv) //shell command to publish
 {
     emcute_topic_t t;
     unsigned flags = EMCUTE_QOS_0;
 
-    srand(time(0));
+    if (argc < 3) {
+        printf("usage: %s <topic name> <data> [QoS level]\n", argv[0]);
+        return 1;
+    }
 
-    //int temperature = random_temp();
-
-    //printf("%d", temperature);
-
-    int temp = generate_random_temp();
-    int hum = generate_random_hum();
-    int dir = generate_random_dir();
-    int inte = generate_random_int();
-    int rain = generate_random_rain();
-    int device = 2;
-    //printf("%d° ", temp);
-    //printf("%d%% ", hum);
-    //printf("%d° ", dir);
-    //printf("%dm/s ", inte);
-    //printf("%dmm/h ", rain);
-
-    while (true)
-    {
-        float new_temp = genNextValue(temp, -50, 50);
-        float new_hum = genNextValue(hum, 0, 100);
-        float new_dir = genNextValue(dir, 0, 360);
-        float new_inte = genNextValue(inte, 0, 100);
-        float new_rain = genNextValue(rain, 0, 50);
-        unsigned long long int ts = ((unsigned long long)time(NULL)) * 1000;
-        printf("%.2f° \t", new_temp);
-        printf("%.2f%% \t", new_hum);
-        printf("%.2f° \t", new_dir);
-        printf("%.2fm/s \t", new_inte);
-        printf("%.2fmm/h \n", new_rain);
-
-        char argomento[200]; //put values in the argomento variable so we can pass it later in the publish
-        sprintf(argomento, "{\"ts\": %llu, \"values\":{\"device\": \"%d\",\"temperature\": \"%.2f\", \"humidity\": \"%.2f\", \"windDirection\": \"%.2f\", \"windIntensity\": \"%.2f\", \"rainHeight\": \"%.2f\"}}", ts, device, new_temp, new_hum, new_dir, new_inte, new_rain);
-
-
-    
-
-//    if (argc < 3) {
-//        printf("usage: %s <topic name> <data> [QoS level]\n", argv[0]);
-//        return 1;
-//    }
-
-    /* parse QoS level */
+    /* parse QoS level, -1 is sent by the qosm1 module */
     if (argc >= 4) {
-        flags |= get_qos(argv[3]);
+        flags |= (atoi(argv[3]) == -1) ? QOSM1_QOS : get_qos(argv[3]);
     }
 
-    printf("pub with topic: %s and name %s and flags 0x%02x\n", argv[1], argomento/*file valori casuali*/, (int)flags);
+    printf("pub with topic: %s and name %s and flags 0x%02x\n", argv[1], argv[2], (int)flags);
+
+    if ((argc >= 4) && (atoi(argv[3]) == -1)) {
+        return pub_qosm1(argv[1], argv[2]);
+    }
 
-    /* step 1: get topic id */
-    t.name = argv[1];
-    if (emcute_reg(&t) != EMCUTE_OK) {
+    /* step 1: get topic id, only registered once per connection */
+    if (topic_cache_get(&t, &flags, argv[1]) != EMCUTE_OK) {
         puts("error: unable to obtain topic ID");
         return 1;
     }
 
     /* step 2: publish data */
-    if (emcute_pub(&t, argomento, strlen(argomento), flags) != EMCUTE_OK) { //actual publish of argomento
+    uint32_t start = xtimer_now_usec();
+    int res = emcute_pub(&t, argv[2], strlen(argv[2]), flags);
+    pubstats_record(PUBSTATS_PUBLISH, argv[1], strlen(argv[2]),
+                    xtimer_now_usec() - start, res);
+    if (res != EMCUTE_OK) {
         printf("error: unable to publish data to topic '%s [%i]'\n",
                 t.name, (int)t.id);
         return 1;
     }
 
     printf("Published %i bytes to topic '%s [%i]'\n",
-            (int)strlen(argomento), t.name, t.id);
+            (int)strlen(argv[2]), t.name, t.id);
 
-    xtimer_sleep(5);
-    }
     return 0;
 }
 
@@ -321,23 +307,13 @@ static int cmd_sub(int argc, char **argv) //shell command for subscription
         flags |= get_qos(argv[2]);
     }
 
-    /* find empty subscription slot */
-    unsigned i = 0;
-    for (; (i < NUMOFSUBS) && (subscriptions[i].topic.id != 0); i++) {}
-    if (i == NUMOFSUBS) {
-        puts("error: no memory to store new subscriptions");
-        return 1;
-    }
-
-    subscriptions[i].cb = on_pub;
-    strcpy(topics[i], argv[1]);
-    subscriptions[i].topic.name = topics[i];
-    if (emcute_sub(&subscriptions[i], flags) != EMCUTE_OK) {
-        printf("error: unable to subscribe to %s\n", argv[1]);
+    int res = subreg_sub(argv[1], flags, on_pub, NULL);
+    if (res < 0) {
+        printf("error: unable to subscribe to %s (%d)\n", argv[1], res);
         return 1;
     }
 
-    printf("Now subscribed to %s\n", argv[1]);
+    printf("Now subscribed to %s (%d topics)\n", argv[1], res);
     return 0;
 }
 
@@ -348,23 +324,22 @@ static int cmd_unsub(int argc, char **argv) //shell command to un-subscribe
         return 1;
     }
 
-    /* find subscriptions entry */
-    for (unsigned i = 0; i < NUMOFSUBS; i++) {
-        if (subscriptions[i].topic.name &&
-            (strcmp(subscriptions[i].topic.name, argv[1]) == 0)) {
-            if (emcute_unsub(&subscriptions[i]) == EMCUTE_OK) {
-                memset(&subscriptions[i], 0, sizeof(emcute_sub_t));
-                printf("Unsubscribed from '%s'\n", argv[1]);
-            }
-            else {
-                printf("Unsubscription form '%s' failed\n", argv[1]);
-            }
-            return 0;
-        }
+    if (subreg_unsub(argv[1]) != 0) {
+        printf("error: no subscription for topic '%s' found\n", argv[1]);
+        return 1;
     }
 
-    printf("error: no subscription for topic '%s' found\n", argv[1]);
-    return 1;
+    printf("Unsubscribed from '%s'\n", argv[1]);
+    return 0;
+}
+
+static int cmd_subs(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    subreg_print();
+    return 0;
 }
 
 static int cmd_will(int argc, char **argv) //shell command for last will message
@@ -391,10 +366,14 @@ static const shell_command_t shell_commands[] = {
     { "con", "connect to MQTT broker", cmd_con },
     { "discon", "disconnect from the current broker", cmd_discon },
     { "pub", "publish something", cmd_pub },
-    { "loop", "start looping publish", cmd_loop }, //our new function
+    { "loop", "start, stop or check the looping publish", sensor_loop_cmd },
     { "sub", "subscribe topic", cmd_sub },
     { "unsub", "unsubscribe from topic", cmd_unsub },
+    { "subs", "list subscriptions and the topics they match", cmd_subs },
     { "will", "register a last will", cmd_will },
+    { "perf", "thread CPU, stack and queue usage", perf_cmd },
+    { "stats", "publish latencies and topic counters", pubstats_cmd },
+    { "qosm1", "gateway and counters of the QoS -1 publishes", qosm1_cmd },
     { NULL, NULL, NULL }
 };
 
@@ -407,13 +386,21 @@ int main(void)
     /* the main thread needs a msg queue to be able to run `ping6`*/
     msg_init_queue(queue, (sizeof(queue) / sizeof(msg_t)));
 
-    /* initialize our subscription buffers */
-    memset(subscriptions, 0, (NUMOFSUBS * sizeof(emcute_sub_t)));
-
     /* start the emcute thread */
     thread_create(stack, sizeof(stack), EMCUTE_PRIO, 0,
                   emcute_thread, NULL, "emcute");
 
+    //initializing the random values for the loop command
+    srand(time(0));
+    temp = generate_random_temp();
+    hum = generate_random_hum();
+    dir = generate_random_dir();
+    inte = generate_random_int();
+    rain = generate_random_rain();
+
+    /* sampler and publisher threads, they wait for "loop start" */
+    sensor_loop_init(take_sample);
+
     /* start shell */
     char line_buf[SHELL_DEFAULT_BUFSIZE];
     shell_run(shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
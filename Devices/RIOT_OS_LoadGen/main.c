@@ -0,0 +1,590 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       MQTT-SN load generator, many virtual clients in one process
+ *
+ * emcute has a single session per process, so every virtual client speaks
+ * the few MQTT-SN messages it needs (CONNECT, PUBLISH to a predefined topic,
+ * PUBACK, DISCONNECT) on a UDP sock of its own, framed by mqttsn_frame.
+ * One thread polls all of them, each client has at most one QoS 1 message in
+ * flight like an emcute client.
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "shell.h"
+#include "msg.h"
+#include "mutex.h"
+#include "thread.h"
+#include "xtimer.h"
+#include "net/emcute.h"
+#include "net/ipv6/addr.h"
+#include "net/sock/udp.h"
+#include "mqttsn_frame.h"
+#include "predefined_topics.h"
+#include "telemetry.h"
+#include "fixp.h"
+
+#define GW_PORT             (1883U)
+
+/* most virtual clients, each costs a sock and its mailbox */
+#ifndef LOADGEN_CLIENTS_MAX
+#define LOADGEN_CLIENTS_MAX (256U)
+#endif
+
+/* how often the clients are polled, also the latency resolution */
+#ifndef LOADGEN_TICK
+#define LOADGEN_TICK        (1000U)         /* usec */
+#endif
+
+/* latencies are counted per millisecond up to this value */
+#ifndef LOADGEN_LAT_MAX_MS
+#define LOADGEN_LAT_MAX_MS  (1024U)
+#endif
+
+#define T_RETRY             (5U)            /* sec, like EMCUTE_T_RETRY */
+#define N_RETRY             (3U)
+#define KEEPALIVE           (60U)           /* sec */
+
+#define CLIENT_ID_MAXLEN    (23U)
+#define PKT_MAXLEN          (MQTTSN_FRAME_PUB_HDR_MAXLEN + TELEMETRY_JSON_MAXLEN)
+
+typedef enum {
+    CL_IDLE,            /* waiting for its start time */
+    CL_CONNECTING,      /* CONNECT sent */
+    CL_CONNECTED,
+    CL_FAILED,          /* gave up connecting */
+} cl_state_t;
+
+/* one virtual device */
+typedef struct {
+    sock_udp_t sock;
+    char id[CLIENT_ID_MAXLEN + 1];
+    uint8_t device;
+    cl_state_t state;
+    uint8_t retries;
+    bool inflight;      /* QoS 1 message waiting for its PUBACK */
+    uint16_t msg_id;
+    uint64_t sent;      /* usec, first transmission of the pending message */
+    uint64_t deadline;  /* usec, next retransmission or timeout */
+    uint64_t next_pub;  /* usec */
+    uint64_t last_tx;   /* usec, for the keepalive */
+    fixp_t value[TELEMETRY_FIELD_NUMOF];
+    uint8_t pkt[PKT_MAXLEN];
+    size_t pkt_len;
+} client_t;
+
+/* options of the load command */
+typedef struct {
+    sock_udp_ep_t gw;
+    unsigned numof;     /* virtual clients */
+    unsigned period;    /* ms between two publishes of one client */
+    unsigned stagger;   /* ms between the start of two clients */
+    unsigned qos;       /* 0 or 1 */
+    bool json;          /* payload format, binary records otherwise */
+    uint16_t topic_id;
+    unsigned first_dev; /* device number of the first client */
+} params_t;
+
+typedef struct {
+    uint64_t start;     /* usec */
+    uint32_t connected;
+    uint32_t con_failed;
+    uint32_t dropped;   /* sessions closed by the gateway with DISCONNECT */
+    uint32_t published;
+    uint32_t acked;
+    uint32_t failed;    /* QoS 1 messages without PUBACK */
+    uint32_t retrans;
+    uint32_t rejected;
+    uint32_t bytes;     /* payload bytes */
+    uint32_t lat[LOADGEN_LAT_MAX_MS + 1];   /* per ms, last one is the rest */
+    uint32_t lat_max;   /* usec */
+} stats_t;
+
+static const struct {
+    const char *name;
+    uint16_t id;
+} predef[] = PREDEF_TOPICS_INIT;
+
+/* value range of every field, the same as the MQTT-SN clients */
+static const int range[TELEMETRY_FIELD_NUMOF][2] = {
+    [TELEMETRY_TEMPERATURE]     = { -50, 50 },
+    [TELEMETRY_HUMIDITY]        = { 0, 100 },
+    [TELEMETRY_WIND_DIRECTION]  = { 0, 360 },
+    [TELEMETRY_WIND_INTENSITY]  = { 0, 100 },
+    [TELEMETRY_RAIN_HEIGHT]     = { 0, 50 },
+};
+
+static char stack[THREAD_STACKSIZE_DEFAULT];
+static msg_t queue[8];
+
+static client_t clients[LOADGEN_CLIENTS_MAX];
+static params_t params;
+static stats_t stats;
+static uint16_t next_id;
+static uint8_t rxbuf[16];
+
+static volatile bool running;
+/* held by the load thread while it polls, and by the shell while it
+ * starts, stops or reads the stats */
+static mutex_t lock = MUTEX_INIT;
+/* locked while no load is running, the load thread waits on it */
+static mutex_t gate = MUTEX_INIT_LOCKED;
+
+static void _send(client_t *c, const uint8_t *buf, size_t len, uint64_t now)
+{
+    sock_udp_send(&c->sock, buf, len, &params.gw);
+    c->last_tx = now;
+}
+
+static void _send_simple(client_t *c, uint8_t type, uint64_t now)
+{
+    uint8_t buf[2];
+
+    mqttsn_frame_hdr(buf, 0, type);
+    _send(c, buf, sizeof(buf), now);
+}
+
+static void _connect(client_t *c, uint64_t now)
+{
+    uint8_t buf[MQTTSN_FRAME_CONNECT_LEN(CLIENT_ID_MAXLEN)];
+
+    _send(c, buf, mqttsn_frame_connect(buf, EMCUTE_CS, KEEPALIVE, c->id), now);
+
+    c->state = CL_CONNECTING;
+    c->deadline = now + (T_RETRY * US_PER_SEC);
+}
+
+static void _latency(uint64_t usec)
+{
+    uint32_t ms = (uint32_t)(usec / US_PER_MS);
+
+    stats.lat[(ms < LOADGEN_LAT_MAX_MS) ? ms : LOADGEN_LAT_MAX_MS]++;
+    if (usec > stats.lat_max) {
+        stats.lat_max = (uint32_t)usec;
+    }
+}
+
+/* a new sample of the client, encoded into its packet buffer */
+static void _publish(client_t *c, uint64_t now)
+{
+    telemetry_sample_t s;
+    uint8_t data[TELEMETRY_JSON_MAXLEN];
+    int len;
+
+    telemetry_sample_init(&s, c->device, (uint32_t)time(NULL));
+    for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+        c->value[f] = fixp_random_walk(c->value[f], range[f][0], range[f][1]);
+        telemetry_sample_set(&s, f, c->value[f]);
+    }
+    if (params.json) {
+        len = telemetry_json_encode((char *)data, sizeof(data), &s);
+    }
+    else {
+        len = telemetry_bin_encode(data, sizeof(data), &s);
+    }
+    if (len < 0) {
+        return;
+    }
+
+    /* message IDs wrap around but are never 0 */
+    if (++next_id == 0) {
+        next_id = 1;
+    }
+    size_t pos = mqttsn_frame_pub(c->pkt, len,
+                                  (params.qos ? EMCUTE_QOS_1 : EMCUTE_QOS_0) |
+                                  EMCUTE_TIT_PREDEF,
+                                  params.topic_id, params.qos ? next_id : 0);
+    memcpy(&c->pkt[pos], data, len);
+    c->pkt_len = pos + len;
+
+    _send(c, c->pkt, c->pkt_len, now);
+    stats.published++;
+    stats.bytes += len;
+
+    if (params.qos) {
+        c->inflight = true;
+        c->msg_id = next_id;
+        c->sent = now;
+        c->retries = 0;
+        c->deadline = now + (T_RETRY * US_PER_SEC);
+    }
+}
+
+static void _receive(client_t *c, uint64_t now)
+{
+    ssize_t n;
+
+    while ((n = sock_udp_recv(&c->sock, rxbuf, sizeof(rxbuf), 0, NULL)) > 0) {
+        const uint8_t *msg;
+        uint8_t type;
+        /* a DISCONNECT is just the header */
+        int len = mqttsn_frame_parse(rxbuf, n, &type, &msg);
+        if (len < 0) {
+            continue;
+        }
+        switch (type) {
+            case MQTTSN_FRAME_CONNACK:
+                if ((len < 1) || (c->state != CL_CONNECTING)) {
+                    break;
+                }
+                if (msg[0] != 0) {
+                    c->state = CL_FAILED;
+                    stats.con_failed++;
+                    break;
+                }
+                c->state = CL_CONNECTED;
+                c->next_pub = now;
+                stats.connected++;
+                break;
+            case MQTTSN_FRAME_PUBACK:
+                /* topic ID, message ID, return code */
+                if ((len < 5) || !c->inflight ||
+                    ((((uint16_t)msg[2] << 8) | msg[3]) != c->msg_id)) {
+                    break;
+                }
+                c->inflight = false;
+                if (msg[4] != 0) {
+                    stats.rejected++;
+                    break;
+                }
+                stats.acked++;
+                _latency(now - c->sent);
+                break;
+            case MQTTSN_FRAME_DISCONNECT:
+                /* the gateway dropped the session, connect again */
+                if (c->state == CL_CONNECTED) {
+                    stats.connected--;
+                    stats.dropped++;
+                }
+                c->state = CL_IDLE;
+                c->inflight = false;
+                c->retries = 0;
+                c->next_pub = now + (T_RETRY * US_PER_SEC);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void _poll(client_t *c, uint64_t now)
+{
+    _receive(c, now);
+
+    switch (c->state) {
+        case CL_IDLE:
+            /* next_pub holds the start time until the client is connected */
+            if (now >= c->next_pub) {
+                _connect(c, now);
+            }
+            break;
+        case CL_CONNECTING:
+            if (now < c->deadline) {
+                break;
+            }
+            if (++c->retries > N_RETRY) {
+                c->state = CL_FAILED;
+                stats.con_failed++;
+                break;
+            }
+            _connect(c, now);
+            break;
+        case CL_CONNECTED:
+            if (c->inflight && (now >= c->deadline)) {
+                if (c->retries >= N_RETRY) {
+                    c->inflight = false;
+                    stats.failed++;
+                }
+                else {
+                    mqttsn_frame_set_dup(c->pkt);
+                    _send(c, c->pkt, c->pkt_len, now);
+                    c->retries++;
+                    c->deadline = now + (T_RETRY * US_PER_SEC);
+                    stats.retrans++;
+                }
+            }
+            if (!c->inflight && (now >= c->next_pub)) {
+                _publish(c, now);
+                /* keep the rate, a slow PUBACK does not shift the schedule */
+                c->next_pub += params.period * US_PER_MS;
+                if (c->next_pub < now) {
+                    c->next_pub = now;
+                }
+            }
+            if ((now - c->last_tx) > (KEEPALIVE * US_PER_SEC / 2)) {
+                _send_simple(c, MQTTSN_FRAME_PINGREQ, now);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void *load_thread(void *arg)
+{
+    (void)arg;
+    xtimer_ticks32_t last = xtimer_now();
+
+    while (1) {
+        if (!running) {
+            mutex_lock(&gate);
+            mutex_unlock(&gate);
+            last = xtimer_now();
+        }
+
+        mutex_lock(&lock);
+        uint64_t now = xtimer_now_usec64();
+        for (unsigned i = 0; running && (i < params.numof); i++) {
+            _poll(&clients[i], now);
+        }
+        mutex_unlock(&lock);
+
+        xtimer_periodic_wakeup(&last, LOADGEN_TICK);
+    }
+
+    return NULL;
+}
+
+/* latency below which p percent of the acknowledged messages are */
+static unsigned _percentile(unsigned p)
+{
+    uint32_t want = (uint32_t)(((uint64_t)stats.acked * p + 99) / 100);
+    uint32_t seen = 0;
+
+    for (unsigned ms = 0; ms <= LOADGEN_LAT_MAX_MS; ms++) {
+        seen += stats.lat[ms];
+        if ((seen >= want) && (seen > 0)) {
+            return ms;
+        }
+    }
+    return 0;
+}
+
+static void _print_stats(void)
+{
+    uint32_t ms = (uint32_t)((xtimer_now_usec64() - stats.start) / US_PER_MS);
+    uint32_t rate = (ms > 0) ? (uint32_t)((stats.published * 100000ULL) / ms) : 0;
+
+    printf("clients: %lu/%u connected, %lu failed to connect, "
+           "%lu dropped by the gateway\n",
+           (unsigned long)stats.connected, params.numof,
+           (unsigned long)stats.con_failed, (unsigned long)stats.dropped);
+    printf("publish: %lu sent, %lu.%02lu msg/s, %lu bytes, %lu acked, "
+           "%lu rejected, %lu failed, %lu retransmitted\n",
+           (unsigned long)stats.published, (unsigned long)(rate / 100),
+           (unsigned long)(rate % 100), (unsigned long)stats.bytes,
+           (unsigned long)stats.acked, (unsigned long)stats.rejected,
+           (unsigned long)stats.failed, (unsigned long)stats.retrans);
+    if (stats.acked > 0) {
+        printf("latency: p50 %ums, p90 %ums, p99 %ums, max %lu.%03lums%s\n",
+               _percentile(50), _percentile(90), _percentile(99),
+               (unsigned long)(stats.lat_max / US_PER_MS),
+               (unsigned long)(stats.lat_max % US_PER_MS),
+               stats.lat[LOADGEN_LAT_MAX_MS] ? " (some above the histogram)" : "");
+    }
+}
+
+static int _parse(int argc, char **argv, params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->gw.family = AF_INET6;
+    p->gw.port = GW_PORT;
+    p->numof = 10;
+    p->period = 5000;
+    p->stagger = 100;
+    p->qos = 1;
+    p->topic_id = PREDEF_TOPIC_TELEMETRY_BIN_ID;
+    p->first_dev = 10;
+
+    if (ipv6_addr_from_str((ipv6_addr_t *)&p->gw.addr.ipv6, argv[0]) == NULL) {
+        puts("error: unable to parse IPv6 address");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "n=", 2) == 0) {
+            p->numof = atoi(argv[i] + 2);
+        }
+        else if (strncmp(argv[i], "period=", 7) == 0) {
+            p->period = atoi(argv[i] + 7);
+        }
+        else if (strncmp(argv[i], "stagger=", 8) == 0) {
+            p->stagger = atoi(argv[i] + 8);
+        }
+        else if (strncmp(argv[i], "qos=", 4) == 0) {
+            p->qos = (atoi(argv[i] + 4) != 0);
+        }
+        else if (strncmp(argv[i], "dev=", 4) == 0) {
+            p->first_dev = atoi(argv[i] + 4);
+        }
+        else if (strcmp(argv[i], "fmt=json") == 0) {
+            p->json = true;
+        }
+        else if (strcmp(argv[i], "fmt=bin") == 0) {
+            p->json = false;
+        }
+        else if (strncmp(argv[i], "topic=", 6) == 0) {
+            unsigned t;
+            for (t = 0; t < (sizeof(predef) / sizeof(predef[0])); t++) {
+                if (strcmp(argv[i] + 6, predef[t].name) == 0) {
+                    p->topic_id = predef[t].id;
+                    break;
+                }
+            }
+            if (t == (sizeof(predef) / sizeof(predef[0]))) {
+                puts("error: only predefined topics are supported");
+                return 1;
+            }
+        }
+        else if (i == 1) {
+            p->gw.port = atoi(argv[i]);
+        }
+        else {
+            printf("error: unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if ((p->numof < 1) || (p->numof > LOADGEN_CLIENTS_MAX)) {
+        printf("error: n has to be between 1 and %u\n", LOADGEN_CLIENTS_MAX);
+        return 1;
+    }
+    if ((p->first_dev + p->numof - 1) > UINT8_MAX) {
+        puts("error: device numbers have to fit into one byte");
+        return 1;
+    }
+    if (p->period < 1) {
+        puts("error: period has to be at least 1 ms");
+        return 1;
+    }
+    return 0;
+}
+
+static void _stop_clients(void)
+{
+    uint64_t now = xtimer_now_usec64();
+
+    for (unsigned i = 0; i < params.numof; i++) {
+        if (clients[i].state == CL_CONNECTED) {
+            _send_simple(&clients[i], MQTTSN_FRAME_DISCONNECT, now);
+        }
+        sock_udp_close(&clients[i].sock);
+    }
+}
+
+static int cmd_load(int argc, char **argv)
+{
+    if ((argc >= 2) && (strcmp(argv[1], "stats") == 0)) {
+        mutex_lock(&lock);
+        _print_stats();
+        mutex_unlock(&lock);
+        return 0;
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "stop") == 0)) {
+        if (!running) {
+            puts("error: no load is running");
+            return 1;
+        }
+        mutex_lock(&gate);
+        mutex_lock(&lock);
+        running = false;
+        _stop_clients();
+        _print_stats();
+        mutex_unlock(&lock);
+        return 0;
+    }
+    if ((argc < 3) || (strcmp(argv[1], "start") != 0)) {
+        printf("usage: %s start <gw addr> [gw port] [n=N] [period=ms] "
+               "[stagger=ms] [qos=0|1] [fmt=bin|json] [topic=name] [dev=N]\n"
+               "       %s stop|stats\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (running) {
+        puts("error: load is already running, stop it first");
+        return 1;
+    }
+
+    params_t p;
+    if (_parse(argc - 2, argv + 2, &p) != 0) {
+        return 1;
+    }
+
+    mutex_lock(&lock);
+    params = p;
+    memset(&stats, 0, sizeof(stats));
+    uint64_t now = xtimer_now_usec64();
+    stats.start = now;
+    for (unsigned i = 0; i < params.numof; i++) {
+        client_t *c = &clients[i];
+        sock_udp_ep_t local = SOCK_IPV6_EP_ANY;
+
+        memset(c, 0, sizeof(*c));
+        if (sock_udp_create(&c->sock, &local, NULL, 0) < 0) {
+            printf("error: no sock for client %u\n", i);
+            params.numof = i;
+            break;
+        }
+        c->device = (uint8_t)(params.first_dev + i);
+        snprintf(c->id, sizeof(c->id), "load%03u", c->device);
+        c->state = CL_IDLE;
+        /* spread the CONNECTs, and with them the publishes */
+        c->next_pub = now + ((uint64_t)i * params.stagger * US_PER_MS);
+        for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+            int span = range[f][1] - range[f][0] + 1;
+            c->value[f] = fixp_from_int((rand() % span) + range[f][0]);
+        }
+    }
+    running = true;
+    mutex_unlock(&lock);
+    mutex_unlock(&gate);
+
+    printf("load started: %u clients, one publish every %u ms each "
+           "(%lu.%02lu msg/s in total), QoS %u\n", params.numof, params.period,
+           (unsigned long)((params.numof * 100000UL / params.period) / 100),
+           (unsigned long)((params.numof * 100000UL / params.period) % 100),
+           params.qos);
+    return 0;
+}
+
+static const shell_command_t shell_commands[] = {
+    { "load", "start, stop or check the virtual MQTT-SN clients", cmd_load },
+    { NULL, NULL, NULL }
+};
+
+int main(void)
+{
+    puts("MQTT-SN load generator\n");
+    puts("Type 'help' to get started. Have a look at the README.md for more"
+         "information.");
+
+    /* the main thread needs a msg queue to be able to run `ping6`*/
+    msg_init_queue(queue, (sizeof(queue) / sizeof(msg_t)));
+
+    srand(time(0));
+
+    /* polls the virtual clients, waits for "load start" */
+    thread_create(stack, sizeof(stack), THREAD_PRIORITY_MAIN - 1, 0,
+                  load_thread, NULL, "load");
+
+    /* start shell */
+    char line_buf[SHELL_DEFAULT_BUFSIZE];
+    shell_run(shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
+
+    /* should be never reached */
+    return 0;
+}
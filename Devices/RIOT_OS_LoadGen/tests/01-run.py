@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+# Kills the gateway under load: the restarted gateway drops the PUBLISH of
+# the old sessions with DISCONNECT and every virtual client has to connect
+# again. Needs the tap bridge described in dist/pythonlibs/mqttsn_fakegw.py.
+
+import os
+import sys
+import time
+
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'dist',
+                             'pythonlibs'))
+from mqttsn_fakegw import CONNECT, FakeGateway, node_ifconfig, shell_poll  # noqa
+
+CLIENTS = 4
+
+
+def testfunc(child):
+    gw = FakeGateway().start()
+    node_ifconfig(child)
+
+    child.sendline('load start {} {} n={} period=200 stagger=10'
+                   .format(gw.addr, gw.port, CLIENTS))
+    child.expect_exact('load started: {} clients'.format(CLIENTS))
+    shell_poll(child, 'load stats',
+               r'clients: {0}/{0} connected'.format(CLIENTS))
+    assert gw.wait_for(lambda: len(gw.published) >= 2 * CLIENTS)
+
+    # a few publishes go nowhere, then the gateway is back without sessions
+    gw.stop()
+    time.sleep(1)
+    gw.reset()
+    gw.start()
+
+    shell_poll(child, 'load stats',
+               r'clients: {0}/{0} connected, 0 failed to connect, '
+               r'{0} dropped by the gateway'.format(CLIENTS), timeout=60)
+    assert gw.count(CONNECT) == CLIENTS
+    assert gw.rejected >= CLIENTS
+    published = len(gw.published)
+    assert gw.wait_for(lambda: len(gw.published) >= published + CLIENTS)
+
+    child.sendline('load stop')
+    child.expect(r'publish: \d+ sent')
+    gw.stop()
+    print('clients reconnected after the gateway restart')
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
@@ -24,17 +24,35 @@
 #include <unistd.h>
 #include <time.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
 
 #include "shell.h"
 #include "msg.h"
 #include "net/emcute.h"
 #include "net/ipv6/addr.h"
+#include "topic_cache.h"
+#include "perf.h"
+#include "aggwin.h"
+#include "sensor_cache.h"
+#include "sensor_loop.h"
+#include "oneshot.h"
+#include "sensor_acq.h"
+#include "pubstats.h"
+#include "subreg.h"
+#include "telemetry.h"
+#include "fixp.h"
 
 //Libraries needed to access the temperature sensor
+#ifdef MODULE_LPSXXX
 #include "periph/i2c.h"
 #include "lpsxxx.h"
-#include "/home/andrea/Tutorials/RIOT/drivers/lpsxxx/include/lpsxxx_params.h"
-#include "/home/andrea/Tutorials/RIOT/drivers/lpsxxx/include/lpsxxx_internal.h"
+#include "lpsavg.h"
+#else
+#include "kernel_defines.h"
+#endif
+#include "saul_reg.h"
+#include "mutex.h"
 #include "thread.h"
 #include "xtimer.h"
 
@@ -42,10 +60,307 @@
 #define EMCUTE_ID           ("gertrud")
 #define EMCUTE_PRIO         (THREAD_PRIORITY_MAIN - 1)
 
-#define NUMOFSUBS           (16U)
 #define TOPIC_MAXLEN        (64U)
 
-static lpsxxx_t lpsxxx; //creating a variable for the sensor
+/* the cache thread, the fallback of pub and SAUL all read the sensor */
+static mutex_t temp_lock = MUTEX_INIT;
+static int read_temp(fixp_t *temp);
+
+#ifdef MODULE_LPSXXX
+/* the device saul_default set up, a second lpsxxx_t would configure the
+ * same chip behind its back */
+static lpsxxx_t *lpsxxx;
+static bool lpsxxx_ready;
+static oneshot_energy_t lpsxxx_energy;
+static lpsavg_t lpsxxx_avg;
+
+/* how the sensor is read, see the power command */
+typedef enum {
+    POWER_CONTINUOUS,   /* single reads of the driver */
+    POWER_ONESHOT,      /* powered down between readings */
+    POWER_AVG,          /* values averaged by the sensor, one burst read */
+} power_mode_t;
+
+static const char *const power_names[] = {
+    [POWER_CONTINUOUS]  = "continuous",
+    [POWER_ONESHOT]     = "one-shot",
+    [POWER_AVG]         = "averaging",
+};
+
+/* asked for by the power command, switched by the thread reading */
+static volatile power_mode_t power_wanted;
+static volatile unsigned avg_wanted = LPSAVG_TEMP_AVG;
+static power_mode_t power_on;
+
+/* the SAUL drivers of the LPS331AP, see drivers/lpsxxx/lpsxxx_saul.c */
+extern const saul_driver_t lpsxxx_saul_temp_driver;
+extern const saul_driver_t lpsxxx_saul_pres_driver;
+
+static int saul_temp(const void *dev, phydat_t *res);
+static int saul_press(const void *dev, phydat_t *res);
+
+/* SAUL reads go through temp_lock and the power mode like all others */
+static const saul_driver_t locked_drivers[] = {
+    { .read = saul_temp, .write = saul_notsup, .type = SAUL_SENSE_TEMP },
+    { .read = saul_press, .write = saul_notsup, .type = SAUL_SENSE_PRESS },
+};
+
+/* takes over the device saul_default initialised at boot */
+static void init_temp(void)
+{
+    for (saul_reg_t *reg = saul_reg; reg != NULL; reg = reg->next) {
+        if (reg->driver == &lpsxxx_saul_temp_driver) {
+            lpsxxx = reg->dev;
+            reg->driver = &locked_drivers[0];
+        }
+        else if (reg->driver == &lpsxxx_saul_pres_driver) {
+            reg->driver = &locked_drivers[1];
+        }
+    }
+    lpsxxx_ready = (lpsxxx != NULL);
+    if (!lpsxxx_ready) {
+        puts("error: no LPS331AP registered with SAUL");
+    }
+}
+
+/* hundredths of a degree straight from the bus, with temp_lock held */
+static int read_bus_temp(fixp_t *temp)
+{
+    int16_t tempr = 0;
+
+    if (!lpsxxx_ready) {
+        return -ENODEV;
+    }
+    if ((power_wanted != power_on) ||
+        ((power_on == POWER_AVG) && (avg_wanted != lpsxxx_avg.temp_avg))) {
+        if (power_on == POWER_AVG) {
+            lpsavg_restore(lpsxxx);
+        }
+        power_on = power_wanted;
+        switch (power_on) {
+            case POWER_ONESHOT:
+                oneshot_lpsxxx_init(lpsxxx, &lpsxxx_energy);
+                break;
+            case POWER_AVG:
+                lpsavg_init(lpsxxx, avg_wanted, &lpsxxx_avg);
+                /* rounded to what the sensor supports */
+                avg_wanted = lpsxxx_avg.temp_avg;
+                break;
+            default:
+                lpsxxx_enable(lpsxxx);
+                break;
+        }
+    }
+
+    int res;
+    switch (power_on) {
+        case POWER_ONESHOT:
+            res = oneshot_lpsxxx_read_temp(lpsxxx, &tempr, &lpsxxx_energy);
+            break;
+        case POWER_AVG:
+            res = lpsavg_read_temp(lpsxxx, &tempr, &lpsxxx_avg);
+            break;
+        default:
+            res = lpsxxx_read_temp(lpsxxx, &tempr);
+            break;
+    }
+    if (res != LPSXXX_OK) {
+        return -EIO;
+    }
+    *temp = tempr;
+    return 0;
+}
+
+static int cmd_power(int argc, char **argv)
+{
+    if ((argc >= 2) && (strcmp(argv[1], "oneshot") == 0)) {
+        power_wanted = POWER_ONESHOT;
+        puts("LPS331AP powered down between readings, 'cache 10000' reads it "
+             "less often");
+        return 0;
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "continuous") == 0)) {
+        power_wanted = POWER_CONTINUOUS;
+        puts("LPS331AP converting continuously");
+        return 0;
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "avg") == 0)) {
+        unsigned n = (argc >= 3) ? (unsigned)atoi(argv[2]) : LPSAVG_TEMP_AVG;
+        if ((n < 1) || (n > 128)) {
+            puts("error: the LPS331AP averages 1 to 128 measurements");
+            return 1;
+        }
+        avg_wanted = n;
+        power_wanted = POWER_AVG;
+        puts("LPS331AP averaging in the sensor, 'cache 10000' reads it once "
+             "per 10 s batch");
+        return 0;
+    }
+    if (argc >= 2) {
+        printf("usage: %s [oneshot|continuous|avg [1-128]]\n", argv[0]);
+        return 1;
+    }
+
+    printf("LPS331AP %s\n", power_names[power_on]);
+    if (power_on == POWER_ONESHOT) {
+        oneshot_energy_print(&lpsxxx_energy);
+    }
+    else if (power_on == POWER_AVG) {
+        lpsavg_print(&lpsxxx_avg);
+    }
+    return 0;
+}
+
+static int saul_temp(const void *dev, phydat_t *res)
+{
+    fixp_t temp;
+
+    (void)dev;
+    if (read_temp(&temp) != 0) {
+        return -ECANCELED;
+    }
+    res->val[0] = temp;
+    res->unit = UNIT_TEMP_C;
+    res->scale = -2;
+    return 1;
+}
+
+static int saul_press(const void *dev, phydat_t *res)
+{
+    mutex_lock(&temp_lock);
+    int dim = lpsxxx_saul_pres_driver.read(dev, res);
+    mutex_unlock(&temp_lock);
+    return dim;
+}
+#else
+/* native has no LPS331AP, a random walk between 15 and 30 degrees stands
+ * in, with temp_lock held */
+static int read_bus_temp(fixp_t *temp)
+{
+    static fixp_t emulated = 2000;
+
+    emulated = fixp_random_walk(emulated, 15, 30);
+    *temp = emulated;
+    return 0;
+}
+
+/* the same emulation, and the pressure and light of the M3, through SAUL */
+static int saul_temp(const void *dev, phydat_t *res)
+{
+    fixp_t temp;
+
+    (void)dev;
+    read_temp(&temp);
+    res->val[0] = temp;
+    res->unit = UNIT_TEMP_C;
+    res->scale = -2;
+    return 1;
+}
+
+static int saul_press(const void *dev, phydat_t *res)
+{
+    static fixp_t emulated = 101300;
+
+    (void)dev;
+    emulated = fixp_random_walk(emulated, 990, 1030);
+    res->val[0] = fixp_to_int(emulated);
+    res->unit = UNIT_BAR;
+    res->scale = -3;
+    return 1;
+}
+
+static int saul_light(const void *dev, phydat_t *res)
+{
+    static fixp_t emulated = 30000;
+
+    (void)dev;
+    emulated = fixp_random_walk(emulated, 0, 1000);
+    res->val[0] = fixp_to_int(emulated);
+    res->unit = UNIT_LUX;
+    res->scale = 0;
+    return 1;
+}
+
+static const saul_driver_t emulated_drivers[] = {
+    { .read = saul_temp, .write = saul_notsup, .type = SAUL_SENSE_TEMP },
+    { .read = saul_press, .write = saul_notsup, .type = SAUL_SENSE_PRESS },
+    { .read = saul_light, .write = saul_notsup, .type = SAUL_SENSE_LIGHT },
+};
+
+static saul_reg_t emulated_sensors[] = {
+    { .name = "lps331ap (emulated)", .driver = &emulated_drivers[0] },
+    { .name = "lps331ap (emulated)", .driver = &emulated_drivers[1] },
+    { .name = "isl29020 (emulated)", .driver = &emulated_drivers[2] },
+};
+
+/* registered next to the board's own SAUL devices, sensors finds them all */
+static void init_temp(void)
+{
+    for (unsigned i = 0; i < ARRAY_SIZE(emulated_sensors); i++) {
+        saul_reg_add(&emulated_sensors[i]);
+    }
+}
+
+static int cmd_power(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    puts("error: no LPS331AP on this board");
+    return 1;
+}
+#endif
+
+static int read_temp(fixp_t *temp)
+{
+    mutex_lock(&temp_lock);
+    int res = read_bus_temp(temp);
+    mutex_unlock(&temp_lock);
+    return res;
+}
+
+/* the reading of the background sampler, the bus only if it is too old */
+static int get_temp(fixp_t *temp, uint32_t *ts)
+{
+    int res = sensor_cache_get(temp, ts);
+
+    if (res != 0) {
+        printf("warning: no recent cached reading (%d), reading the sensor\n",
+               res);
+        res = read_temp(temp);
+        *ts = (uint32_t)time(NULL);
+    }
+    return res;
+}
+
+/* the agg command gets every reading of the sampler once, it reads the
+ * cache at the same rate and would count a reading twice after a late one */
+static int get_cached_temp(fixp_t *temp)
+{
+    static uint32_t seen;
+
+    return sensor_cache_get_new(temp, &seen);
+}
+
+/* the temperature for the loop command, where db= and heartbeat= leave out
+ * the samples of a room that did not change; a period longer than
+ * SENSOR_CACHE_IDLE finds the cache asleep and reads the bus */
+static void take_sample(telemetry_sample_t *s)
+{
+    fixp_t temp;
+    uint32_t ts;
+
+    if (sensor_cache_get(&temp, &ts) != 0) {
+        ts = (uint32_t)time(NULL);
+        if (read_temp(&temp) != 0) {
+            /* no fields, the filter only lets it through as heartbeat */
+            telemetry_sample_init(s, 1, ts);
+            return;
+        }
+    }
+    telemetry_sample_init(s, 1, ts);
+    telemetry_sample_set(s, TELEMETRY_TEMPERATURE, temp);
+}
 
 int generate_random_temp(void) { //this will generate random number in range l and r
     int l = -50;
@@ -96,21 +411,9 @@ int generate_random_rain(void) { //this will generate random number in range l a
     return rand_num;
 }
 
-float genNextValue(int prevValue, int min, int max){
-    float value = prevValue + ((max - min) * (((rand() % 11) - 5))) * 0.003;
-    if(value > max) value=max;
-    else if (value < min) value=min;
-    else value=value;
-
-    return value;
-}
-
 static char stack[THREAD_STACKSIZE_DEFAULT];
 static msg_t queue[8];
 
-static emcute_sub_t subscriptions[NUMOFSUBS];
-static char topics[NUMOFSUBS][TOPIC_MAXLEN];
-
 static void *emcute_thread(void *arg)
 {
     (void)arg;
@@ -118,16 +421,12 @@ static void *emcute_thread(void *arg)
     return NULL;    /* should never be reached */
 }
 
-static void on_pub(const emcute_topic_t *topic, void *data, size_t len)
+static void on_pub(const char *topic, const void *data, size_t len, void *arg)
 {
-    char *in = (char *)data;
+    (void)arg;
 
-    printf("### got publication for topic '%s' [%i] ###\n",
-           topic->name, (int)topic->id);
-    for (size_t i = 0; i < len; i++) {
-        printf("%c", in[i]);
-    }
-    puts("");
+    printf("### got publication for topic '%s' ###\n", topic);
+    printf("%.*s\n", (int)len, (const char *)data);
 }
 
 static unsigned get_qos(const char *str)
@@ -169,12 +468,16 @@ static int cmd_con(int argc, char **argv) //connect cmd
         len = strlen(message);
     }
 
+    /* topic IDs registered on a previous connection are no longer valid */
+    topic_cache_invalidate();
+
     if (emcute_con(&gw, true, topic, message, len, 0) != EMCUTE_OK) {
         printf("error: unable to connect to [%s]:%i\n", argv[1], (int)gw.port);
         return 1;
     }
     printf("Successfully connected to gateway at [%s]:%i\n",
            argv[1], (int)gw.port);
+    sensor_loop_set_gateway(&gw, EMCUTE_ID);
 
     return 0;
 }
@@ -185,6 +488,8 @@ static int cmd_discon(int argc, char **argv) //disconnection cmd
     (void)argv;
 
     int res = emcute_discon();
+    topic_cache_invalidate();
+    sensor_loop_set_gateway(NULL, NULL);
     if (res == EMCUTE_NOGW) {
         puts("error: not connected to any broker");
         return 1;
@@ -202,45 +507,82 @@ static int cmd_pub(int argc, char **argv) //publish cmd
     emcute_topic_t t;
     unsigned flags = EMCUTE_QOS_0;
 
-    srand(time(0));
+    /* time to publish: from the command to the message handed to emcute */
+    uint32_t cmd_start = xtimer_now_usec();
 
-    unsigned long long int ts = ((unsigned long long)time(NULL)) * 1000;
-
-    lpsxxx_init(&lpsxxx, &lpsxxx_params[0]); //initializing the variable
+    fixp_t tempr = 0;
+    uint32_t sampled;
+    if (get_temp(&tempr, &sampled) != 0) {
+        puts("error: unable to read the temperature");
+        return 1;
+    }
+    uint32_t read_time = xtimer_now_usec() - cmd_start;
 
-    int16_t tempr = 0; //new tempr variable of type int16_t
-    lpsxxx_read_temp(&lpsxxx, &tempr); // reading the temperature calling the sensor read temp function
-    char argomento[200];
-    sprintf(argomento, "{\"ts\": %llu, \"values\":{\"device\": \"%d\",\"temperature\": \"%u\"}}", ts, 1, (tempr / 100)); //passing the temperature as argument for the publish
+    unsigned long long int ts = ((unsigned long long)sampled) * 1000;
 
     if (argc < 3) {
-        printf("usage: %s <topic name> <data> [QoS level]\n", argv[0]);
+        printf("usage: %s <topic name> <data> [QoS level] [fmt=json|bin]\n", argv[0]);
         return 1;
     }
 
-    /* parse QoS level */
-    if (argc >= 4) {
-        flags |= get_qos(argv[3]);
+    /* parse QoS level and format, the binary record keeps the hundredths */
+    bool binary = false;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "fmt=bin") == 0) {
+            binary = true;
+        }
+        else if (strcmp(argv[i], "fmt=json") != 0) {
+            flags |= get_qos(argv[i]);
+        }
     }
 
-    printf("pub with topic: %s and name %s and flags 0x%02x\n", argv[1], argomento, (int)flags);
+    char argomento[200];
+    uint8_t rec[TELEMETRY_BIN_MAXLEN];
+    const void *payload = argomento;
+    size_t payload_len;
+    if (binary) {
+        telemetry_sample_t s;
+        telemetry_sample_init(&s, 1, sampled);
+        telemetry_sample_set(&s, TELEMETRY_TEMPERATURE, tempr);
+        int len = telemetry_bin_encode(rec, sizeof(rec), &s);
+        if (len < 0) {
+            printf("error: unable to encode the record [%d]\n", len);
+            return 1;
+        }
+        payload_len = len;
+        payload = rec;
+        printf("pub with topic: %s and a %u byte record and flags 0x%02x\n", argv[1], (unsigned)payload_len, (int)flags);
+    }
+    else {
+        char temp_str[FIXP_FMT_MAXLEN]; //the sensor gives hundredths of a degree
+        fixp_to_str(temp_str, tempr, 0);
+        sprintf(argomento, "{\"ts\": %llu, \"values\":{\"device\": \"%d\",\"temperature\": \"%s\"}}", ts, 1, temp_str); //passing the temperature as argument for the publish
+        payload_len = strlen(argomento);
+        printf("pub with topic: %s and name %s and flags 0x%02x\n", argv[1], argomento, (int)flags);
+    }
 
-    /* step 1: get topic id */
-    t.name = argv[1];
-    if (emcute_reg(&t) != EMCUTE_OK) {
+    /* step 1: get topic id, only registered once per connection */
+    if (topic_cache_get(&t, &flags, argv[1]) != EMCUTE_OK) {
         puts("error: unable to obtain topic ID");
         return 1;
     }
 
     /* step 2: publish data */
-    if (emcute_pub(&t, argomento, strlen(argomento), flags) != EMCUTE_OK) {
+    uint32_t start = xtimer_now_usec();
+    int res = emcute_pub(&t, payload, payload_len, flags);
+    pubstats_record(PUBSTATS_PUBLISH, argv[1], payload_len,
+                    xtimer_now_usec() - start, res);
+    if (res != EMCUTE_OK) {
         printf("error: unable to publish data to topic '%s [%i]'\n",
                 t.name, (int)t.id);
         return 1;
     }
 
     printf("Published %i bytes to topic '%s [%i]'\n",
-            (int)strlen(argomento), t.name, t.id);
+            (int)payload_len, t.name, t.id);
+    printf("time to publish %lu us, reading the temperature %lu us\n",
+           (unsigned long)(xtimer_now_usec() - cmd_start),
+           (unsigned long)read_time);
 
     return 0;
 }
@@ -263,23 +605,13 @@ static int cmd_sub(int argc, char **argv) //subscription cmd
         flags |= get_qos(argv[2]);
     }
 
-    /* find empty subscription slot */
-    unsigned i = 0;
-    for (; (i < NUMOFSUBS) && (subscriptions[i].topic.id != 0); i++) {}
-    if (i == NUMOFSUBS) {
-        puts("error: no memory to store new subscriptions");
+    int res = subreg_sub(argv[1], flags, on_pub, NULL);
+    if (res < 0) {
+        printf("error: unable to subscribe to %s (%d)\n", argv[1], res);
         return 1;
     }
 
-    subscriptions[i].cb = on_pub;
-    strcpy(topics[i], argv[1]);
-    subscriptions[i].topic.name = topics[i];
-    if (emcute_sub(&subscriptions[i], flags) != EMCUTE_OK) {
-        printf("error: unable to subscribe to %s\n", argv[1]);
-        return 1;
-    }
-
-    printf("Now subscribed to %s\n", argv[1]);
+    printf("Now subscribed to %s (%d topics)\n", argv[1], res);
     return 0;
 }
 
@@ -290,23 +622,22 @@ static int cmd_unsub(int argc, char **argv) // unsubscription cmd
         return 1;
     }
 
-    /* find subscriptions entry */
-    for (unsigned i = 0; i < NUMOFSUBS; i++) {
-        if (subscriptions[i].topic.name &&
-            (strcmp(subscriptions[i].topic.name, argv[1]) == 0)) {
-            if (emcute_unsub(&subscriptions[i]) == EMCUTE_OK) {
-                memset(&subscriptions[i], 0, sizeof(emcute_sub_t));
-                printf("Unsubscribed from '%s'\n", argv[1]);
-            }
-            else {
-                printf("Unsubscription form '%s' failed\n", argv[1]);
-            }
-            return 0;
-        }
+    if (subreg_unsub(argv[1]) != 0) {
+        printf("error: no subscription for topic '%s' found\n", argv[1]);
+        return 1;
     }
 
-    printf("error: no subscription for topic '%s' found\n", argv[1]);
-    return 1;
+    printf("Unsubscribed from '%s'\n", argv[1]);
+    return 0;
+}
+
+static int cmd_subs(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    subreg_print();
+    return 0;
 }
 
 static int cmd_will(int argc, char **argv) //last will cmd
@@ -336,7 +667,15 @@ static const shell_command_t shell_commands[] = {
     { "pub", "publish something", cmd_pub },
     { "sub", "subscribe topic", cmd_sub },
     { "unsub", "unsubscribe from topic", cmd_unsub },
+    { "subs", "list subscriptions and the topics they match", cmd_subs },
     { "will", "register a last will", cmd_will },
+    { "perf", "thread CPU, stack and queue usage", perf_cmd },
+    { "stats", "publish latencies and topic counters", pubstats_cmd },
+    { "agg", "publish min, max and mean of frequent readings", aggwin_cmd },
+    { "cache", "latest temperature reading and sampling period", sensor_cache_cmd },
+    { "power", "one-shot, continuous or averaging sensor", cmd_power },
+    { "sensors", "read or publish all SAUL sensors in one message", sensor_acq_cmd },
+    { "loop", "publish the temperature periodically, with send-on-delta", sensor_loop_cmd },
     { NULL, NULL, NULL }
 };
 
@@ -349,13 +688,20 @@ int main(void)
     /* the main thread needs a msg queue to be able to run `ping6`*/
     msg_init_queue(queue, (sizeof(queue) / sizeof(msg_t)));
 
-    /* initialize our subscription buffers */
-    memset(subscriptions, 0, (NUMOFSUBS * sizeof(emcute_sub_t)));
-
     /* start the emcute thread */
     thread_create(stack, sizeof(stack), EMCUTE_PRIO, 0,
                   emcute_thread, NULL, "emcute");
 
+    /* seeded once, the generators above share it */
+    srand(time(0));
+
+    /* the sensor is set up once and sampled in the background */
+    init_temp();
+    sensor_cache_init(read_temp);
+    aggwin_init(get_cached_temp, "temperature", 1);
+    sensor_acq_init();
+    sensor_loop_init(take_sample);
+
     /* start shell */
     char line_buf[SHELL_DEFAULT_BUFSIZE];
     shell_run(shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
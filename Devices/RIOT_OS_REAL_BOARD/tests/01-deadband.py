@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+# Runs the loop on the emulated temperature with a band wider than most
+# steps of the random walk: the filter suppresses samples, the heartbeat
+# still sends one every few seconds, and the gateway receives exactly the
+# samples `loop status` counts as sent. Needs BOARD=native and the tap
+# bridge described in dist/pythonlibs/mqttsn_fakegw.py.
+
+import os
+import sys
+import time
+
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', '..', 'dist',
+                             'pythonlibs'))
+from mqttsn_fakegw import FakeGateway, node_ifconfig  # noqa
+
+TOPIC = 'riot/telemetry/bin'
+HEARTBEAT = 4
+RUN = 15                # seconds of sampling, once per second
+
+
+def testfunc(child):
+    gw = FakeGateway().start()
+    node_ifconfig(child)
+    child.sendline('con {} {}'.format(gw.addr, gw.port))
+    child.expect_exact('Successfully connected to gateway')
+
+    child.sendline('loop start {} 1 fmt=bin period=1 db=temperature:2 '
+                   'heartbeat={}'.format(TOPIC, HEARTBEAT))
+    child.expect_exact('loop started')
+    time.sleep(RUN)
+    child.sendline('loop stop')
+    child.expect_exact('loop stopped')
+
+    child.sendline('loop status')
+    child.expect(r'sampled (\d+),')
+    sampled = int(child.match.group(1))
+    child.expect(r'deadband: (\d+) sent, (\d+) suppressed \(\d+%\), '
+                 r'(\d+) heartbeats')
+    sent, suppressed, heartbeats = map(int, child.match.groups())
+    assert sent + suppressed == sampled, (sent, suppressed, sampled)
+    assert suppressed > 0
+    assert heartbeats >= RUN // (HEARTBEAT + 1) - 1, heartbeats
+    # one record per message, batch=1
+    assert len(gw.published) == sent, (len(gw.published), sent)
+    gw.stop()
+    print('{} samples, {} sent, {} suppressed, {} heartbeats'
+          .format(sampled, sent, suppressed, heartbeats))
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
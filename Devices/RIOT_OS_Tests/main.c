@@ -0,0 +1,34 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       Unit tests of the shared modules in Devices/modules
+ *
+ * Runs every suite once and prints the embUnit summary, which
+ * tests/01-run.py checks.
+ *
+ * @}
+ */
+
+#include "tests.h"
+
+int main(void)
+{
+    TESTS_START();
+    TESTS_RUN(tests_delta_codec_tests());
+    TESTS_RUN(tests_telemetry_tests());
+    TESTS_RUN(tests_aggwin_tests());
+    TESTS_RUN(tests_sensor_cache_tests());
+    TESTS_RUN(tests_mqttsn_frame_tests());
+    TESTS_END();
+
+    return 0;
+}
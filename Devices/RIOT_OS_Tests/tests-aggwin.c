@@ -0,0 +1,157 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       Unit tests of the window statistics of the aggwin module
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "aggwin.h"
+#include "tests.h"
+
+#define ARRAY_LEN(a)    (sizeof(a) / sizeof((a)[0]))
+
+static aggwin_t w;
+
+static void set_up(void)
+{
+    aggwin_reset(&w);
+}
+
+static void _add(const fixp_t *v, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        aggwin_add(&w, v[i]);
+    }
+}
+
+static void test_empty(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, w.count);
+    TEST_ASSERT_EQUAL_INT(0, aggwin_mean(&w));
+}
+
+static void test_single(void)
+{
+    aggwin_add(&w, -5);
+    TEST_ASSERT_EQUAL_INT(1, w.count);
+    TEST_ASSERT_EQUAL_INT(-5, w.min);
+    TEST_ASSERT_EQUAL_INT(-5, w.max);
+    TEST_ASSERT_EQUAL_INT(-5, w.last);
+    TEST_ASSERT_EQUAL_INT(-5, aggwin_mean(&w));
+}
+
+static void test_sequence(void)
+{
+    /* -1.50 °C to 21.93 °C and back below zero */
+    static const fixp_t v[] = { -150, 2150, 2193, 0, -1, 2190 };
+
+    _add(v, ARRAY_LEN(v));
+    TEST_ASSERT_EQUAL_INT(ARRAY_LEN(v), w.count);
+    TEST_ASSERT_EQUAL_INT(-150, w.min);
+    TEST_ASSERT_EQUAL_INT(2193, w.max);
+    TEST_ASSERT_EQUAL_INT(2190, w.last);
+    TEST_ASSERT(w.sum == 6382);
+    /* 1063.67 rounds to 1064 */
+    TEST_ASSERT_EQUAL_INT(1064, aggwin_mean(&w));
+}
+
+static void test_mean_rounding(void)
+{
+    static const struct {
+        fixp_t v[3];
+        unsigned n;
+        fixp_t mean;
+    } cases[] = {
+        { { 1, 2 }, 2, 2 },             /* 1.5, half away from zero */
+        { { -1, -2 }, 2, -2 },          /* -1.5 */
+        { { -5, 0 }, 2, -3 },           /* -2.5 */
+        { { 1, 1, 2 }, 3, 1 },          /* 1.33 */
+        { { 2, 2, 1 }, 3, 2 },          /* 1.67 */
+        { { -1, -1, -2 }, 3, -1 },      /* -1.33 */
+        { { -2, -2, -1 }, 3, -2 },      /* -1.67 */
+        { { -1, 1 }, 2, 0 },
+    };
+
+    for (unsigned i = 0; i < ARRAY_LEN(cases); i++) {
+        aggwin_reset(&w);
+        _add(cases[i].v, cases[i].n);
+        TEST_ASSERT_EQUAL_INT(cases[i].mean, aggwin_mean(&w));
+    }
+}
+
+static void test_mean_no_overflow(void)
+{
+    /* the sum of many extreme readings does not fit into 32 bit */
+    for (unsigned i = 0; i < 1000; i++) {
+        aggwin_add(&w, INT32_MAX);
+    }
+    TEST_ASSERT_EQUAL_INT(INT32_MAX, aggwin_mean(&w));
+
+    aggwin_reset(&w);
+    for (unsigned i = 0; i < 1000; i++) {
+        aggwin_add(&w, INT32_MIN);
+    }
+    TEST_ASSERT_EQUAL_INT(INT32_MIN, aggwin_mean(&w));
+}
+
+static void test_json(void)
+{
+    static const fixp_t v[] = { -150, 2150, -5 };
+    static const char expected[] = "{\"ts\": 1700000000000, \"values\": "
+                                   "{\"device\": \"1\", "
+                                   "\"temperature_min\": \"-1.50\", "
+                                   "\"temperature_max\": \"21.50\", "
+                                   "\"temperature_mean\": \"6.65\", "
+                                   "\"temperature_last\": \"-0.05\", "
+                                   "\"temperature_count\": 3}}";
+    char buf[AGGWIN_PAYLOAD_MAXLEN];
+
+    _add(v, ARRAY_LEN(v));
+    TEST_ASSERT_EQUAL_INT(strlen(expected),
+                          aggwin_json(buf, sizeof(buf), &w, "temperature", 1,
+                                      1700000000000ULL));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+}
+
+static void test_json_overflow(void)
+{
+    char buf[AGGWIN_PAYLOAD_MAXLEN];
+
+    aggwin_add(&w, 2150);
+    int len = aggwin_json(buf, sizeof(buf), &w, "temperature", 1, 0);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, aggwin_json(buf, len, &w, "temperature",
+                                                  1, 0));
+}
+
+Test *tests_aggwin_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_empty),
+        new_TestFixture(test_single),
+        new_TestFixture(test_sequence),
+        new_TestFixture(test_mean_rounding),
+        new_TestFixture(test_mean_no_overflow),
+        new_TestFixture(test_json),
+        new_TestFixture(test_json_overflow),
+    };
+
+    EMB_UNIT_TESTCALLER(aggwin_tests, set_up, NULL, fixtures);
+
+    return (Test *)&aggwin_tests;
+}
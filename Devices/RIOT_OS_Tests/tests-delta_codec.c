@@ -0,0 +1,180 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       Unit tests of the delta_codec module
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "delta_codec.h"
+#include "tests.h"
+
+#define ARRAY_LEN(a)    (sizeof(a) / sizeof((a)[0]))
+
+static void test_zigzag_extremes(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, delta_zigzag(0));
+    TEST_ASSERT_EQUAL_INT(1, delta_zigzag(-1));
+    TEST_ASSERT_EQUAL_INT(2, delta_zigzag(1));
+    TEST_ASSERT(delta_zigzag(INT32_MAX) == 0xfffffffeUL);
+    TEST_ASSERT(delta_zigzag(INT32_MIN) == 0xffffffffUL);
+
+    TEST_ASSERT_EQUAL_INT(0, delta_unzigzag(0));
+    TEST_ASSERT_EQUAL_INT(-1, delta_unzigzag(1));
+    TEST_ASSERT(delta_unzigzag(0xfffffffeUL) == INT32_MAX);
+    TEST_ASSERT(delta_unzigzag(0xffffffffUL) == INT32_MIN);
+}
+
+static void test_varint_lengths(void)
+{
+    static const struct {
+        uint32_t v;
+        int len;
+    } cases[] = {
+        { 0, 1 }, { 0x7f, 1 }, { 0x80, 2 }, { 0x3fff, 2 }, { 0x4000, 3 },
+        { 0x0fffffff, 4 }, { 0x10000000, 5 }, { UINT32_MAX, 5 },
+    };
+    uint8_t buf[DELTA_VARINT_MAXLEN];
+
+    for (unsigned i = 0; i < ARRAY_LEN(cases); i++) {
+        uint32_t v = ~cases[i].v;
+        TEST_ASSERT_EQUAL_INT(cases[i].len,
+                              delta_varint_put(buf, sizeof(buf), cases[i].v));
+        TEST_ASSERT_EQUAL_INT(cases[i].len,
+                              delta_varint_get(&v, buf, cases[i].len));
+        TEST_ASSERT(v == cases[i].v);
+    }
+}
+
+static void test_varint_max(void)
+{
+    static const uint8_t expected[] = { 0xff, 0xff, 0xff, 0xff, 0x0f };
+    uint8_t buf[DELTA_VARINT_MAXLEN];
+
+    TEST_ASSERT_EQUAL_INT(5, delta_varint_put(buf, sizeof(buf), UINT32_MAX));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, expected, sizeof(expected)));
+}
+
+static void test_varint_put_overflow(void)
+{
+    uint8_t buf[DELTA_VARINT_MAXLEN];
+
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, delta_varint_put(buf, 0, 0));
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, delta_varint_put(buf, 1, 0x80));
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, delta_varint_put(buf, 4, UINT32_MAX));
+}
+
+static void test_varint_get_truncated(void)
+{
+    static const uint8_t cont[] = { 0x80, 0x80 };
+    uint32_t v;
+
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, delta_varint_get(&v, cont, 0));
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, delta_varint_get(&v, cont, 1));
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, delta_varint_get(&v, cont, sizeof(cont)));
+}
+
+static void test_varint_get_too_long(void)
+{
+    /* a sixth byte would follow */
+    static const uint8_t six[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 };
+    uint32_t v;
+
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, delta_varint_get(&v, six, sizeof(six)));
+}
+
+static void test_varint_get_stray_bits(void)
+{
+    /* the fifth byte only carries bits 28 to 31 */
+    static const uint8_t stray[][DELTA_VARINT_MAXLEN] = {
+        { 0xff, 0xff, 0xff, 0xff, 0x1f },
+        { 0x80, 0x80, 0x80, 0x80, 0x10 },
+        { 0x80, 0x80, 0x80, 0x80, 0x70 },
+    };
+    static const uint8_t top[] = { 0x80, 0x80, 0x80, 0x80, 0x08 };
+    uint32_t v;
+
+    for (unsigned i = 0; i < ARRAY_LEN(stray); i++) {
+        TEST_ASSERT_EQUAL_INT(-EBADMSG,
+                              delta_varint_get(&v, stray[i], sizeof(stray[i])));
+    }
+    TEST_ASSERT_EQUAL_INT(5, delta_varint_get(&v, top, sizeof(top)));
+    TEST_ASSERT(v == 0x80000000UL);
+}
+
+static void test_column_round_trip(void)
+{
+    /* small steps, a sign change, both extremes and a wrapping timestamp */
+    static const int32_t values[] = {
+        2150, 2151, 2149, 2149, -12, 0, INT32_MAX, INT32_MIN, INT32_MAX,
+        (int32_t)0xfffffff0UL, 0x10, 7,
+    };
+    uint8_t buf[DELTA_COLUMN_MAXLEN(ARRAY_LEN(values))];
+    int32_t out[ARRAY_LEN(values)];
+
+    int len = delta_encode(buf, sizeof(buf), values, ARRAY_LEN(values));
+    TEST_ASSERT(len > 0);
+    memset(out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL_INT(len, delta_decode(out, ARRAY_LEN(out), buf, len));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(values, out, sizeof(values)));
+}
+
+static void test_column_small_steps(void)
+{
+    /* a step below ±64 costs one byte, the first value is taken to 0 */
+    static const int32_t values[] = { 63, 0, -64, -1 };
+    uint8_t buf[DELTA_COLUMN_MAXLEN(ARRAY_LEN(values))];
+
+    TEST_ASSERT_EQUAL_INT(4, delta_encode(buf, sizeof(buf), values,
+                                          ARRAY_LEN(values)));
+}
+
+static void test_column_truncated(void)
+{
+    static const int32_t values[] = { 100000, -100000, 5 };
+    uint8_t buf[DELTA_COLUMN_MAXLEN(ARRAY_LEN(values))];
+    int32_t out[ARRAY_LEN(values)];
+
+    int len = delta_encode(buf, sizeof(buf), values, ARRAY_LEN(values));
+    TEST_ASSERT(len > 0);
+    for (int cut = 0; cut < len; cut++) {
+        TEST_ASSERT_EQUAL_INT(-EBADMSG,
+                              delta_decode(out, ARRAY_LEN(out), buf, cut));
+    }
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, delta_encode(buf, len - 1, values,
+                                                   ARRAY_LEN(values)));
+}
+
+Test *tests_delta_codec_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_zigzag_extremes),
+        new_TestFixture(test_varint_lengths),
+        new_TestFixture(test_varint_max),
+        new_TestFixture(test_varint_put_overflow),
+        new_TestFixture(test_varint_get_truncated),
+        new_TestFixture(test_varint_get_too_long),
+        new_TestFixture(test_varint_get_stray_bits),
+        new_TestFixture(test_column_round_trip),
+        new_TestFixture(test_column_small_steps),
+        new_TestFixture(test_column_truncated),
+    };
+
+    EMB_UNIT_TESTCALLER(delta_codec_tests, NULL, NULL, fixtures);
+
+    return (Test *)&delta_codec_tests;
+}
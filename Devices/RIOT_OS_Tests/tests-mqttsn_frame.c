@@ -0,0 +1,152 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       Unit tests of the mqttsn_frame module
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "mqttsn_frame.h"
+#include "tests.h"
+
+static void test_hdr_length_switch(void)
+{
+    /* 255 bytes in total still fit the one byte length */
+    uint8_t buf[MQTTSN_FRAME_HDR_MAXLEN];
+
+    TEST_ASSERT_EQUAL_INT(2, mqttsn_frame_hdr(buf, 0, MQTTSN_FRAME_PINGREQ));
+    TEST_ASSERT_EQUAL_INT(0x02, buf[0]);
+    TEST_ASSERT_EQUAL_INT(MQTTSN_FRAME_PINGREQ, buf[1]);
+
+    TEST_ASSERT_EQUAL_INT(2, mqttsn_frame_hdr(buf, 253, MQTTSN_FRAME_PUBLISH));
+    TEST_ASSERT_EQUAL_INT(0xff, buf[0]);
+
+    TEST_ASSERT_EQUAL_INT(4, mqttsn_frame_hdr(buf, 254, MQTTSN_FRAME_PUBLISH));
+    TEST_ASSERT_EQUAL_INT(0x01, buf[0]);
+    TEST_ASSERT_EQUAL_INT(0x01, buf[1]);
+    TEST_ASSERT_EQUAL_INT(0x02, buf[2]);
+    TEST_ASSERT_EQUAL_INT(MQTTSN_FRAME_PUBLISH, buf[3]);
+}
+
+static void test_connect(void)
+{
+    static const uint8_t expected[] = {
+        0x0b, MQTTSN_FRAME_CONNECT, 0x04, MQTTSN_FRAME_PROTOCOL_ID,
+        0x01, 0x2c, 'n', 'o', 'd', 'e', '1',
+    };
+    uint8_t buf[MQTTSN_FRAME_CONNECT_LEN(5)];
+
+    TEST_ASSERT_EQUAL_INT(sizeof(expected),
+                          mqttsn_frame_connect(buf, 0x04, 300, "node1"));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, expected, sizeof(expected)));
+}
+
+static void test_pub_hdr(void)
+{
+    static const uint8_t short_hdr[] = {
+        0x0a, MQTTSN_FRAME_PUBLISH, 0x21, 0x00, 0x2a, 0x12, 0x34,
+    };
+    static const uint8_t long_hdr[] = {
+        0x01, 0x01, 0x0f, MQTTSN_FRAME_PUBLISH, 0x61, 0x00, 0x2a, 0x00, 0x00,
+    };
+    uint8_t buf[MQTTSN_FRAME_PUB_HDR_MAXLEN];
+
+    TEST_ASSERT_EQUAL_INT(sizeof(short_hdr), mqttsn_frame_pub_hdrlen(3));
+    TEST_ASSERT_EQUAL_INT(sizeof(short_hdr),
+                          mqttsn_frame_pub(buf, 3, 0x21, 42, 0x1234));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, short_hdr, sizeof(short_hdr)));
+
+    /* 248 payload bytes are the last ones with the short length */
+    TEST_ASSERT_EQUAL_INT(sizeof(short_hdr), mqttsn_frame_pub_hdrlen(248));
+    TEST_ASSERT_EQUAL_INT(sizeof(long_hdr), mqttsn_frame_pub_hdrlen(249));
+    TEST_ASSERT_EQUAL_INT(sizeof(long_hdr),
+                          mqttsn_frame_pub(buf, 262, 0x61, 42, 0));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, long_hdr, sizeof(long_hdr)));
+}
+
+static void test_set_dup(void)
+{
+    uint8_t buf[MQTTSN_FRAME_PUB_HDR_MAXLEN];
+
+    mqttsn_frame_pub(buf, 3, 0x20, 1, 1);
+    mqttsn_frame_set_dup(buf);
+    TEST_ASSERT_EQUAL_INT(0xa0, buf[2]);
+
+    mqttsn_frame_pub(buf, 300, 0x20, 1, 1);
+    mqttsn_frame_set_dup(buf);
+    TEST_ASSERT_EQUAL_INT(0xa0, buf[4]);
+}
+
+static void test_parse(void)
+{
+    static const uint8_t puback[] = {
+        0x07, MQTTSN_FRAME_PUBACK, 0x00, 0x2a, 0x12, 0x34, 0x00, 0xee,
+    };
+    static const uint8_t longmsg[] = {
+        0x01, 0x00, 0x06, MQTTSN_FRAME_PUBLISH, 0x55, 0x66,
+    };
+    const uint8_t *body;
+    uint8_t type;
+
+    /* trailing bytes of the datagram are ignored */
+    TEST_ASSERT_EQUAL_INT(5, mqttsn_frame_parse(puback, sizeof(puback),
+                                                &type, &body));
+    TEST_ASSERT_EQUAL_INT(MQTTSN_FRAME_PUBACK, type);
+    TEST_ASSERT(body == &puback[2]);
+
+    TEST_ASSERT_EQUAL_INT(2, mqttsn_frame_parse(longmsg, sizeof(longmsg),
+                                                &type, &body));
+    TEST_ASSERT_EQUAL_INT(MQTTSN_FRAME_PUBLISH, type);
+    TEST_ASSERT(body == &longmsg[4]);
+}
+
+static void test_parse_malformed(void)
+{
+    static const uint8_t cut[] = { 0x07, MQTTSN_FRAME_PUBACK, 0x00 };
+    static const uint8_t tiny[] = { 0x01, MQTTSN_FRAME_PINGRESP };
+    static const uint8_t zero[] = { 0x00, MQTTSN_FRAME_PINGRESP };
+    static const uint8_t longcut[] = { 0x01, 0x01, 0x00, MQTTSN_FRAME_PUBLISH };
+    const uint8_t *body;
+    uint8_t type;
+
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, mqttsn_frame_parse(cut, 1, &type, &body));
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, mqttsn_frame_parse(cut, sizeof(cut),
+                                                       &type, &body));
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, mqttsn_frame_parse(tiny, sizeof(tiny),
+                                                       &type, &body));
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, mqttsn_frame_parse(zero, sizeof(zero),
+                                                       &type, &body));
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, mqttsn_frame_parse(longcut,
+                                                       sizeof(longcut),
+                                                       &type, &body));
+}
+
+Test *tests_mqttsn_frame_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_hdr_length_switch),
+        new_TestFixture(test_connect),
+        new_TestFixture(test_pub_hdr),
+        new_TestFixture(test_set_dup),
+        new_TestFixture(test_parse),
+        new_TestFixture(test_parse_malformed),
+    };
+
+    EMB_UNIT_TESTCALLER(mqttsn_frame_tests, NULL, NULL, fixtures);
+
+    return (Test *)&mqttsn_frame_tests;
+}
@@ -0,0 +1,97 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       Unit tests of the on-demand reading of the sensor_cache module
+ *
+ * The Makefile sets SENSOR_CACHE_IDLE to 300 ms. The thread is started
+ * once, so the fixtures run in order and share it.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+
+#include "embUnit.h"
+#include "ztimer.h"
+
+#include "sensor_cache.h"
+#include "tests.h"
+
+#define READING     (2150)
+
+static volatile unsigned calls;
+
+static int _read(fixp_t *v)
+{
+    calls++;
+    *v = READING;
+    return 0;
+}
+
+static void test_idle_without_consumer(void)
+{
+    sensor_cache_init(_read);
+    ztimer_sleep(ZTIMER_MSEC, 3 * SENSOR_CACHE_PERIOD);
+    TEST_ASSERT_EQUAL_INT(0, calls);
+}
+
+static void test_first_request_wakes(void)
+{
+    fixp_t v = 0;
+
+    /* nothing read yet, the caller reads the sensor itself */
+    TEST_ASSERT_EQUAL_INT(-EAGAIN, sensor_cache_get(&v, NULL));
+    ztimer_sleep(ZTIMER_MSEC, SENSOR_CACHE_PERIOD * 5 / 2);
+    TEST_ASSERT(calls >= 2);
+    TEST_ASSERT_EQUAL_INT(0, sensor_cache_get(&v, NULL));
+    TEST_ASSERT_EQUAL_INT(READING, v);
+}
+
+static void test_reading_returned_once(void)
+{
+    uint32_t seq = 0;
+    fixp_t v;
+
+    TEST_ASSERT_EQUAL_INT(0, sensor_cache_get_new(&v, &seq));
+    TEST_ASSERT(seq > 0);
+    TEST_ASSERT_EQUAL_INT(-EAGAIN, sensor_cache_get_new(&v, &seq));
+}
+
+static void test_pauses_when_unused(void)
+{
+    fixp_t v;
+
+    ztimer_sleep(ZTIMER_MSEC, SENSOR_CACHE_IDLE + 2 * SENSOR_CACHE_PERIOD);
+    unsigned n = calls;
+    ztimer_sleep(ZTIMER_MSEC, 3 * SENSOR_CACHE_PERIOD);
+    TEST_ASSERT_EQUAL_INT(n, calls);
+
+    /* and reads again once asked */
+    sensor_cache_get(&v, NULL);
+    ztimer_sleep(ZTIMER_MSEC, SENSOR_CACHE_PERIOD * 3 / 2);
+    TEST_ASSERT(calls > n);
+}
+
+Test *tests_sensor_cache_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_idle_without_consumer),
+        new_TestFixture(test_first_request_wakes),
+        new_TestFixture(test_reading_returned_once),
+        new_TestFixture(test_pauses_when_unused),
+    };
+
+    EMB_UNIT_TESTCALLER(sensor_cache_tests, NULL, NULL, fixtures);
+
+    return (Test *)&sensor_cache_tests;
+}
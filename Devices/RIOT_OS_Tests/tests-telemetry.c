@@ -0,0 +1,204 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       Unit tests of the telemetry module
+ *
+ * The expected records are also decoded by Gateway/telemetry_test.js, keep
+ * both in sync.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "telemetry.h"
+#include "tests.h"
+
+#define ARRAY_LEN(a)    (sizeof(a) / sizeof((a)[0]))
+
+/* device 1 at 1700000000 s, -12.34 °C and 56.78 % */
+static const uint8_t bin_record[] = {
+    0x01, 0x01, 0x65, 0x53, 0xf1, 0x00, 0x03, 0xfb, 0x2e, 0x16, 0x2e,
+};
+
+/* device 2 at 1 s, -400.00 °C and 700.00 mm/h do not fit into 16 bit */
+static const uint8_t bin_saturated[] = {
+    0x01, 0x02, 0x00, 0x00, 0x00, 0x01, 0x11, 0x80, 0x00, 0xff, 0xff,
+};
+
+/* device 3, one sample a minute from 1700000000 s: 21.50, 21.49, -0.05 and
+ * -0.05 °C */
+static const uint8_t delta_record[] = {
+    0x02, 0x03, 0x04, 0x01, 0x80, 0xc4, 0x9f, 0xd5, 0x0c, 0x78, 0x78, 0x78,
+    0xcc, 0x21, 0x01, 0xd3, 0x21, 0x00,
+};
+static const int32_t delta_temp[] = { 2150, 2149, -5, -5 };
+
+static void _sample(telemetry_sample_t *s)
+{
+    telemetry_sample_init(s, 1, 1700000000UL);
+    telemetry_sample_set(s, TELEMETRY_TEMPERATURE, -1234);
+    telemetry_sample_set(s, TELEMETRY_HUMIDITY, 5678);
+}
+
+static void _delta_batch(telemetry_batch_t *b)
+{
+    telemetry_sample_t s;
+
+    telemetry_batch_clear(b);
+    for (unsigned i = 0; i < ARRAY_LEN(delta_temp); i++) {
+        telemetry_sample_init(&s, 3, 1700000000UL + (i * 60));
+        telemetry_sample_set(&s, TELEMETRY_TEMPERATURE, delta_temp[i]);
+        telemetry_batch_add(b, &s);
+    }
+}
+
+static void test_bin_encode(void)
+{
+    telemetry_sample_t s;
+    uint8_t buf[TELEMETRY_BIN_MAXLEN];
+
+    _sample(&s);
+    TEST_ASSERT_EQUAL_INT(sizeof(bin_record),
+                          telemetry_bin_encode(buf, sizeof(buf), &s));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, bin_record, sizeof(bin_record)));
+}
+
+static void test_bin_saturate(void)
+{
+    telemetry_sample_t s;
+    uint8_t buf[TELEMETRY_BIN_MAXLEN];
+
+    telemetry_sample_init(&s, 2, 1);
+    telemetry_sample_set(&s, TELEMETRY_TEMPERATURE, -40000);
+    telemetry_sample_set(&s, TELEMETRY_RAIN_HEIGHT, 70000);
+    TEST_ASSERT_EQUAL_INT(sizeof(bin_saturated),
+                          telemetry_bin_encode(buf, sizeof(buf), &s));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, bin_saturated, sizeof(bin_saturated)));
+}
+
+static void test_bin_overflow(void)
+{
+    telemetry_sample_t s;
+    uint8_t buf[TELEMETRY_BIN_MAXLEN];
+
+    _sample(&s);
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, telemetry_bin_encode(buf, 0, &s));
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, telemetry_bin_encode(buf,
+                                                           sizeof(bin_record) - 1,
+                                                           &s));
+}
+
+static void test_bin_round_trip(void)
+{
+    telemetry_sample_t s, out;
+
+    _sample(&s);
+    memset(&out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL_INT(sizeof(bin_record),
+                          telemetry_bin_decode(&out, bin_record,
+                                               sizeof(bin_record)));
+    TEST_ASSERT(out.ts == s.ts);
+    TEST_ASSERT_EQUAL_INT(s.device, out.device);
+    TEST_ASSERT_EQUAL_INT(s.mask, out.mask);
+    TEST_ASSERT_EQUAL_INT(-1234, out.value[TELEMETRY_TEMPERATURE]);
+    TEST_ASSERT_EQUAL_INT(5678, out.value[TELEMETRY_HUMIDITY]);
+}
+
+static void test_bin_decode_truncated(void)
+{
+    telemetry_sample_t out;
+
+    for (size_t cut = 0; cut < sizeof(bin_record); cut++) {
+        TEST_ASSERT_EQUAL_INT(-EBADMSG,
+                              telemetry_bin_decode(&out, bin_record, cut));
+    }
+}
+
+static void test_json_encode(void)
+{
+    static const char expected[] = "{\"ts\": 1700000000000, \"values\":"
+                                   "{\"device\": \"1\",\"temperature\": "
+                                   "\"-12.34\", \"humidity\": \"56.78\"}}";
+    telemetry_sample_t s;
+    char buf[TELEMETRY_JSON_MAXLEN];
+
+    _sample(&s);
+    TEST_ASSERT_EQUAL_INT(strlen(expected),
+                          telemetry_json_encode(buf, sizeof(buf), &s));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+}
+
+static void test_delta_encode(void)
+{
+    telemetry_batch_t b;
+    uint8_t buf[64];
+
+    _delta_batch(&b);
+    TEST_ASSERT_EQUAL_INT(sizeof(delta_record),
+                          telemetry_batch_delta_encode(buf, sizeof(buf), &b));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, delta_record, sizeof(delta_record)));
+}
+
+static void test_delta_round_trip(void)
+{
+    telemetry_batch_t b, out;
+
+    _delta_batch(&b);
+    memset(&out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL_INT(sizeof(delta_record),
+                          telemetry_batch_delta_decode(&out, delta_record,
+                                                       sizeof(delta_record)));
+    TEST_ASSERT_EQUAL_INT(b.numof, out.numof);
+    for (unsigned i = 0; i < b.numof; i++) {
+        TEST_ASSERT(out.sample[i].ts == b.sample[i].ts);
+        TEST_ASSERT_EQUAL_INT(3, out.sample[i].device);
+        TEST_ASSERT_EQUAL_INT(b.sample[i].mask, out.sample[i].mask);
+        TEST_ASSERT_EQUAL_INT(delta_temp[i],
+                              out.sample[i].value[TELEMETRY_TEMPERATURE]);
+    }
+}
+
+static void test_delta_mixed_fields(void)
+{
+    telemetry_batch_t b;
+    telemetry_sample_t s;
+    uint8_t buf[64];
+
+    _delta_batch(&b);
+    _sample(&s);
+    telemetry_batch_add(&b, &s);
+    TEST_ASSERT_EQUAL_INT(-EINVAL,
+                          telemetry_batch_delta_encode(buf, sizeof(buf), &b));
+}
+
+Test *tests_telemetry_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_bin_encode),
+        new_TestFixture(test_bin_saturate),
+        new_TestFixture(test_bin_overflow),
+        new_TestFixture(test_bin_round_trip),
+        new_TestFixture(test_bin_decode_truncated),
+        new_TestFixture(test_json_encode),
+        new_TestFixture(test_delta_encode),
+        new_TestFixture(test_delta_round_trip),
+        new_TestFixture(test_delta_mixed_fields),
+    };
+
+    EMB_UNIT_TESTCALLER(telemetry_tests, NULL, NULL, fixtures);
+
+    return (Test *)&telemetry_tests;
+}
@@ -0,0 +1,56 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     examples
+ * @{
+ *
+ * @file
+ * @brief       Unit test suites of the shared modules
+ *
+ * @}
+ */
+
+#ifndef TESTS_H
+#define TESTS_H
+
+#include "embUnit.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   delta_codec: zigzag, varint and column round trips
+ */
+Test *tests_delta_codec_tests(void);
+
+/**
+ * @brief   telemetry: binary, JSON and delta records against fixed bytes
+ */
+Test *tests_telemetry_tests(void);
+
+/**
+ * @brief   aggwin: min, max, rounded mean and JSON of known sequences
+ */
+Test *tests_aggwin_tests(void);
+
+/**
+ * @brief   sensor_cache: no reads without a consumer, waking up and pausing
+ */
+Test *tests_sensor_cache_tests(void);
+
+/**
+ * @brief   mqttsn_frame: headers at the length switch, parsing bad lengths
+ */
+Test *tests_mqttsn_frame_tests(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_H */
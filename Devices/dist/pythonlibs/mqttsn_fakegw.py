@@ -0,0 +1,309 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+"""A scriptable MQTT-SN gateway for the native tests of the RIOT clients.
+
+It speaks just enough MQTT-SN v1.2 for emcute, pubwin, sleepcl, qosm1 and the
+virtual clients of RIOT_OS_LoadGen: CONNECT, REGISTER, PUBLISH with QoS -1 to
+2, SUBSCRIBE, UNSUBSCRIBE, PINGREQ and DISCONNECT, including the sleeping
+client states.
+Every message is counted, so a test can check what went over the air, and
+stop() drops all sessions like a crashed gateway: a client that publishes to
+the restarted gateway without a new CONNECT gets a DISCONNECT, and its
+subscriptions are gone until it subscribes again.
+
+The tests run the firmware on native and expect the host side of the tap
+bridge to have the address given in GW_ADDR, fec0:affe::1 by default:
+
+    sudo ./dist/tools/tapsetup/tapsetup
+    sudo ip a a fec0:affe::1/64 dev tapbr0
+
+Run on its own, it prints every message:
+
+    ./mqttsn_fakegw.py [addr] [port]
+"""
+
+import collections
+import os
+import pexpect
+import socket
+import sys
+import threading
+import time
+
+GW_ADDR = os.environ.get('GW_ADDR', 'fec0:affe::1')
+GW_PORT = int(os.environ.get('GW_PORT', '1885'))
+NODE_ADDR = os.environ.get('NODE_ADDR', 'fec0:affe::99')
+
+CONNECT = 0x04
+CONNACK = 0x05
+REGISTER = 0x0a
+REGACK = 0x0b
+PUBLISH = 0x0c
+PUBACK = 0x0d
+PUBCOMP = 0x0e
+PUBREC = 0x0f
+PUBREL = 0x10
+SUBSCRIBE = 0x12
+SUBACK = 0x13
+UNSUBSCRIBE = 0x14
+UNSUBACK = 0x15
+PINGREQ = 0x16
+PINGRESP = 0x17
+DISCONNECT = 0x18
+
+NAMES = {
+    CONNECT: 'CONNECT', CONNACK: 'CONNACK', REGISTER: 'REGISTER',
+    REGACK: 'REGACK', PUBLISH: 'PUBLISH', PUBACK: 'PUBACK',
+    PUBCOMP: 'PUBCOMP', PUBREC: 'PUBREC', PUBREL: 'PUBREL',
+    SUBSCRIBE: 'SUBSCRIBE', SUBACK: 'SUBACK', UNSUBSCRIBE: 'UNSUBSCRIBE',
+    UNSUBACK: 'UNSUBACK', PINGREQ: 'PINGREQ',
+    PINGRESP: 'PINGRESP', DISCONNECT: 'DISCONNECT',
+}
+
+QOS_MASK = 0x60
+QOS_M1 = 0x60
+TIT_MASK = 0x03
+TIT_NORMAL = 0x00
+CLEAN_SESSION = 0x04
+
+# topic IDs handed out by REGISTER and SUBSCRIBE, above the predefined ones
+FIRST_TOPIC_ID = 100
+
+
+def frame(msg_type, body=b''):
+    """One MQTT-SN message with the short or the 3 byte length."""
+    if len(body) + 2 > 0xff:
+        return bytes([0x01, (len(body) + 4) >> 8, (len(body) + 4) & 0xff,
+                      msg_type]) + body
+    return bytes([len(body) + 2, msg_type]) + body
+
+
+def parse(data):
+    """Message type and body of one datagram, None if it is malformed."""
+    if len(data) >= 4 and data[0] == 0x01:
+        length, pos = (data[1] << 8) | data[2], 3
+    elif len(data) >= 2:
+        length, pos = data[0], 1
+    else:
+        return None
+    if length < pos + 1 or length > len(data):
+        return None
+    return data[pos], data[pos + 1:length]
+
+
+class Session:
+    def __init__(self, client_id):
+        self.client_id = client_id
+        self.asleep = False
+        self.downlinks = []     # (topic id, payload) kept while asleep
+        self.topics = set()     # subscribed topic IDs
+
+
+class FakeGateway:
+    def __init__(self, addr=GW_ADDR, port=GW_PORT, verbose=False):
+        self.addr = addr
+        self.port = port
+        self.verbose = verbose
+        self.lock = threading.Condition()
+        self.sock = None
+        self.thread = None
+        self.topics = {}        # name -> id, survives a restart
+        self.sessions = {}      # (addr, port) -> Session
+        self.counts = collections.Counter()
+        self.published = []     # (client id, topic id, qos, payload)
+        self.rejected = 0       # PUBLISH from clients without a session
+
+    def start(self):
+        self.sessions = {}
+        self.sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind((self.addr, self.port))
+        self.sock.settimeout(0.1)
+        self.running = True
+        self.thread = threading.Thread(target=self._run, daemon=True)
+        self.thread.start()
+        return self
+
+    def stop(self):
+        """Stops answering and forgets every session, like a crash."""
+        self.running = False
+        self.thread.join()
+        self.sock.close()
+        with self.lock:
+            self.sessions = {}
+
+    def reset(self):
+        with self.lock:
+            self.counts.clear()
+            self.published = []
+            self.rejected = 0
+
+    def count(self, msg_type):
+        with self.lock:
+            return self.counts[msg_type]
+
+    def wait_for(self, cond, timeout=10):
+        """Waits until cond() holds, cond is called with the lock held."""
+        with self.lock:
+            return self.lock.wait_for(cond, timeout)
+
+    def queue(self, client_id, topic, payload):
+        """A PUBLISH for a client subscribed to topic, sent at once or on
+        its next PINGREQ or CONNECT."""
+        with self.lock:
+            tid = self._topic_id(topic)
+            for ep, s in self.sessions.items():
+                if s.client_id != client_id or tid not in s.topics:
+                    continue
+                if s.asleep:
+                    s.downlinks.append((tid, payload))
+                else:
+                    self._downlink(ep, tid, payload)
+
+    def _topic_id(self, name):
+        if name not in self.topics:
+            self.topics[name] = FIRST_TOPIC_ID + len(self.topics)
+        return self.topics[name]
+
+    def _send(self, ep, msg_type, body=b''):
+        self.sock.sendto(frame(msg_type, body), ep)
+
+    def _downlink(self, ep, tid, payload):
+        self._send(ep, PUBLISH, bytes([0x00, tid >> 8, tid & 0xff, 0, 0]) +
+                   payload)
+
+    def _run(self):
+        while self.running:
+            try:
+                data, ep = self.sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            except OSError:
+                break
+            msg = parse(data)
+            if msg is None:
+                continue
+            with self.lock:
+                self._handle(ep, msg[0], msg[1])
+                self.lock.notify_all()
+
+    def _handle(self, ep, msg_type, body):
+        self.counts[msg_type] += 1
+        session = self.sessions.get(ep[:2])
+        if self.verbose:
+            print('gw: {} from {} {}'.format(NAMES.get(msg_type, hex(msg_type)),
+                                              session.client_id if session
+                                              else ep[0], body.hex()),
+                  flush=True)
+
+        if msg_type == CONNECT and len(body) >= 4:
+            s = Session(body[4:].decode(errors='replace'))
+            old = [k for k, v in self.sessions.items()
+                   if v.client_id == s.client_id]
+            for k in old:
+                # a sleeping client wakes up with CONNECT and gets the
+                # messages kept for it, without CleanSession it keeps its
+                # subscriptions as well
+                prev = self.sessions.pop(k)
+                s.downlinks = prev.downlinks
+                if not body[0] & CLEAN_SESSION:
+                    s.topics = prev.topics
+            self.sessions[ep[:2]] = s
+            self._send(ep, CONNACK, b'\x00')
+            for tid, payload in s.downlinks:
+                self._downlink(ep, tid, payload)
+            s.downlinks = []
+        elif msg_type == REGISTER and len(body) >= 4:
+            tid = self._topic_id(body[4:].decode(errors='replace'))
+            self._send(ep, REGACK, bytes([tid >> 8, tid & 0xff]) +
+                       body[2:4] + b'\x00')
+        elif msg_type == PUBLISH and len(body) >= 5:
+            flags = body[0]
+            qos = flags & QOS_MASK
+            if session is None and qos != QOS_M1:
+                # the session was lost, the client has to connect again
+                self.rejected += 1
+                self._send(ep, DISCONNECT)
+                return
+            tid = (body[1] << 8) | body[2]
+            self.published.append((session.client_id if session else None,
+                                   tid, -1 if qos == QOS_M1 else qos >> 5,
+                                   bytes(body[5:])))
+            if qos == 0x20:
+                self._send(ep, PUBACK, body[1:5] + b'\x00')
+            elif qos == 0x40:
+                self._send(ep, PUBREC, body[3:5])
+        elif msg_type == PUBREL and len(body) >= 2:
+            self._send(ep, PUBCOMP, body[0:2])
+        elif msg_type == SUBSCRIBE and len(body) >= 3:
+            flags = body[0]
+            if (flags & TIT_MASK) == TIT_NORMAL:
+                tid = self._topic_id(body[3:].decode(errors='replace'))
+            else:
+                tid = (body[3] << 8) | body[4]
+            if session is not None:
+                session.topics.add(tid)
+            self._send(ep, SUBACK, bytes([flags & QOS_MASK, tid >> 8,
+                                          tid & 0xff]) + body[1:3] + b'\x00')
+        elif msg_type == UNSUBSCRIBE and len(body) >= 3:
+            if session is not None and len(body) >= 5:
+                flags = body[0]
+                if (flags & TIT_MASK) == TIT_NORMAL:
+                    name = body[3:].decode(errors='replace')
+                    session.topics.discard(self.topics.get(name))
+                else:
+                    session.topics.discard((body[3] << 8) | body[4])
+            self._send(ep, UNSUBACK, body[1:3])
+        elif msg_type == PINGREQ:
+            if len(body) > 0:
+                # a sleeping client polls for the messages kept for it
+                cid = body.decode(errors='replace')
+                for s in self.sessions.values():
+                    if s.client_id == cid:
+                        for tid, payload in s.downlinks:
+                            self._downlink(ep, tid, payload)
+                        s.downlinks = []
+            self._send(ep, PINGRESP)
+        elif msg_type == DISCONNECT:
+            if session is not None and len(body) >= 2:
+                session.asleep = True
+            else:
+                self.sessions.pop(ep[:2], None)
+            self._send(ep, DISCONNECT)
+
+
+def node_ifconfig(child, addr=NODE_ADDR):
+    """Gives the first interface of a native node a global address."""
+    child.sendline('ifconfig')
+    child.expect(r'Iface\s+(\d+)')
+    iface = child.match.group(1)
+    child.sendline('ifconfig {} add {}'.format(iface, addr))
+    child.expect_exact('success')
+
+
+def shell_poll(child, cmd, pattern, timeout=30, interval=1):
+    """Runs cmd until its output matches pattern, returns the match."""
+    deadline = time.time() + timeout
+    while True:
+        child.sendline(cmd)
+        try:
+            child.expect(pattern, timeout=interval)
+            return child.match
+        except pexpect.TIMEOUT:
+            if time.time() > deadline:
+                raise
+
+
+if __name__ == '__main__':
+    gw = FakeGateway(sys.argv[1] if len(sys.argv) > 1 else GW_ADDR,
+                     int(sys.argv[2]) if len(sys.argv) > 2 else GW_PORT,
+                     verbose=True).start()
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        gw.stop()
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+"""Helpers for the native tests that run against the real Paho gateway.
+
+mqttsn_fakegw.py implements the MQTT-SN side the way the clients expect it,
+so it cannot show where the clients and the Paho gateway disagree. The tests
+that use this module talk to Gateway/MQTT-SNGateway instead, started with
+Gateway/gateway.conf next to a mosquitto on port 1884, and only run when
+PAHO_GW gives the address of that gateway:
+
+    PAHO_GW=fec0:affe::1 make test
+
+PAHO_PORT and BROKER (host:port, localhost:1884 by default) change the other
+ends. The tests publish downlinks to the broker with mqtt_publish(), so no
+MQTT client library is needed.
+"""
+
+import os
+import socket
+import struct
+
+PAHO_GW = os.environ.get('PAHO_GW')
+PAHO_PORT = int(os.environ.get('PAHO_PORT', '1885'))
+BROKER = os.environ.get('BROKER', 'localhost:1884')
+
+
+def enabled():
+    """True if a Paho gateway was given, tests skip themselves otherwise."""
+    if PAHO_GW is None:
+        print('PAHO_GW not set, skipping the test against the Paho gateway')
+        return False
+    return True
+
+
+def _packet(ptype, body):
+    """One MQTT 3.1.1 packet with the variable length remaining length."""
+    length = b''
+    n = len(body)
+    while True:
+        n, digit = n >> 7, n & 0x7f
+        length += bytes([digit | (0x80 if n else 0)])
+        if not n:
+            return bytes([ptype]) + length + body
+
+
+def _string(s):
+    b = s.encode()
+    return struct.pack('!H', len(b)) + b
+
+
+def mqtt_publish(topic, payload, broker=BROKER):
+    """Publishes one QoS 0 message to the broker behind the gateway."""
+    host, port = broker.rsplit(':', 1)
+    with socket.create_connection((host, int(port)), timeout=5) as s:
+        # protocol level 4, clean session, keep alive 10 s
+        s.sendall(_packet(0x10, _string('MQTT') + b'\x04\x02\x00\x0a' +
+                          _string('riot-test')))
+        ack = s.recv(4)
+        if len(ack) < 4 or ack[0] != 0x20 or ack[3] != 0:
+            raise ConnectionError('broker refused the connection')
+        s.sendall(_packet(0x30, _string(topic) + payload))
+        s.sendall(_packet(0xe0, b''))
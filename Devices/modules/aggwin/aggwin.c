@@ -0,0 +1,298 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     aggwin
+ * @{
+ *
+ * @file
+ * @brief       Windowed aggregation implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mutex.h"
+#include "thread.h"
+#include "net/emcute.h"
+
+#include "aggwin.h"
+#include "periodic.h"
+#include "topic_cache.h"
+
+#define TASK_SAMPLE         (0U)
+#define TASK_REPORT         (1U)
+
+static char stack[THREAD_STACKSIZE_DEFAULT];
+static kernel_pid_t pid = KERNEL_PID_UNDEF;
+static aggwin_read_cb_t read_cb;
+static const char *field_name;
+static uint8_t device_nr;
+
+static char topic[TOPIC_CACHE_NAME_MAXLEN];
+static unsigned flags;
+static uint32_t sample_period;      /* ms */
+static uint32_t report_period;      /* ms */
+static volatile bool running;
+/* locked while stopped, the thread waits on it */
+static mutex_t gate = MUTEX_INIT_LOCKED;
+
+/* thread state */
+static periodic_task_t tasks[2];
+static aggwin_t window;
+static uint32_t read_errors;
+static uint32_t no_new;
+static uint32_t reports;
+static uint32_t failed;
+static char payload[AGGWIN_PAYLOAD_MAXLEN];
+
+void aggwin_reset(aggwin_t *w)
+{
+    w->min = INT32_MAX;
+    w->max = INT32_MIN;
+    w->last = 0;
+    w->sum = 0;
+    w->count = 0;
+}
+
+void aggwin_add(aggwin_t *w, fixp_t v)
+{
+    if (v < w->min) {
+        w->min = v;
+    }
+    if (v > w->max) {
+        w->max = v;
+    }
+    w->last = v;
+    w->sum += v;
+    w->count++;
+}
+
+fixp_t aggwin_mean(const aggwin_t *w)
+{
+    if (w->count == 0) {
+        return 0;
+    }
+    /* round half away from zero, the sum may be negative */
+    int64_t half = w->count / 2;
+    return (fixp_t)(((w->sum < 0) ? (w->sum - half) : (w->sum + half)) /
+                    (int64_t)w->count);
+}
+
+int aggwin_json(char *buf, size_t len, const aggwin_t *w, const char *field,
+                uint8_t device, uint64_t ts)
+{
+    char min[FIXP_FMT_MAXLEN];
+    char max[FIXP_FMT_MAXLEN];
+    char mean[FIXP_FMT_MAXLEN];
+    char last[FIXP_FMT_MAXLEN];
+
+    fixp_to_str(min, w->min, 2);
+    fixp_to_str(max, w->max, 2);
+    fixp_to_str(mean, aggwin_mean(w), 2);
+    fixp_to_str(last, w->last, 2);
+
+    int res = snprintf(buf, len, "{\"ts\": %llu, \"values\": {\"device\": \"%u\", "
+                       "\"%s_min\": \"%s\", \"%s_max\": \"%s\", "
+                       "\"%s_mean\": \"%s\", \"%s_last\": \"%s\", "
+                       "\"%s_count\": %lu}}",
+                       (unsigned long long)ts, device, field, min, field, max,
+                       field, mean, field, last, field,
+                       (unsigned long)w->count);
+    if ((res < 0) || ((size_t)res >= len)) {
+        return -EOVERFLOW;
+    }
+    return res;
+}
+
+static void _sample(void *arg);
+static void _report(void *arg);
+
+static void _wait_for_start(void)
+{
+    mutex_lock(&gate);
+    mutex_unlock(&gate);
+
+    aggwin_reset(&window);
+    read_errors = 0;
+    no_new = 0;
+    reports = 0;
+    failed = 0;
+    periodic_init(&tasks[TASK_SAMPLE], "agg sample", sample_period, _sample, NULL);
+    periodic_init(&tasks[TASK_REPORT], "agg report", report_period, _report, NULL);
+}
+
+static void _sample(void *arg)
+{
+    (void)arg;
+    fixp_t v;
+
+    if (!running) {
+        _wait_for_start();
+        return;
+    }
+    int res = read_cb(&v);
+    if (res == -EAGAIN) {
+        no_new++;
+        return;
+    }
+    if (res != 0) {
+        read_errors++;
+        return;
+    }
+    aggwin_add(&window, v);
+}
+
+static void _report(void *arg)
+{
+    (void)arg;
+
+    if (!running) {
+        return;
+    }
+    if (window.count == 0) {
+        puts("agg: no readings in this window, nothing to report");
+        return;
+    }
+
+    int len = aggwin_json(payload, sizeof(payload), &window, field_name,
+                          device_nr, (uint64_t)time(NULL) * 1000);
+    aggwin_reset(&window);
+    if (len < 0) {
+        puts("agg: report does not fit into the payload");
+        failed++;
+        return;
+    }
+
+    emcute_topic_t t;
+    unsigned f = flags;
+    if ((topic_cache_get(&t, &f, topic) != EMCUTE_OK) ||
+        (emcute_pub(&t, payload, len, f) != EMCUTE_OK)) {
+        printf("agg: unable to publish to %s\n", topic);
+        failed++;
+        return;
+    }
+    reports++;
+}
+
+static void *_thread(void *arg)
+{
+    (void)arg;
+
+    _wait_for_start();
+    /* _sample() waits in here while the command is stopped */
+    periodic_run(tasks, 2);
+
+    return NULL;
+}
+
+void aggwin_init(aggwin_read_cb_t cb, const char *field, uint8_t device)
+{
+    read_cb = cb;
+    field_name = field;
+    device_nr = device;
+}
+
+static unsigned _get_qos(const char *str)
+{
+    switch (atoi(str)) {
+        case 1:     return EMCUTE_QOS_1;
+        case 2:     return EMCUTE_QOS_2;
+        default:    return EMCUTE_QOS_0;
+    }
+}
+
+static int _start(int argc, char **argv)
+{
+    if (running) {
+        puts("error: agg is already running, stop it first");
+        return 1;
+    }
+    if (strlen(argv[0]) >= sizeof(topic)) {
+        puts("error: topic name exceeds maximum possible size");
+        return 1;
+    }
+    uint32_t sample = (argc >= 2) ? (unsigned)atoi(argv[1]) : AGGWIN_SAMPLE_PERIOD;
+    uint32_t report = (argc >= 3) ? (unsigned)atoi(argv[2]) : AGGWIN_REPORT_PERIOD;
+    if ((sample == 0) || (report == 0) || (report * 1000 < sample)) {
+        puts("error: sample ms and report s have to be positive, one report "
+             "at least one sample long");
+        return 1;
+    }
+
+    strcpy(topic, argv[0]);
+    flags = (argc >= 4) ? _get_qos(argv[3]) : EMCUTE_QOS_0;
+    sample_period = sample;
+    report_period = report * 1000;
+
+    if (pid == KERNEL_PID_UNDEF) {
+        pid = thread_create(stack, sizeof(stack), THREAD_PRIORITY_MAIN - 1,
+                            THREAD_CREATE_STACKTEST, _thread, NULL, "agg");
+    }
+    running = true;
+    mutex_unlock(&gate);
+    printf("agg: reading every %lu ms, reporting to %s every %lu s\n",
+           (unsigned long)sample_period, topic, (unsigned long)report);
+    return 0;
+}
+
+static int _status(void)
+{
+    printf("agg %s", running ? "running" : "stopped");
+    if (topic[0]) {
+        printf(" on %s, flags 0x%02x", topic, flags);
+    }
+    puts("");
+
+    /* a snapshot, the thread may be adding to it */
+    aggwin_t w = window;
+    if (w.count > 0) {
+        char min[FIXP_FMT_MAXLEN];
+        char max[FIXP_FMT_MAXLEN];
+        char mean[FIXP_FMT_MAXLEN];
+        fixp_to_str(min, w.min, 2);
+        fixp_to_str(max, w.max, 2);
+        fixp_to_str(mean, aggwin_mean(&w), 2);
+        printf("window: %lu readings, min %s, max %s, mean %s\n",
+               (unsigned long)w.count, min, max, mean);
+    }
+    printf("%lu reports, %lu failed, %lu read errors, %lu times no new "
+           "reading\n", (unsigned long)reports, (unsigned long)failed,
+           (unsigned long)read_errors, (unsigned long)no_new);
+    periodic_print_stats(tasks, 2);
+    return 0;
+}
+
+int aggwin_cmd(int argc, char **argv)
+{
+    if ((argc >= 3) && (strcmp(argv[1], "start") == 0)) {
+        return _start(argc - 2, argv + 2);
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "stop") == 0)) {
+        if (!running) {
+            puts("error: agg is not running");
+            return 1;
+        }
+        mutex_lock(&gate);
+        running = false;
+        puts("agg stopped, the current window is dropped");
+        return 0;
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "status") == 0)) {
+        return _status();
+    }
+
+    printf("usage: %s start <topic> [sample ms] [report s] [QoS level]\n"
+           "       %s stop|status\n", argv[0], argv[0]);
+    return 1;
+}
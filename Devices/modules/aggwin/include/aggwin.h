@@ -0,0 +1,150 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    aggwin Windowed aggregation of a sensor
+ * @{
+ *
+ * @file
+ * @brief       Reads a sensor often and publishes min, max, mean, last and
+ *              count once per reporting interval
+ *
+ * A window is a handful of fixed-point counters, so memory stays the same
+ * however many readings it covers. The mean is rounded to the nearest
+ * hundredth.
+ *
+ * Shell usage:
+ *
+ *     agg start <topic> [sample ms] [report s] [QoS level]
+ *     agg stop
+ *     agg status
+ *
+ * A report is Thingsboard JSON like the pub command sends, with one key per
+ * statistic:
+ *
+ *     {"ts": 1700000000000, "values": {"device": "1",
+ *      "temperature_min": "21.50", "temperature_max": "21.93",
+ *      "temperature_mean": "21.71", "temperature_last": "21.90",
+ *      "temperature_count": 100}}
+ *
+ * A reading the callback already returned is never counted again: with
+ * readings from a cache refreshed at the sample rate, count is the number of
+ * distinct readings and `agg status` shows how often there was none.
+ *
+ * Reading and publishing run in one thread with two periodic tasks, a QoS 1
+ * report that waits for its PUBACK shows up as missed samples in
+ * `agg status`.
+ *
+ * @}
+ */
+
+#ifndef AGGWIN_H
+#define AGGWIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fixp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Default milliseconds between two readings
+ */
+#ifndef AGGWIN_SAMPLE_PERIOD
+#define AGGWIN_SAMPLE_PERIOD        (100U)
+#endif
+
+/**
+ * @brief   Default seconds between two reports
+ */
+#ifndef AGGWIN_REPORT_PERIOD
+#define AGGWIN_REPORT_PERIOD        (10U)
+#endif
+
+/**
+ * @brief   Largest report
+ */
+#ifndef AGGWIN_PAYLOAD_MAXLEN
+#define AGGWIN_PAYLOAD_MAXLEN       (240U)
+#endif
+
+/**
+ * @brief   Statistics of the readings of one window
+ */
+typedef struct {
+    fixp_t min;         /**< smallest reading */
+    fixp_t max;         /**< largest reading */
+    fixp_t last;        /**< newest reading */
+    int64_t sum;        /**< sum of the readings, for the mean */
+    uint32_t count;     /**< readings in the window */
+} aggwin_t;
+
+/**
+ * @brief   Reads the sensor, called from the aggregation thread
+ *
+ * @param[out] v    reading in hundredths of the unit
+ *
+ * @return  0 on success
+ * @return  -EAGAIN if there is no new reading since the last call, the
+ *          window is left as it is and the miss is not an error
+ * @return  another negative value if the sensor failed
+ */
+typedef int (*aggwin_read_cb_t)(fixp_t *v);
+
+/**
+ * @brief   Start an empty window
+ */
+void aggwin_reset(aggwin_t *w);
+
+/**
+ * @brief   Add a reading to a window
+ */
+void aggwin_add(aggwin_t *w, fixp_t v);
+
+/**
+ * @brief   Mean of the readings, rounded, 0 for an empty window
+ */
+fixp_t aggwin_mean(const aggwin_t *w);
+
+/**
+ * @brief   Encode a window as Thingsboard JSON
+ *
+ * @param[out] buf      output buffer
+ * @param[in]  len      size of @p buf
+ * @param[in]  w        window, not empty
+ * @param[in]  field    key prefix, e.g. "temperature"
+ * @param[in]  device   device number
+ * @param[in]  ts       milliseconds since the epoch
+ *
+ * @return  length of the JSON without the terminator
+ * @return  -EOVERFLOW if it does not fit into @p buf
+ */
+int aggwin_json(char *buf, size_t len, const aggwin_t *w, const char *field,
+                uint8_t device, uint64_t ts);
+
+/**
+ * @brief   Set up the agg command, the thread waits for `agg start`
+ *
+ * @param[in] cb        sensor to read
+ * @param[in] field     name of the reading, key prefix of the reports
+ * @param[in] device    device number in the reports
+ */
+void aggwin_init(aggwin_read_cb_t cb, const char *field, uint8_t device);
+
+/**
+ * @brief   The agg shell command
+ */
+int aggwin_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AGGWIN_H */
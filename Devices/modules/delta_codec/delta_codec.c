@@ -0,0 +1,91 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     delta_codec
+ * @{
+ *
+ * @file
+ * @brief       Delta + varint column codec implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+
+#include "delta_codec.h"
+
+int delta_varint_put(uint8_t *buf, size_t len, uint32_t v)
+{
+    size_t pos = 0;
+
+    do {
+        if (pos >= len) {
+            return -EOVERFLOW;
+        }
+        buf[pos++] = (uint8_t)((v & 0x7f) | ((v > 0x7f) ? 0x80 : 0));
+        v >>= 7;
+    } while (v);
+
+    return (int)pos;
+}
+
+int delta_varint_get(uint32_t *v, const uint8_t *buf, size_t len)
+{
+    uint32_t res = 0;
+
+    for (size_t pos = 0; (pos < len) && (pos < DELTA_VARINT_MAXLEN); pos++) {
+        /* the last byte holds the top 4 bits, anything above does not fit */
+        if ((pos == DELTA_VARINT_MAXLEN - 1) && (buf[pos] & 0xf0)) {
+            return -EBADMSG;
+        }
+        res |= (uint32_t)(buf[pos] & 0x7f) << (7 * pos);
+        if (!(buf[pos] & 0x80)) {
+            *v = res;
+            return (int)(pos + 1);
+        }
+    }
+    return -EBADMSG;
+}
+
+int delta_encode(uint8_t *buf, size_t len, const int32_t *values,
+                 unsigned numof)
+{
+    uint32_t prev = 0;
+    size_t pos = 0;
+
+    for (unsigned i = 0; i < numof; i++) {
+        /* unsigned arithmetic, the difference wraps instead of overflowing */
+        int32_t diff = (int32_t)((uint32_t)values[i] - prev);
+        int res = delta_varint_put(buf + pos, len - pos, delta_zigzag(diff));
+        if (res < 0) {
+            return res;
+        }
+        pos += res;
+        prev = (uint32_t)values[i];
+    }
+    return (int)pos;
+}
+
+int delta_decode(int32_t *values, unsigned numof, const uint8_t *buf,
+                 size_t len)
+{
+    uint32_t prev = 0;
+    size_t pos = 0;
+
+    for (unsigned i = 0; i < numof; i++) {
+        uint32_t raw;
+        int res = delta_varint_get(&raw, buf + pos, len - pos);
+        if (res < 0) {
+            return res;
+        }
+        pos += res;
+        prev += (uint32_t)delta_unzigzag(raw);
+        values[i] = (int32_t)prev;
+    }
+    return (int)pos;
+}
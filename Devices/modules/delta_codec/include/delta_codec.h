@@ -0,0 +1,103 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    delta_codec Delta + varint column codec
+ * @{
+ *
+ * @file
+ * @brief       Compact encoding of slowly changing integer series
+ *
+ * A column of 32 bit values is stored as the difference of every value to
+ * the previous one (the first one to 0), mapped to unsigned with zigzag
+ * encoding (0, -1, 1, -2, ... become 0, 1, 2, 3, ...) and written as
+ * LEB128 varint, seven bits per byte with the high bit set on all but the
+ * last byte. A sensor value that moves by less than ±64 per sample costs a
+ * single byte.
+ *
+ * Differences are taken modulo 2^32, so unsigned values like timestamps can
+ * be passed as well. The host side decoder is in Gateway/telemetry.js.
+ *
+ * @}
+ */
+
+#ifndef DELTA_CODEC_H
+#define DELTA_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum length of one encoded value
+ */
+#define DELTA_VARINT_MAXLEN     (5U)
+
+/**
+ * @brief   Maximum length of an encoded column of @p n values
+ */
+#define DELTA_COLUMN_MAXLEN(n)  ((n) * DELTA_VARINT_MAXLEN)
+
+/**
+ * @brief   Map a signed value to unsigned, small magnitudes stay small
+ */
+static inline uint32_t delta_zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+/**
+ * @brief   Inverse of delta_zigzag()
+ */
+static inline int32_t delta_unzigzag(uint32_t v)
+{
+    return (int32_t)((v >> 1) ^ (0U - (v & 1)));
+}
+
+/**
+ * @brief   Write @p v as varint
+ *
+ * @return  number of bytes written
+ * @return  -EOVERFLOW if @p len is too small
+ */
+int delta_varint_put(uint8_t *buf, size_t len, uint32_t v);
+
+/**
+ * @brief   Read one varint
+ *
+ * @return  number of bytes read
+ * @return  -EBADMSG if the varint is truncated or longer than 32 bit,
+ *          including set bits above bit 31 in the fifth byte
+ */
+int delta_varint_get(uint32_t *v, const uint8_t *buf, size_t len);
+
+/**
+ * @brief   Encode a column of @p numof values
+ *
+ * @return  length of the encoded column
+ * @return  -EOVERFLOW if @p len is too small
+ */
+int delta_encode(uint8_t *buf, size_t len, const int32_t *values,
+                 unsigned numof);
+
+/**
+ * @brief   Decode a column of @p numof values
+ *
+ * @return  number of bytes consumed from @p buf
+ * @return  -EBADMSG if the column is truncated
+ */
+int delta_decode(int32_t *values, unsigned numof, const uint8_t *buf,
+                 size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DELTA_CODEC_H */
@@ -0,0 +1,178 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     devcfg
+ * @{
+ *
+ * @file
+ * @brief       Remote configuration of the loop
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mutex.h"
+#include "thread.h"
+#include "net/emcute.h"
+
+#include "devcfg.h"
+#include "sensor_loop.h"
+#include "subreg.h"
+#include "topic_cache.h"
+
+static char stack[THREAD_STACKSIZE_DEFAULT];
+static kernel_pid_t pid = KERNEL_PID_UNDEF;
+static char topic[TOPIC_CACHE_NAME_MAXLEN];
+
+/* last config received, a newer one replaces it if not applied yet */
+static mutex_t lock = MUTEX_INIT;
+static char pending[DEVCFG_PAYLOAD_MAXLEN];
+/* locked while nothing is pending, the thread waits on it */
+static mutex_t gate = MUTEX_INIT_LOCKED;
+
+static char ack[DEVCFG_PAYLOAD_MAXLEN];
+
+/* value of "key" in flat JSON, false if missing or not a number */
+static bool _get(const char *json, const char *key, int *val)
+{
+    const char *p = strstr(json, key);
+
+    if (p == NULL) {
+        return false;
+    }
+    p += strlen(key);
+    while ((*p == ' ') || (*p == ':') || (*p == '"')) {
+        p++;
+    }
+    if (((*p < '0') || (*p > '9')) && (*p != '-')) {
+        return false;
+    }
+    *val = atoi(p);
+    return true;
+}
+
+static int _parse(const char *json, sensor_loop_tune_t *t)
+{
+    int val;
+
+    memset(t, 0, sizeof(*t));
+    t->qos = -1;
+    if (_get(json, "\"period\"", &val)) {
+        if (val < 1) {
+            return -EINVAL;
+        }
+        t->period = val;
+    }
+    if (_get(json, "\"batch\"", &val)) {
+        if (val < 1) {
+            return -EINVAL;
+        }
+        t->batch = val;
+    }
+    if (_get(json, "\"qos\"", &val)) {
+        if ((val < 0) || (val > 2)) {
+            return -EINVAL;
+        }
+        t->qos = val;
+    }
+    return 0;
+}
+
+static void _ack(void)
+{
+    emcute_topic_t t;
+    unsigned flags = EMCUTE_QOS_0;
+
+    if (topic_cache_get(&t, &flags, DEVCFG_ACK_TOPIC) != EMCUTE_OK) {
+        puts("devcfg: unable to obtain the topic ID of the acknowledgement");
+        return;
+    }
+    if (emcute_pub(&t, ack, strlen(ack), flags) != EMCUTE_OK) {
+        puts("devcfg: unable to send the acknowledgement");
+    }
+}
+
+static void *_thread(void *arg)
+{
+    (void)arg;
+    char json[DEVCFG_PAYLOAD_MAXLEN];
+
+    while (1) {
+        mutex_lock(&gate);
+        mutex_lock(&lock);
+        strcpy(json, pending);
+        mutex_unlock(&lock);
+
+        sensor_loop_tune_t t;
+        int res = _parse(json, &t);
+        if (res == 0) {
+            res = sensor_loop_tune(&t);
+        }
+        if (res == 0) {
+            snprintf(ack, sizeof(ack),
+                     "{\"period\": %u, \"batch\": %u, \"qos\": %d, \"cfg\": \"ok\"}",
+                     t.period, t.batch, t.qos);
+        }
+        else {
+            snprintf(ack, sizeof(ack),
+                     "{\"cfg\": \"rejected\", \"cfg_error\": %d}", res);
+        }
+        printf("devcfg: %s -> %s\n", json, ack);
+        _ack();
+    }
+
+    return NULL;
+}
+
+/* called by the emcute thread, must not wait for the gateway */
+void devcfg_handle(const char *name, const void *data, size_t len, void *arg)
+{
+    (void)name;
+    (void)arg;
+
+    if (len >= sizeof(pending)) {
+        printf("devcfg: config of %u bytes ignored\n", (unsigned)len);
+        return;
+    }
+    mutex_lock(&lock);
+    memcpy(pending, data, len);
+    pending[len] = '\0';
+    mutex_unlock(&lock);
+    mutex_unlock(&gate);
+}
+
+int devcfg_start(const char *client_id)
+{
+    if (pid == KERNEL_PID_UNDEF) {
+        pid = thread_create(stack, sizeof(stack), THREAD_PRIORITY_MAIN - 1,
+                            THREAD_CREATE_STACKTEST, _thread, NULL, "devcfg");
+    }
+
+    devcfg_stop();
+    snprintf(topic, sizeof(topic), DEVCFG_TOPIC_FMT, client_id);
+    int res = subreg_sub(topic, EMCUTE_QOS_1, devcfg_handle, NULL);
+    if (res < 0) {
+        topic[0] = '\0';
+        return res;
+    }
+    printf("devcfg: waiting for config on %s\n", topic);
+    return 0;
+}
+
+void devcfg_stop(void)
+{
+    if (topic[0]) {
+        subreg_unsub(topic);
+        topic[0] = '\0';
+    }
+}
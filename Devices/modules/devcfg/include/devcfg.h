@@ -0,0 +1,103 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    devcfg Remote configuration of the loop
+ * @{
+ *
+ * @file
+ * @brief       Sample period, batch size and QoS level set over MQTT-SN
+ *
+ * After devcfg_start() the client is subscribed to its own config topic,
+ * `riot/<client id>/config` by default. A message there is flat JSON with
+ * any of the keys below, missing keys keep their value:
+ *
+ *     {"period": 10, "batch": 4, "qos": 1}
+ *
+ * The values are handed to sensor_loop_tune() and the loop carries on with
+ * them. The result is acknowledged on the attributes topic with the values
+ * the loop switches to, or with the error if the message was rejected:
+ *
+ *     {"period": 10, "batch": 4, "qos": 1, "cfg": "ok"}
+ *     {"cfg": "rejected", "cfg_error": -22}
+ *
+ * A config that arrives while the loop is stopped is rejected with -EAGAIN,
+ * `loop start` sets all parameters anyway.
+ *
+ * The emcute thread delivers the message, but it also has to receive the
+ * answers to a REGISTER or a QoS 1 publish, so the config is applied and
+ * acknowledged by a thread of this module.
+ *
+ * @}
+ */
+
+#ifndef DEVCFG_H
+#define DEVCFG_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Config topic, %s is the client ID
+ */
+#ifndef DEVCFG_TOPIC_FMT
+#define DEVCFG_TOPIC_FMT            "riot/%s/config"
+#endif
+
+/**
+ * @brief   Topic of the acknowledgements
+ */
+#ifndef DEVCFG_ACK_TOPIC
+#define DEVCFG_ACK_TOPIC            "v1/devices/me/attributes"
+#endif
+
+/**
+ * @brief   Longest config message, longer ones are ignored
+ */
+#ifndef DEVCFG_PAYLOAD_MAXLEN
+#define DEVCFG_PAYLOAD_MAXLEN       (96U)
+#endif
+
+/**
+ * @brief   Subscribe to the config topic of @p client_id
+ *
+ * Call it once connected to the gateway.
+ *
+ * @param[in] client_id     client ID given to emcute_run()
+ *
+ * @return  0 on success
+ * @return  the negative error of subreg_sub() otherwise
+ */
+int devcfg_start(const char *client_id);
+
+/**
+ * @brief   Unsubscribe from the config topic, call it before emcute_discon()
+ */
+void devcfg_stop(void);
+
+/**
+ * @brief   Apply a config message received some other way
+ *
+ * Has the signature of subreg_cb_t and never blocks, for sessions other
+ * than the emcute one, like the sleeping session of the loop. The
+ * acknowledgement still goes through emcute and is lost without it.
+ *
+ * @param[in] topic     topic the message came on, unused
+ * @param[in] data      flat JSON config
+ * @param[in] len       length of @p data
+ * @param[in] arg       unused
+ */
+void devcfg_handle(const char *topic, const void *data, size_t len, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEVCFG_H */
@@ -0,0 +1,102 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     fixp
+ * @{
+ *
+ * @file
+ * @brief       Fixed-point readings implementation
+ *
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "fixp.h"
+
+fixp_t fixp_random_walk(fixp_t prev, int min, int max)
+{
+    /* (max - min) * step * 0.003 units are 3 / 10 of that in hundredths */
+    int32_t step = (rand() % 11) - 5;
+    fixp_t v = prev + (((max - min) * step * 3) / 10);
+
+    return fixp_clamp(v, fixp_from_int(min), fixp_from_int(max));
+}
+
+size_t fixp_fmt(char *out, fixp_t v, unsigned decimals)
+{
+    static const uint8_t div[] = { 100, 10, 1 };
+    char tmp[FIXP_FMT_MAXLEN];
+    size_t len = 0;
+
+    if (decimals > 2) {
+        decimals = 2;
+    }
+
+    /* magnitude in the requested precision, truncated towards zero */
+    uint32_t mag = (uint32_t)((v < 0) ? -(int64_t)v : v) / div[decimals];
+
+    /* digits are produced backwards, the decimal point after 'decimals' */
+    do {
+        if ((decimals > 0) && (len == decimals)) {
+            tmp[len++] = '.';
+        }
+        tmp[len++] = '0' + (mag % 10);
+        mag /= 10;
+    } while ((mag > 0) || (len <= decimals));
+    if ((v < 0) && (v / (int32_t)div[decimals] != 0)) {
+        tmp[len++] = '-';
+    }
+
+    if (out) {
+        for (size_t i = 0; i < len; i++) {
+            out[i] = tmp[len - 1 - i];
+        }
+    }
+    return len;
+}
+
+size_t fixp_to_str(char *out, fixp_t v, unsigned decimals)
+{
+    size_t len = fixp_fmt(out, v, decimals);
+
+    out[len] = '\0';
+    return len;
+}
+
+size_t fixp_parse(const char *str, fixp_t *v)
+{
+    const char *p = str;
+    bool neg = (*p == '-');
+    fixp_t ipart = 0;
+    fixp_t frac = 0;
+
+    if (neg) {
+        p++;
+    }
+    if ((*p < '0') || (*p > '9')) {
+        return 0;
+    }
+    while ((*p >= '0') && (*p <= '9')) {
+        ipart = (ipart * 10) + (*p++ - '0');
+    }
+    if (*p == '.') {
+        p++;
+        for (int scale = FIXP_SCALE / 10; (*p >= '0') && (*p <= '9'); p++) {
+            frac += (*p - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    *v = fixp_from_int(ipart) + frac;
+    if (neg) {
+        *v = -*v;
+    }
+    return p - str;
+}
@@ -0,0 +1,122 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    fixp Fixed-point readings
+ * @{
+ *
+ * @file
+ * @brief       Fixed-point sensor values with two decimals
+ *
+ * Readings are kept as integer hundredths of their unit, which is what the
+ * lpsxxx driver returns and what the telemetry records carry. Generating,
+ * clamping and printing them needs no floating point at all, so the
+ * firmwares do not have to link the float support of printf.
+ *
+ * @}
+ */
+
+#ifndef FIXP_H
+#define FIXP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   A value in hundredths of its unit
+ */
+typedef int32_t fixp_t;
+
+/**
+ * @brief   Hundredths per unit
+ */
+#define FIXP_SCALE          (100)
+
+/**
+ * @brief   Maximum length of a formatted value, including the terminator
+ */
+#define FIXP_FMT_MAXLEN     (14U)
+
+/**
+ * @brief   Convert an integer to fixed point
+ */
+static inline fixp_t fixp_from_int(int32_t i)
+{
+    return i * FIXP_SCALE;
+}
+
+/**
+ * @brief   Integer part of a value, truncated towards zero like a cast
+ */
+static inline int32_t fixp_to_int(fixp_t v)
+{
+    return v / FIXP_SCALE;
+}
+
+/**
+ * @brief   Limit @p v to [@p min, @p max]
+ */
+static inline fixp_t fixp_clamp(fixp_t v, fixp_t min, fixp_t max)
+{
+    return (v > max) ? max : ((v < min) ? min : v);
+}
+
+/**
+ * @brief   Random walk step of the simulated sensors
+ *
+ * Moves @p prev by a random multiple between -5 and 5 of 0.3% of the range
+ * and clamps the result to it, exactly what genNextValue() did in floating
+ * point.
+ *
+ * @param[in] prev  previous value
+ * @param[in] min   lower end of the range, in units
+ * @param[in] max   upper end of the range, in units
+ */
+fixp_t fixp_random_walk(fixp_t prev, int min, int max);
+
+/**
+ * @brief   Format a value with @p decimals decimals
+ *
+ * Gives the same text as printf("%.2f") for two decimals; with fewer
+ * decimals the value is truncated like a cast to int, not rounded. The
+ * string is not terminated.
+ *
+ * @param[out] out      output buffer, NULL to only get the length
+ * @param[in]  v        value
+ * @param[in]  decimals number of decimals, 0 to 2
+ *
+ * @return  number of characters written
+ */
+size_t fixp_fmt(char *out, fixp_t v, unsigned decimals);
+
+/**
+ * @brief   Like fixp_fmt() but with a terminated string
+ */
+size_t fixp_to_str(char *out, fixp_t v, unsigned decimals);
+
+/**
+ * @brief   Parse a decimal number like "12", "-0.5" or "3.25"
+ *
+ * Decimals after the second one are ignored.
+ *
+ * @param[in]  str  text to parse
+ * @param[out] v    value
+ *
+ * @return  number of characters used, 0 if @p str does not start with a
+ *          number
+ */
+size_t fixp_parse(const char *str, fixp_t *v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FIXP_H */
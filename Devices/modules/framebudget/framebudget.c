@@ -0,0 +1,134 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     framebudget
+ * @{
+ *
+ * @file
+ * @brief       Payload budget of one link layer frame implementation
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mutex.h"
+#include "net/ipv6/addr.h"
+#ifdef MODULE_GNRC_NETIF
+#include "net/gnrc/netif.h"
+#include "net/netdev.h"
+#endif
+#ifdef MODULE_GNRC_SIXLOWPAN_CTX
+#include "net/gnrc/sixlowpan/ctx.h"
+#endif
+#ifdef MODULE_GNRC_SIXLOWPAN_FRAG_STATS
+#include "net/gnrc/sixlowpan/frag/stats.h"
+#endif
+
+#include "framebudget.h"
+
+/* IPHC dispatch and encoding bytes, traffic class, flow label, next header
+ * and hop limit elided */
+#define IPHC_LEN        (2U)
+
+static mutex_t lock = MUTEX_INIT;
+static framebudget_stats_t stats;
+
+/* inline bytes of one address */
+static unsigned _addr_len(const ipv6_addr_t *addr)
+{
+    if (ipv6_addr_is_link_local(addr)) {
+        return 8;
+    }
+#ifdef MODULE_GNRC_SIXLOWPAN_CTX
+    if (gnrc_sixlowpan_ctx_lookup_addr(addr) != NULL) {
+        return 8;
+    }
+#endif
+    return 16;
+}
+
+void framebudget_get(framebudget_t *b, const sock_udp_ep_t *remote)
+{
+    memset(b, 0, sizeof(*b));
+
+#ifdef MODULE_GNRC_NETIF
+    gnrc_netif_t *netif = (remote->netif != 0) ?
+                          gnrc_netif_get_by_pid(remote->netif) :
+                          gnrc_netif_iter(NULL);
+    uint16_t type = 0;
+    uint16_t pdu = 0;
+
+    if ((netif == NULL) ||
+        (gnrc_netapi_get(netif->pid, NETOPT_DEVICE_TYPE, 0, &type,
+                         sizeof(type)) < 0) ||
+        (type != NETDEV_TYPE_IEEE802154) ||
+        (gnrc_netapi_get(netif->pid, NETOPT_MAX_PDU_SIZE, 0, &pdu,
+                         sizeof(pdu)) < 0)) {
+        /* no 6LoWPAN fragmentation, no limit */
+        return;
+    }
+
+    unsigned addr = _addr_len((const ipv6_addr_t *)&remote->addr.ipv6);
+    b->pdu = pdu;
+    b->headers = IPHC_LEN + (2 * addr) + FRAMEBUDGET_UDP_LEN +
+                 FRAMEBUDGET_MQTTSN_LEN;
+    /* a frame too small for the headers still needs a limit */
+    b->payload = (pdu > b->headers + 1) ? (pdu - b->headers) : 1;
+#else
+    (void)remote;
+    (void)_addr_len;
+#endif
+}
+
+void framebudget_record(const framebudget_t *b, size_t len, int res)
+{
+    mutex_lock(&lock);
+    if ((b->payload > 0) && (len > b->payload)) {
+        stats.fragmented++;
+        stats.fragmented_failed += (res != 0);
+    }
+    else {
+        stats.single++;
+        stats.single_failed += (res != 0);
+    }
+    mutex_unlock(&lock);
+}
+
+void framebudget_get_stats(framebudget_stats_t *out)
+{
+    mutex_lock(&lock);
+    *out = stats;
+    mutex_unlock(&lock);
+}
+
+void framebudget_print(const framebudget_t *b)
+{
+    framebudget_stats_t s;
+
+    framebudget_get_stats(&s);
+    if (b->payload == 0) {
+        printf("frame: no limit");
+    }
+    else if (b->pdu == 0) {
+        printf("frame: %u bytes of payload, set by hand", b->payload);
+    }
+    else {
+        printf("frame: %u bytes of payload, %u of headers in %u",
+               b->payload, b->headers, b->pdu);
+    }
+    printf(", %lu single (%lu failed), %lu fragmented (%lu failed)\n",
+           (unsigned long)s.single, (unsigned long)s.single_failed,
+           (unsigned long)s.fragmented, (unsigned long)s.fragmented_failed);
+#ifdef MODULE_GNRC_SIXLOWPAN_FRAG_STATS
+    gnrc_sixlowpan_frag_stats_t *frag = gnrc_sixlowpan_frag_stats_get();
+    printf("6lowpan: %u reassembly buffer full, %u fragmentation buffer "
+           "full\n", frag->rbuf_full, frag->frag_full);
+#endif
+}
@@ -0,0 +1,109 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    framebudget Payload budget of one link layer frame
+ * @{
+ *
+ * @file
+ * @brief       How much MQTT-SN payload fits into one IEEE 802.15.4 frame
+ *
+ * A 127 byte IEEE 802.15.4 frame leaves about 100 bytes after the MAC
+ * header. A message that does not fit is split into 6LoWPAN fragments, and
+ * losing any of them loses the whole message. framebudget_get() asks the
+ * interface for its frame payload and subtracts the compressed IPv6 and UDP
+ * headers and the MQTT-SN PUBLISH header:
+ *
+ * - IPHC takes 2 bytes plus, per address, 8 bytes if the prefix is elided
+ *   (link-local or a 6LoWPAN context covers it) and 16 bytes otherwise. The
+ *   source address is assumed to be of the same kind as the destination.
+ * - UDP takes 7 bytes, the MQTT-SN ports cannot be compressed
+ *
+ * Interfaces other than IEEE 802.15.4, like the tap interface of native,
+ * do not fragment and get no limit.
+ *
+ * framebudget_record() counts the messages sent in a single frame and the
+ * fragmented ones, with their failures. With the
+ * gnrc_sixlowpan_frag_stats module framebudget_print() adds the datagrams
+ * the 6LoWPAN layer dropped for a full reassembly or fragmentation buffer.
+ *
+ * @}
+ */
+
+#ifndef FRAMEBUDGET_H
+#define FRAMEBUDGET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/sock/udp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Compressed UDP header
+ */
+#define FRAMEBUDGET_UDP_LEN         (7U)
+
+/**
+ * @brief   MQTT-SN PUBLISH header with a short length
+ */
+#define FRAMEBUDGET_MQTTSN_LEN      (7U)
+
+/**
+ * @brief   Budget of one message
+ */
+typedef struct {
+    uint16_t pdu;       /**< payload of one link layer frame, 0 if unknown */
+    uint16_t headers;   /**< IPv6, UDP and MQTT-SN headers in that frame */
+    uint16_t payload;   /**< MQTT-SN payload that fits, 0 for no limit */
+} framebudget_t;
+
+/**
+ * @brief   Messages sent so far
+ */
+typedef struct {
+    uint32_t single;            /**< messages in a single frame */
+    uint32_t fragmented;        /**< messages split into fragments */
+    uint32_t single_failed;     /**< of those, not delivered */
+    uint32_t fragmented_failed; /**< of those, not delivered */
+} framebudget_stats_t;
+
+/**
+ * @brief   Compute the budget of messages to @p remote
+ *
+ * @param[out] b        budget
+ * @param[in]  remote   destination, its netif or the first interface is used
+ */
+void framebudget_get(framebudget_t *b, const sock_udp_ep_t *remote);
+
+/**
+ * @brief   Count a message against a budget
+ *
+ * @param[in] b         budget in effect, a payload of 0 counts single frames
+ * @param[in] len       MQTT-SN payload length
+ * @param[in] res       0 if the message was delivered
+ */
+void framebudget_record(const framebudget_t *b, size_t len, int res);
+
+/**
+ * @brief   Get a copy of the counters
+ */
+void framebudget_get_stats(framebudget_stats_t *stats);
+
+/**
+ * @brief   Print a budget and the counters
+ */
+void framebudget_print(const framebudget_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAMEBUDGET_H */
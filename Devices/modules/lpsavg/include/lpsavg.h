@@ -0,0 +1,121 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    lpsavg LPS331AP internal averaging
+ * @{
+ *
+ * @file
+ * @brief       Temperature readings averaged by the LPS331AP itself
+ *
+ * Unlike its successor LPS25H, the LPS331AP has no FIFO, so it cannot
+ * collect a batch of conversions for the MCU to drain. What it has is an
+ * averaging stage: RES_CONF sets how many internal measurements make up one
+ * output value, up to 128 for the temperature and 512 for the pressure.
+ * It comes out of reset with 128 temperature measurements, 0x7a, and the
+ * lpsxxx driver never writes it, so readings through the driver are already
+ * averaged that much. lpsavg_init() sets the number explicitly, fewer
+ * measurements draw less supply current for a noisier value, and
+ * lpsavg_read_temp() reads the status and the outputs in a single burst
+ * transfer, where the driver accesses every output register on its own.
+ * The status tells whether the value is a new one since the last reading.
+ *
+ * Reading once per batch period then gives a value already averaged by the
+ * sensor, with one bus transfer and one MCU wake-up, instead of reading
+ * every sample and averaging them on the MCU. The average covers the
+ * internal measurements of one output period, not the whole batch period.
+ *
+ * @}
+ */
+
+#ifndef LPSAVG_H
+#define LPSAVG_H
+
+#include <stdint.h>
+
+#include "lpsxxx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Temperature measurements averaged into one value by default
+ *
+ * Less than the 128 of the power-on value, which the driver keeps.
+ */
+#ifndef LPSAVG_TEMP_AVG
+#define LPSAVG_TEMP_AVG         (16U)
+#endif
+
+/**
+ * @brief   RES_CONF after power-on, what the driver leaves in place
+ */
+#define LPSAVG_RES_CONF_RESET   (0x7a)
+
+/**
+ * @brief   Readings and bus transfers so far
+ */
+typedef struct {
+    uint8_t res_conf;       /**< RES_CONF in use */
+    unsigned temp_avg;      /**< temperature measurements per value */
+    uint32_t readings;      /**< values read */
+    uint32_t stale;         /**< of those, no new value since the last */
+    uint32_t transfers;     /**< bus transfers */
+} lpsavg_t;
+
+/**
+ * @brief   Set the number of averaged temperature measurements
+ *
+ * The sensor is powered down while RES_CONF changes and enabled again at
+ * the rate of its parameters. @p temp_avg is rounded down to a power of
+ * two, and to 64 at 25 Hz where the datasheet does not allow 128.
+ *
+ * @param[in]  dev      initialized sensor
+ * @param[in]  temp_avg temperature measurements per value, 1 to 128
+ * @param[out] a        counters to set up
+ *
+ * @return  LPSXXX_OK on success
+ * @return  LPSXXX_ERR_I2C on a bus error
+ */
+int lpsavg_init(const lpsxxx_t *dev, unsigned temp_avg, lpsavg_t *a);
+
+/**
+ * @brief   Put RES_CONF back to its power-on value
+ *
+ * At 25 Hz the temperature averaging is capped at 64 like in lpsavg_init(),
+ * the power-on value is not allowed there.
+ *
+ * @param[in] dev   sensor
+ *
+ * @return  LPSXXX_OK on success
+ * @return  LPSXXX_ERR_I2C on a bus error
+ */
+int lpsavg_restore(const lpsxxx_t *dev);
+
+/**
+ * @brief   Read the latest averaged temperature in one bus transfer
+ *
+ * @param[in]  dev  sensor
+ * @param[out] temp temperature in hundredths of °C
+ * @param[in]  a    counters
+ *
+ * @return  LPSXXX_OK on success
+ * @return  LPSXXX_ERR_I2C on a bus error
+ */
+int lpsavg_read_temp(const lpsxxx_t *dev, int16_t *temp, lpsavg_t *a);
+
+/**
+ * @brief   Print the averaging and the bus transfers per reading
+ */
+void lpsavg_print(const lpsavg_t *a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPSAVG_H */
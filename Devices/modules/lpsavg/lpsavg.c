@@ -0,0 +1,126 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     lpsavg
+ * @{
+ *
+ * @file
+ * @brief       LPS331AP internal averaging implementation
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "periph/i2c.h"
+
+#include "lpsavg.h"
+
+/* registers of the LPS331AP datasheet */
+#define REG_RES_CONF        (0x10)
+#define REG_STATUS          (0x27)
+/* the register address counts up during a burst transfer */
+#define REG_AUTO_INC        (0x80)
+
+#define STATUS_T_DA         (0x01)  /* new temperature value */
+
+/* STATUS, PRESS_OUT_XL, L, H, TEMP_OUT_L, H */
+#define BURST_LEN           (6U)
+
+#define AVGT_POS            (4U)
+#define AVGT_MASK           (0x70)
+#define AVGT_MAX            (7U)    /* 128 measurements */
+
+/* bus transfers of lpsxxx_read_temp(), one per output register */
+#define DRIVER_TEMP_TRANSFERS   (2U)
+
+/* the same shorthands as the driver */
+#define DEV_I2C             (dev->params.i2c)
+#define DEV_ADDR            (dev->params.addr)
+
+/* 0x7a is not allowed with both outputs at 25 Hz */
+static unsigned _avgt_max(const lpsxxx_t *dev)
+{
+    return (dev->params.rate == LPSXXX_RATE_25HZ) ? AVGT_MAX - 1 : AVGT_MAX;
+}
+
+static uint8_t _res_conf(unsigned avgt)
+{
+    return (LPSAVG_RES_CONF_RESET & ~AVGT_MASK) | (avgt << AVGT_POS);
+}
+
+static int _write_res_conf(const lpsxxx_t *dev, uint8_t res_conf)
+{
+    /* RES_CONF may only change while the sensor is powered down */
+    if (lpsxxx_disable(dev) != LPSXXX_OK) {
+        return LPSXXX_ERR_I2C;
+    }
+    i2c_acquire(DEV_I2C);
+    int res = i2c_write_reg(DEV_I2C, DEV_ADDR, REG_RES_CONF, res_conf, 0);
+    i2c_release(DEV_I2C);
+    if (res != 0) {
+        return LPSXXX_ERR_I2C;
+    }
+    return lpsxxx_enable(dev);
+}
+
+int lpsavg_init(const lpsxxx_t *dev, unsigned temp_avg, lpsavg_t *a)
+{
+    unsigned avgt = 0;
+
+    while ((avgt < _avgt_max(dev)) && ((2U << avgt) <= temp_avg)) {
+        avgt++;
+    }
+
+    memset(a, 0, sizeof(*a));
+    a->res_conf = _res_conf(avgt);
+    a->temp_avg = 1U << avgt;
+    return _write_res_conf(dev, a->res_conf);
+}
+
+int lpsavg_restore(const lpsxxx_t *dev)
+{
+    return _write_res_conf(dev, _res_conf(_avgt_max(dev)));
+}
+
+int lpsavg_read_temp(const lpsxxx_t *dev, int16_t *temp, lpsavg_t *a)
+{
+    uint8_t buf[BURST_LEN];
+
+    i2c_acquire(DEV_I2C);
+    int res = i2c_read_regs(DEV_I2C, DEV_ADDR, REG_STATUS | REG_AUTO_INC, buf,
+                            sizeof(buf), 0);
+    i2c_release(DEV_I2C);
+    a->transfers++;
+    if (res != 0) {
+        return LPSXXX_ERR_I2C;
+    }
+
+    a->readings++;
+    if (!(buf[0] & STATUS_T_DA)) {
+        a->stale++;
+    }
+    /* 42.5 °C at 0, 480 LSB per °C */
+    int16_t raw = (int16_t)(((uint16_t)buf[5] << 8) | buf[4]);
+    *temp = (int16_t)(4250 + (((int32_t)raw * 100) / 480));
+    return LPSXXX_OK;
+}
+
+void lpsavg_print(const lpsavg_t *a)
+{
+    printf("lps331ap: %u measurements averaged per value (RES_CONF 0x%02x), "
+           "%lu readings, %lu bus transfers, %lu without a new value\n",
+           a->temp_avg, a->res_conf, (unsigned long)a->readings,
+           (unsigned long)a->transfers, (unsigned long)a->stale);
+    /* the driver never writes RES_CONF, its readings average 128 */
+    printf("continuous mode reads values of %u measurements (RES_CONF 0x%02x "
+           "from reset), the same readings would take %lu bus transfers\n",
+           1U << AVGT_MAX, LPSAVG_RES_CONF_RESET,
+           (unsigned long)a->readings * DRIVER_TEMP_TRANSFERS);
+}
@@ -0,0 +1,145 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    mqttsn_frame MQTT-SN message framing
+ * @{
+ *
+ * @file
+ * @brief       Headers of the MQTT-SN messages built without emcute
+ *
+ * The modules and firmwares that speak MQTT-SN v1.2 on sockets of their
+ * own, next to or instead of emcute, build the few messages they need with
+ * these helpers.
+ *
+ * A message starts with its total length in one byte, or with 0x01 and the
+ * length in two bytes if it is longer than 255 bytes, followed by the
+ * message type and the body.
+ *
+ * @}
+ */
+
+#ifndef MQTTSN_FRAME_H
+#define MQTTSN_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name    Message types, see the MQTT-SN v1.2 specification
+ * @{
+ */
+#define MQTTSN_FRAME_CONNECT        (0x04)
+#define MQTTSN_FRAME_CONNACK        (0x05)
+#define MQTTSN_FRAME_PUBLISH        (0x0c)
+#define MQTTSN_FRAME_PUBACK         (0x0d)
+#define MQTTSN_FRAME_SUBSCRIBE      (0x12)
+#define MQTTSN_FRAME_SUBACK         (0x13)
+#define MQTTSN_FRAME_PINGREQ        (0x16)
+#define MQTTSN_FRAME_PINGRESP       (0x17)
+#define MQTTSN_FRAME_DISCONNECT     (0x18)
+/** @} */
+
+/**
+ * @brief   Protocol ID of CONNECT
+ */
+#define MQTTSN_FRAME_PROTOCOL_ID    (0x01)
+
+/**
+ * @brief   Length and type with a three byte length
+ */
+#define MQTTSN_FRAME_HDR_MAXLEN     (4U)
+
+/**
+ * @brief   PUBLISH header with a three byte length: length, type, flags,
+ *          topic ID and message ID
+ */
+#define MQTTSN_FRAME_PUB_HDR_MAXLEN (MQTTSN_FRAME_HDR_MAXLEN + 5U)
+
+/**
+ * @brief   Length of a CONNECT with a client ID of @p id_len bytes
+ *
+ * Client IDs are at most 23 bytes, so CONNECT always has the short length.
+ */
+#define MQTTSN_FRAME_CONNECT_LEN(id_len)    (6U + (id_len))
+
+/**
+ * @brief   Write the length and the type of a message
+ *
+ * @param[out] buf      at least MQTTSN_FRAME_HDR_MAXLEN bytes
+ * @param[in]  len      length of the body that follows
+ * @param[in]  type     message type
+ *
+ * @return  length of the header, the body goes right behind it
+ */
+size_t mqttsn_frame_hdr(uint8_t *buf, size_t len, uint8_t type);
+
+/**
+ * @brief   Write a complete CONNECT
+ *
+ * @param[out] buf          MQTTSN_FRAME_CONNECT_LEN() bytes
+ * @param[in]  flags        EMCUTE_CS or 0
+ * @param[in]  keepalive    keep alive time in seconds
+ * @param[in]  client_id    client ID, at most 23 characters
+ *
+ * @return  length of the message
+ */
+size_t mqttsn_frame_connect(uint8_t *buf, uint8_t flags, uint16_t keepalive,
+                            const char *client_id);
+
+/**
+ * @brief   Length of the PUBLISH header in front of @p len payload bytes
+ */
+static inline size_t mqttsn_frame_pub_hdrlen(size_t len)
+{
+    return (len + 7 > 0xff) ? MQTTSN_FRAME_PUB_HDR_MAXLEN
+                            : MQTTSN_FRAME_PUB_HDR_MAXLEN - 2;
+}
+
+/**
+ * @brief   Write the header of a PUBLISH
+ *
+ * @param[out] buf      mqttsn_frame_pub_hdrlen() bytes
+ * @param[in]  len      length of the payload that follows
+ * @param[in]  flags    QoS, topic ID type and retain flag
+ * @param[in]  topic_id topic ID or short topic name
+ * @param[in]  msg_id   message ID, 0 for QoS 0 and -1
+ *
+ * @return  length of the header, the payload goes right behind it
+ */
+size_t mqttsn_frame_pub(uint8_t *buf, size_t len, uint8_t flags,
+                        uint16_t topic_id, uint16_t msg_id);
+
+/**
+ * @brief   Mark a PUBLISH as retransmission by setting its DUP flag
+ */
+void mqttsn_frame_set_dup(uint8_t *msg);
+
+/**
+ * @brief   Split a received message into type and body
+ *
+ * @param[in]  buf      received datagram
+ * @param[in]  n        length of the datagram
+ * @param[out] type     message type
+ * @param[out] body     start of the body inside @p buf
+ *
+ * @return  length of the body
+ * @return  -EBADMSG if the datagram is shorter than the length it carries
+ *          or the length is too small for a header
+ */
+int mqttsn_frame_parse(const uint8_t *buf, size_t n, uint8_t *type,
+                       const uint8_t **body);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTTSN_FRAME_H */
@@ -0,0 +1,95 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     mqttsn_frame
+ * @{
+ *
+ * @file
+ * @brief       MQTT-SN message framing implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "mqttsn_frame.h"
+
+/* the flags follow the header */
+#define DUP             (0x80)
+
+size_t mqttsn_frame_hdr(uint8_t *buf, size_t len, uint8_t type)
+{
+    if (len + 2 > 0xff) {
+        buf[0] = 0x01;
+        buf[1] = (uint8_t)((len + 4) >> 8);
+        buf[2] = (uint8_t)(len + 4);
+        buf[3] = type;
+        return 4;
+    }
+    buf[0] = (uint8_t)(len + 2);
+    buf[1] = type;
+    return 2;
+}
+
+size_t mqttsn_frame_connect(uint8_t *buf, uint8_t flags, uint16_t keepalive,
+                            const char *client_id)
+{
+    size_t id_len = strlen(client_id);
+    size_t pos = mqttsn_frame_hdr(buf, 4 + id_len, MQTTSN_FRAME_CONNECT);
+
+    buf[pos++] = flags;
+    buf[pos++] = MQTTSN_FRAME_PROTOCOL_ID;
+    buf[pos++] = (uint8_t)(keepalive >> 8);
+    buf[pos++] = (uint8_t)keepalive;
+    memcpy(&buf[pos], client_id, id_len);
+    return pos + id_len;
+}
+
+size_t mqttsn_frame_pub(uint8_t *buf, size_t len, uint8_t flags,
+                        uint16_t topic_id, uint16_t msg_id)
+{
+    size_t pos = mqttsn_frame_hdr(buf, 5 + len, MQTTSN_FRAME_PUBLISH);
+
+    buf[pos++] = flags;
+    buf[pos++] = (uint8_t)(topic_id >> 8);
+    buf[pos++] = (uint8_t)topic_id;
+    buf[pos++] = (uint8_t)(msg_id >> 8);
+    buf[pos++] = (uint8_t)msg_id;
+    return pos;
+}
+
+void mqttsn_frame_set_dup(uint8_t *msg)
+{
+    msg[(msg[0] == 0x01) ? 4 : 2] |= DUP;
+}
+
+int mqttsn_frame_parse(const uint8_t *buf, size_t n, uint8_t *type,
+                       const uint8_t **body)
+{
+    size_t total;
+    size_t pos;
+
+    if ((n >= 4) && (buf[0] == 0x01)) {
+        total = ((size_t)buf[1] << 8) | buf[2];
+        pos = 3;
+    }
+    else if (n >= 2) {
+        total = buf[0];
+        pos = 1;
+    }
+    else {
+        return -EBADMSG;
+    }
+    if ((total < pos + 1) || (total > n)) {
+        return -EBADMSG;
+    }
+    *type = buf[pos];
+    *body = &buf[pos + 1];
+    return (int)(total - pos - 1);
+}
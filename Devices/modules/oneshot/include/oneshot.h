@@ -0,0 +1,157 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    oneshot Power-down sensor readings
+ * @{
+ *
+ * @file
+ * @brief       Read a sensor once and power it down until the next sample
+ *
+ * In continuous mode a sensor converts at its output data rate even if it
+ * is read every 20 seconds. The functions here wake the sensor up for one
+ * conversion, read it and put it back into power-down:
+ *
+ * - HTS221: one-shot conversion (ODR 0), then power-down
+ * - LPS331AP: the RIOT driver has no one-shot call, so the sensor is enabled
+ *   at its rate, read after one output period and disabled again
+ *
+ * Every reading is counted in a @ref oneshot_energy_t, and
+ * oneshot_energy_print() estimates the energy of the sensor per sample
+ * against the continuous mode at its rate. The estimate uses the typical
+ * supply currents of the datasheets, which can be overridden per part:
+ * the average current at one conversion per second gives the charge of a
+ * conversion, the power-down current the charge between conversions.
+ *
+ * @}
+ */
+
+#ifndef ONESHOT_H
+#define ONESHOT_H
+
+#include <stdint.h>
+
+#ifdef MODULE_HTS221
+#include "hts221.h"
+#endif
+#ifdef MODULE_LPSXXX
+#include "lpsxxx.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Supply voltage of the sensors, in mV
+ */
+#ifndef ONESHOT_SUPPLY_MV
+#define ONESHOT_SUPPLY_MV           (3300U)
+#endif
+
+/**
+ * @brief   HTS221 average current at 1 Hz and in power-down, in nA
+ */
+#ifndef ONESHOT_HTS221_CONV_NA
+#define ONESHOT_HTS221_CONV_NA      (2000U)
+#endif
+#ifndef ONESHOT_HTS221_DOWN_NA
+#define ONESHOT_HTS221_DOWN_NA      (500U)
+#endif
+
+/**
+ * @brief   Milliseconds the HTS221 gets for a one-shot conversion
+ */
+#ifndef ONESHOT_HTS221_WAIT_MS
+#define ONESHOT_HTS221_WAIT_MS      (30U)
+#endif
+
+/**
+ * @brief   LPS331AP average current at 1 Hz and in power-down, in nA
+ */
+#ifndef ONESHOT_LPSXXX_CONV_NA
+#define ONESHOT_LPSXXX_CONV_NA      (30000U)
+#endif
+#ifndef ONESHOT_LPSXXX_DOWN_NA
+#define ONESHOT_LPSXXX_DOWN_NA      (1000U)
+#endif
+
+/**
+ * @brief   Readings of one sensor and the figures of the energy estimate
+ */
+typedef struct {
+    const char *name;       /**< sensor name for the output */
+    uint32_t conv_na;       /**< nA at one conversion per second */
+    uint32_t down_na;       /**< nA in power-down */
+    uint32_t rate;          /**< Hz of the continuous mode */
+    uint32_t samples;       /**< readings so far */
+    uint32_t conversions;   /**< conversions they cost */
+    uint32_t awake_ms;      /**< ms the sensor was powered */
+    uint32_t first;         /**< ZTIMER_MSEC of the first reading */
+    uint32_t last;          /**< ZTIMER_MSEC of the latest reading */
+} oneshot_energy_t;
+
+#if defined(MODULE_HTS221) || defined(DOXYGEN)
+/**
+ * @brief   Set up the HTS221 for one-shot readings and power it down
+ *
+ * @param[in]  dev  initialized sensor
+ * @param[out] e    counters to set up
+ *
+ * @return  HTS221_OK on success, the driver error otherwise
+ */
+int oneshot_hts221_init(const hts221_t *dev, oneshot_energy_t *e);
+
+/**
+ * @brief   Power the HTS221 up, convert once, read and power it down
+ *
+ * @param[in]  dev  sensor
+ * @param[out] hum  humidity in tenths of %
+ * @param[out] temp temperature in tenths of °C
+ * @param[in]  e    counters
+ *
+ * @return  HTS221_OK on success, the driver error otherwise
+ */
+int oneshot_hts221_read(const hts221_t *dev, uint16_t *hum, int16_t *temp,
+                        oneshot_energy_t *e);
+#endif
+
+#if defined(MODULE_LPSXXX) || defined(DOXYGEN)
+/**
+ * @brief   Power the LPS331AP down until the first reading
+ *
+ * @param[in]  dev  initialized sensor
+ * @param[out] e    counters to set up
+ *
+ * @return  LPSXXX_OK on success, the driver error otherwise
+ */
+int oneshot_lpsxxx_init(const lpsxxx_t *dev, oneshot_energy_t *e);
+
+/**
+ * @brief   Enable the LPS331AP for one output period, read and disable it
+ *
+ * @param[in]  dev  sensor
+ * @param[out] temp temperature in hundredths of °C
+ * @param[in]  e    counters
+ *
+ * @return  LPSXXX_OK on success, the driver error otherwise
+ */
+int oneshot_lpsxxx_read_temp(const lpsxxx_t *dev, int16_t *temp,
+                             oneshot_energy_t *e);
+#endif
+
+/**
+ * @brief   Print the estimated sensor energy per sample, one-shot against
+ *          continuous, at the sample period seen so far
+ */
+void oneshot_energy_print(const oneshot_energy_t *e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ONESHOT_H */
@@ -0,0 +1,152 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     oneshot
+ * @{
+ *
+ * @file
+ * @brief       Power-down sensor readings implementation
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ztimer.h"
+
+#include "fixp.h"
+#include "oneshot.h"
+
+#ifdef MODULE_HTS221
+#include "hts221_regs.h"
+#endif
+
+static void _energy_init(oneshot_energy_t *e, const char *name,
+                         uint32_t conv_na, uint32_t down_na, uint32_t rate)
+{
+    memset(e, 0, sizeof(*e));
+    e->name = name;
+    e->conv_na = conv_na;
+    e->down_na = down_na;
+    e->rate = rate;
+}
+
+static void _count(oneshot_energy_t *e, uint32_t start, uint32_t conversions)
+{
+    uint32_t now = ztimer_now(ZTIMER_MSEC);
+
+    if (e->samples == 0) {
+        e->first = now;
+    }
+    e->last = now;
+    e->samples++;
+    e->conversions += conversions;
+    e->awake_ms += now - start;
+}
+
+#ifdef MODULE_HTS221
+int oneshot_hts221_init(const hts221_t *dev, oneshot_energy_t *e)
+{
+    /* Hz of the ODR settings 1 Hz, 7 Hz and 12.5 Hz, what continuous mode
+     * would have used */
+    static const uint8_t hz[] = { 0, 1, 7, 12 };
+    _energy_init(e, "hts221", ONESHOT_HTS221_CONV_NA, ONESHOT_HTS221_DOWN_NA,
+                 hz[dev->p.rate & 0x3]);
+
+    int res = hts221_set_rate(dev, HTS221_REGS_CTRL_REG1_ODR_ONE_SHOT);
+    if (res != HTS221_OK) {
+        return res;
+    }
+    return hts221_power_off(dev);
+}
+
+int oneshot_hts221_read(const hts221_t *dev, uint16_t *hum, int16_t *temp,
+                        oneshot_energy_t *e)
+{
+    uint32_t start = ztimer_now(ZTIMER_MSEC);
+    int res = hts221_power_on(dev);
+
+    if (res == HTS221_OK) {
+        res = hts221_one_shot(dev);
+    }
+    if (res == HTS221_OK) {
+        /* the MCU sleeps meanwhile, the conversion needs no CPU */
+        ztimer_sleep(ZTIMER_MSEC, ONESHOT_HTS221_WAIT_MS);
+        res = hts221_read_humidity(dev, hum);
+    }
+    if (res == HTS221_OK) {
+        res = hts221_read_temperature(dev, temp);
+    }
+    hts221_power_off(dev);
+
+    _count(e, start, 1);
+    return res;
+}
+#endif
+
+#ifdef MODULE_LPSXXX
+int oneshot_lpsxxx_init(const lpsxxx_t *dev, oneshot_energy_t *e)
+{
+    _energy_init(e, "lps331ap", ONESHOT_LPSXXX_CONV_NA, ONESHOT_LPSXXX_DOWN_NA,
+                 dev->params.rate);
+    return lpsxxx_disable(dev);
+}
+
+int oneshot_lpsxxx_read_temp(const lpsxxx_t *dev, int16_t *temp,
+                             oneshot_energy_t *e)
+{
+    uint32_t start = ztimer_now(ZTIMER_MSEC);
+    int res = lpsxxx_enable(dev);
+
+    if (res == LPSXXX_OK) {
+        /* the first conversion is done one output period after power-up */
+        uint32_t rate = dev->params.rate ? dev->params.rate : 1;
+        ztimer_sleep(ZTIMER_MSEC, (1000 / rate) + 1);
+        res = lpsxxx_read_temp(dev, temp);
+    }
+    lpsxxx_disable(dev);
+
+    _count(e, start, 1);
+    return res;
+}
+#endif
+
+/* charge in nA * ms turned into hundredths of a microjoule */
+static fixp_t _energy(uint64_t charge)
+{
+    return (fixp_t)((charge * ONESHOT_SUPPLY_MV) / 10000000ULL);
+}
+
+void oneshot_energy_print(const oneshot_energy_t *e)
+{
+    if (e->samples < 2) {
+        printf("%s: %lu readings, not enough for an estimate yet\n", e->name,
+               (unsigned long)e->samples);
+        return;
+    }
+
+    /* sample period seen so far */
+    uint32_t period = (e->last - e->first) / (e->samples - 1);
+    uint64_t conv = e->conv_na - e->down_na;
+    /* one-shot: power-down all the time plus the conversions it asked for */
+    uint64_t oneshot = (uint64_t)e->down_na * period +
+                       (conv * 1000 * e->conversions) / e->samples;
+    /* continuous: as many conversions per period as its rate gives */
+    uint64_t cont = (uint64_t)e->down_na * period + conv * e->rate * period;
+
+    char one_str[FIXP_FMT_MAXLEN];
+    char cont_str[FIXP_FMT_MAXLEN];
+    fixp_to_str(one_str, _energy(oneshot), 2);
+    fixp_to_str(cont_str, _energy(cont), 2);
+    printf("%s: %lu readings every %lu ms, awake %lu ms each, ~%s uJ per "
+           "sample one-shot, ~%s uJ continuous at %lu Hz\n", e->name,
+           (unsigned long)e->samples, (unsigned long)period,
+           (unsigned long)(e->awake_ms / e->samples), one_str, cont_str,
+           (unsigned long)e->rate);
+}
@@ -0,0 +1,67 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    perf Thread profiling
+ * @{
+ *
+ * @file
+ * @brief       CPU, stack and queue usage of the running threads
+ *
+ * For every thread the perf shell command shows:
+ *
+ * - the share of CPU time since the previous report (schedstatistics)
+ * - the stack high-water mark (needs DEVELHELP for the stack test pattern)
+ * - the depth of its message queue and the highest depth seen
+ *
+ * It also shows the largest packet the GNRC packet buffer could still
+ * allocate.
+ *
+ * Shell usage:
+ *
+ *     perf                         print the report
+ *     perf pub <topic> [seconds]   also publish it every few seconds
+ *     perf stop                    stop publishing
+ *
+ * The published report is flat Thingsboard JSON with one key per thread and
+ * value, e.g. `"cpu_emcute": 3, "stack_emcute": 612`, sent with QoS 0 on
+ * the emcute connection.
+ *
+ * @}
+ */
+
+#ifndef PERF_H
+#define PERF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Default seconds between two published reports
+ */
+#ifndef PERF_PUB_PERIOD
+#define PERF_PUB_PERIOD             (60U)
+#endif
+
+/**
+ * @brief   Largest published report
+ */
+#ifndef PERF_PAYLOAD_MAXLEN
+#define PERF_PAYLOAD_MAXLEN         (400U)
+#endif
+
+/**
+ * @brief   The perf shell command
+ */
+int perf_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_H */
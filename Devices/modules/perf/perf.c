@@ -0,0 +1,279 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     perf
+ * @{
+ *
+ * @file
+ * @brief       Thread profiling implementation
+ *
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cib.h"
+#include "mutex.h"
+#include "sched.h"
+#include "thread.h"
+#include "net/emcute.h"
+#ifdef MODULE_SCHEDSTATISTICS
+#include "schedstatistics.h"
+#endif
+#ifdef MODULE_GNRC_PKTBUF
+#include "net/gnrc/pktbuf.h"
+#endif
+
+#include "perf.h"
+#include "periodic.h"
+#include "topic_cache.h"
+
+#define NUMOF_PIDS          (KERNEL_PID_LAST + 1)
+
+/* what one report shows about a thread */
+typedef struct {
+    const char *name;
+    unsigned cpu;           /* percent since the previous report */
+    unsigned stack_used;    /* bytes, high-water mark */
+    unsigned stack_size;
+    unsigned queue;         /* messages waiting */
+    unsigned queue_size;    /* 0 without a queue */
+    unsigned queue_max;     /* highest depth seen by any report */
+} thread_info_t;
+
+/* runtime of every thread at the previous report, one per consumer so the
+ * shell and the published reports do not disturb each other */
+typedef struct {
+    uint32_t runtime[NUMOF_PIDS];
+} snapshot_t;
+
+static snapshot_t shell_snap;
+static snapshot_t pub_snap;
+static uint16_t queue_max[NUMOF_PIDS];
+static thread_info_t info[NUMOF_PIDS];
+/* held while info[] and queue_max[] are filled and read, the shell and the
+ * publishing thread both report */
+static mutex_t info_lock = MUTEX_INIT;
+
+static char pub_stack[THREAD_STACKSIZE_DEFAULT];
+static kernel_pid_t pub_pid = KERNEL_PID_UNDEF;
+static char pub_topic[TOPIC_CACHE_NAME_MAXLEN];
+static uint32_t pub_period;
+static volatile bool pub_running;
+/* locked while not publishing, the publishing thread waits on it */
+static mutex_t pub_gate = MUTEX_INIT_LOCKED;
+static char payload[PERF_PAYLOAD_MAXLEN];
+
+/* fills info[] for every existing thread, info_lock has to be held */
+static void _collect(snapshot_t *snap)
+{
+    uint32_t total = 0;
+    uint32_t delta[NUMOF_PIDS] = { 0 };
+
+#ifdef MODULE_SCHEDSTATISTICS
+    for (kernel_pid_t pid = KERNEL_PID_FIRST; pid <= KERNEL_PID_LAST; pid++) {
+        if (thread_get(pid) == NULL) {
+            snap->runtime[pid] = 0;
+            continue;
+        }
+        uint32_t runtime = sched_pidlist[pid].runtime_ticks;
+        delta[pid] = runtime - snap->runtime[pid];
+        snap->runtime[pid] = runtime;
+        total += delta[pid];
+    }
+#else
+    (void)snap;
+#endif
+
+    for (kernel_pid_t pid = KERNEL_PID_FIRST; pid <= KERNEL_PID_LAST; pid++) {
+        thread_t *t = (thread_t *)thread_get(pid);
+        thread_info_t *i = &info[pid];
+
+        memset(i, 0, sizeof(*i));
+        if (t == NULL) {
+            continue;
+        }
+        i->name = thread_getname(pid);
+        i->cpu = total ? (unsigned)(((uint64_t)delta[pid] * 100) / total) : 0;
+#ifdef DEVELHELP
+        i->stack_size = t->stack_size;
+        i->stack_used = t->stack_size - thread_measure_stack_free(t->stack_start);
+#endif
+#ifdef MODULE_CORE_MSG
+        if (t->msg_array != NULL) {
+            i->queue = cib_avail(&t->msg_queue);
+            i->queue_size = t->msg_queue.mask + 1;
+        }
+#endif
+        if (i->queue > queue_max[pid]) {
+            queue_max[pid] = i->queue;
+        }
+        i->queue_max = queue_max[pid];
+    }
+}
+
+/* largest packet the packet buffer can hold right now, found by trying */
+static unsigned _pktbuf_free(void)
+{
+#ifdef MODULE_GNRC_PKTBUF
+    unsigned lo = 0;
+    unsigned hi = GNRC_PKTBUF_SIZE;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi + 1) / 2;
+        gnrc_pktsnip_t *pkt = gnrc_pktbuf_add(NULL, NULL, mid,
+                                              GNRC_NETTYPE_UNDEF);
+        if (pkt != NULL) {
+            gnrc_pktbuf_release(pkt);
+            lo = mid;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+#else
+    return 0;
+#endif
+}
+
+static void _print(void)
+{
+    mutex_lock(&info_lock);
+    _collect(&shell_snap);
+
+    printf("%-3s %-14s %4s %15s %9s\n", "pid", "name", "cpu%", "stack used/size",
+           "queue/max");
+    for (kernel_pid_t pid = KERNEL_PID_FIRST; pid <= KERNEL_PID_LAST; pid++) {
+        const thread_info_t *i = &info[pid];
+        if (thread_get(pid) == NULL) {
+            continue;
+        }
+        printf("%3d %-14s %4u %7u/%-7u", (int)pid, i->name ? i->name : "-",
+               i->cpu, i->stack_used, i->stack_size);
+        if (i->queue_size > 0) {
+            printf(" %u/%u of %u\n", i->queue, i->queue_max, i->queue_size);
+        }
+        else {
+            puts(" -");
+        }
+    }
+    mutex_unlock(&info_lock);
+    printf("pktbuf: %u of %u bytes allocatable\n", _pktbuf_free(),
+#ifdef MODULE_GNRC_PKTBUF
+           (unsigned)GNRC_PKTBUF_SIZE);
+#else
+           0U);
+#endif
+}
+
+static int _encode(void)
+{
+    size_t len = sizeof(payload);
+    int pos = snprintf(payload, len, "{\"pktbuf_free\": %u", _pktbuf_free());
+
+    mutex_lock(&info_lock);
+    _collect(&pub_snap);
+    for (kernel_pid_t pid = KERNEL_PID_FIRST; pid <= KERNEL_PID_LAST; pid++) {
+        const thread_info_t *i = &info[pid];
+        if ((thread_get(pid) == NULL) || (i->name == NULL)) {
+            continue;
+        }
+        int n = snprintf(payload + pos, len - pos,
+                         ", \"cpu_%s\": %u, \"stack_%s\": %u, \"queue_%s\": %u",
+                         i->name, i->cpu, i->name, i->stack_used,
+                         i->name, i->queue_max);
+        /* leave out the threads that do not fit any more */
+        if ((n < 0) || ((size_t)(pos + n) >= len - 1)) {
+            break;
+        }
+        pos += n;
+    }
+    mutex_unlock(&info_lock);
+    payload[pos++] = '}';
+    payload[pos] = '\0';
+    return pos;
+}
+
+static void *_pub_thread(void *arg)
+{
+    (void)arg;
+    periodic_task_t task;
+
+    while (1) {
+        if (!pub_running) {
+            mutex_lock(&pub_gate);
+            mutex_unlock(&pub_gate);
+            periodic_init(&task, "perf", pub_period, NULL, NULL);
+        }
+
+        emcute_topic_t t;
+        unsigned flags = EMCUTE_QOS_0;
+        int len = _encode();
+        if ((topic_cache_get(&t, &flags, pub_topic) != EMCUTE_OK) ||
+            (emcute_pub(&t, payload, len, flags) != EMCUTE_OK)) {
+            puts("perf: unable to publish the report");
+        }
+
+        periodic_wait(&task);
+    }
+
+    return NULL;
+}
+
+int perf_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        _print();
+        return 0;
+    }
+    if (strcmp(argv[1], "stop") == 0) {
+        if (!pub_running) {
+            puts("error: perf reports are not published");
+            return 1;
+        }
+        mutex_lock(&pub_gate);
+        pub_running = false;
+        return 0;
+    }
+    if ((strcmp(argv[1], "pub") == 0) && (argc >= 3)) {
+        if (pub_running) {
+            puts("error: perf reports are already published, stop first");
+            return 1;
+        }
+        if (strlen(argv[2]) >= sizeof(pub_topic)) {
+            puts("error: topic name exceeds maximum possible size");
+            return 1;
+        }
+        strcpy(pub_topic, argv[2]);
+        pub_period = ((argc >= 4) ? (unsigned)atoi(argv[3]) : PERF_PUB_PERIOD);
+        if (pub_period == 0) {
+            puts("error: the period has to be at least one second");
+            return 1;
+        }
+        pub_period *= 1000;
+
+        if (pub_pid == KERNEL_PID_UNDEF) {
+            pub_pid = thread_create(pub_stack, sizeof(pub_stack),
+                                    THREAD_PRIORITY_MAIN + 1,
+                                    THREAD_CREATE_STACKTEST, _pub_thread,
+                                    NULL, "perf");
+        }
+        pub_running = true;
+        mutex_unlock(&pub_gate);
+        printf("publishing perf reports to %s every %lu s\n", pub_topic,
+               (unsigned long)(pub_period / 1000));
+        return 0;
+    }
+
+    printf("usage: %s [pub <topic> [seconds]|stop]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,107 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    periodic Drift-free periodic tasks
+ * @{
+ *
+ * @file
+ * @brief       Periodic work on absolute deadlines
+ *
+ * `xtimer_sleep(N)` after the work makes the period N seconds plus however
+ * long the work took. Here every task has an absolute deadline that moves
+ * by exactly one period per run, so the schedule never drifts. A run that
+ * ends after one or more later deadlines skips them and counts them as
+ * missed, keeping the original phase.
+ *
+ * The waits use ZTIMER_MSEC. On boards where it runs on the RTT, the MCU
+ * can stay in its lowest power mode until the next deadline without any
+ * timer tick in between.
+ *
+ * Two ways to use it:
+ *
+ * - periodic_wait() in a loop of your own, like xtimer_periodic_wakeup()
+ * - periodic_run() for several tasks with independent periods in one
+ *   thread, e.g. a sensor read every second and an uplink every minute
+ *
+ * @}
+ */
+
+#ifndef PERIODIC_H
+#define PERIODIC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Work of a task, called once per period
+ */
+typedef void (*periodic_cb_t)(void *arg);
+
+/**
+ * @brief   A periodic task and what was measured while running it
+ */
+typedef struct {
+    const char *name;       /**< shown in the statistics */
+    uint32_t period;        /**< ms */
+    uint32_t deadline;      /**< ms on ZTIMER_MSEC, next run */
+    periodic_cb_t cb;       /**< work, may be NULL with periodic_wait() */
+    void *arg;              /**< argument of @p cb */
+    uint32_t runs;          /**< deadlines met */
+    uint32_t missed;        /**< deadlines skipped, the run before was late */
+    uint32_t jitter_sum;    /**< ms, wakeup minus deadline of all runs */
+    uint32_t jitter_max;    /**< ms */
+    uint32_t start;         /**< ms on ZTIMER_MSEC, periodic_init() */
+    uint32_t slept;         /**< ms asleep waiting for this task */
+} periodic_task_t;
+
+/**
+ * @brief   Set up a task, the first deadline is one period from now
+ *
+ * @param[out] t        task to set up
+ * @param[in]  name     name in the statistics
+ * @param[in]  period   ms between two runs, not 0
+ * @param[in]  cb       work of the task, may be NULL
+ * @param[in]  arg      argument of @p cb
+ */
+void periodic_init(periodic_task_t *t, const char *name, uint32_t period,
+                   periodic_cb_t cb, void *arg);
+
+/**
+ * @brief   Sleep until the next deadline of @p t and move it one period on
+ *
+ * Does not call the callback of the task.
+ */
+void periodic_wait(periodic_task_t *t);
+
+/**
+ * @brief   Run several tasks in the calling thread, never returns
+ *
+ * Tasks due at the same time run in the order of @p tasks.
+ */
+void periodic_run(periodic_task_t *tasks, unsigned numof);
+
+/**
+ * @brief   Print the statistics of @p numof tasks and the share of time
+ *          their thread spent asleep
+ *
+ * Every task counts the time its thread slept in periodic_wait() or
+ * periodic_run() since its periodic_init(). While no other thread has work
+ * this is time the MCU spends in the lowest power mode the timers allow.
+ * The tasks of one periodic_run() share a thread, so the first of them is
+ * shown.
+ */
+void periodic_print_stats(const periodic_task_t *tasks, unsigned numof);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERIODIC_H */
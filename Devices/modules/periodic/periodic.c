@@ -0,0 +1,135 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     periodic
+ * @{
+ *
+ * @file
+ * @brief       Drift-free periodic tasks implementation
+ *
+ * @}
+ */
+
+#include <stdio.h>
+
+#include "ztimer.h"
+
+#include "periodic.h"
+
+/* all times are ms on ZTIMER_MSEC, compared with wrap-around in mind */
+
+/* returns the time slept, the caller counts it for its tasks */
+static uint32_t _sleep_until(uint32_t deadline)
+{
+    uint32_t now = ztimer_now(ZTIMER_MSEC);
+
+    if ((int32_t)(deadline - now) > 0) {
+        ztimer_sleep(ZTIMER_MSEC, deadline - now);
+        return deadline - now;
+    }
+    return 0;
+}
+
+/* account for the wakeup of a due task and move its deadline on */
+static void _advance(periodic_task_t *t, uint32_t now)
+{
+    uint32_t late = now - t->deadline;
+
+    t->runs++;
+    t->jitter_sum += late;
+    if (late > t->jitter_max) {
+        t->jitter_max = late;
+    }
+
+    /* skip the deadlines that already passed, keep the phase */
+    t->deadline += t->period;
+    if ((int32_t)(now - t->deadline) >= 0) {
+        uint32_t skip = (now - t->deadline) / t->period + 1;
+        t->missed += skip;
+        t->deadline += skip * t->period;
+    }
+}
+
+void periodic_init(periodic_task_t *t, const char *name, uint32_t period,
+                   periodic_cb_t cb, void *arg)
+{
+    uint32_t now = ztimer_now(ZTIMER_MSEC);
+
+    t->name = name;
+    t->period = period;
+    t->deadline = now + period;
+    t->cb = cb;
+    t->arg = arg;
+    t->runs = 0;
+    t->missed = 0;
+    t->jitter_sum = 0;
+    t->jitter_max = 0;
+    t->start = now;
+    t->slept = 0;
+}
+
+void periodic_wait(periodic_task_t *t)
+{
+    /* a run that took longer than a period loses the deadlines it passed */
+    uint32_t now = ztimer_now(ZTIMER_MSEC);
+    if ((int32_t)(now - t->deadline) >= (int32_t)t->period) {
+        uint32_t skip = (now - t->deadline) / t->period;
+        t->missed += skip;
+        t->deadline += skip * t->period;
+    }
+
+    t->slept += _sleep_until(t->deadline);
+    _advance(t, ztimer_now(ZTIMER_MSEC));
+}
+
+void periodic_run(periodic_task_t *tasks, unsigned numof)
+{
+    while (1) {
+        /* the earliest deadline decides how long to sleep */
+        uint32_t next = tasks[0].deadline;
+        for (unsigned i = 1; i < numof; i++) {
+            if ((int32_t)(tasks[i].deadline - next) < 0) {
+                next = tasks[i].deadline;
+            }
+        }
+        uint32_t slept = _sleep_until(next);
+
+        for (unsigned i = 0; i < numof; i++) {
+            tasks[i].slept += slept;
+        }
+        for (unsigned i = 0; i < numof; i++) {
+            periodic_task_t *t = &tasks[i];
+            uint32_t now = ztimer_now(ZTIMER_MSEC);
+            if ((int32_t)(now - t->deadline) < 0) {
+                continue;
+            }
+            _advance(t, now);
+            if (t->cb) {
+                t->cb(t->arg);
+            }
+        }
+    }
+}
+
+void periodic_print_stats(const periodic_task_t *tasks, unsigned numof)
+{
+    uint32_t up = ztimer_now(ZTIMER_MSEC) - tasks[0].start;
+    uint32_t slept = tasks[0].slept;
+
+    for (unsigned i = 0; i < numof; i++) {
+        const periodic_task_t *t = &tasks[i];
+        printf("%s: every %lu ms, %lu runs, %lu missed, jitter avg %lu ms "
+               "max %lu ms\n", t->name, (unsigned long)t->period,
+               (unsigned long)t->runs, (unsigned long)t->missed,
+               (unsigned long)(t->runs ? t->jitter_sum / t->runs : 0),
+               (unsigned long)t->jitter_max);
+    }
+    printf("asleep %lu of %lu ms (%lu%%)\n", (unsigned long)slept,
+           (unsigned long)up,
+           (unsigned long)(up ? (uint64_t)slept * 100 / up : 0));
+}
@@ -0,0 +1,97 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    pubstats MQTT-SN round trip statistics
+ * @{
+ *
+ * @file
+ * @brief       Latency histograms and per-topic counters of the publishes
+ *
+ * Every REGISTER and PUBLISH is recorded with its duration. For QoS 1 that
+ * is the round trip until the PUBACK, for QoS 0 only the time to send. The
+ * durations go into a histogram of power of two millisecond buckets per
+ * operation. Publishes are also counted per topic: messages, payload bytes
+ * and errors.
+ *
+ * Recording costs a short lookup and a few additions under a mutex.
+ *
+ * Shell usage:
+ *
+ *     stats           print histograms and topic counters
+ *     stats reset     start over
+ *
+ * @}
+ */
+
+#ifndef PUBSTATS_H
+#define PUBSTATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Histogram buckets: < 1 ms, < 2 ms, < 4 ms, ... and the rest
+ */
+#ifndef PUBSTATS_BUCKETS
+#define PUBSTATS_BUCKETS            (13U)
+#endif
+
+/**
+ * @brief   Topics counted separately, later ones are counted together
+ */
+#ifndef PUBSTATS_TOPICS
+#define PUBSTATS_TOPICS             (8U)
+#endif
+
+/**
+ * @brief   Longest topic name kept, including the terminator
+ */
+#ifndef PUBSTATS_NAME_MAXLEN
+#define PUBSTATS_NAME_MAXLEN        (32U)
+#endif
+
+/**
+ * @brief   Recorded operations
+ */
+typedef enum {
+    PUBSTATS_REGISTER,              /**< REGISTER until REGACK */
+    PUBSTATS_PUBLISH,               /**< PUBLISH, until PUBACK for QoS 1 */
+    PUBSTATS_OP_NUMOF
+} pubstats_op_t;
+
+/**
+ * @brief   Record one operation
+ *
+ * @param[in] op        operation
+ * @param[in] topic     topic name, copied and cut to PUBSTATS_NAME_MAXLEN
+ * @param[in] bytes     payload bytes, 0 for REGISTER
+ * @param[in] usec      duration
+ * @param[in] res       EMCUTE_OK or the error of the operation
+ */
+void pubstats_record(pubstats_op_t op, const char *topic, size_t bytes,
+                     uint32_t usec, int res);
+
+/**
+ * @brief   Clear all histograms and counters
+ */
+void pubstats_reset(void);
+
+/**
+ * @brief   The stats shell command
+ */
+int pubstats_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUBSTATS_H */
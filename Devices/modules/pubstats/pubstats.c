@@ -0,0 +1,189 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     pubstats
+ * @{
+ *
+ * @file
+ * @brief       MQTT-SN round trip statistics implementation
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mutex.h"
+#include "net/emcute.h"
+
+#include "pubstats.h"
+#ifdef MODULE_TOPIC_CACHE
+#include "topic_cache.h"
+#endif
+
+typedef struct {
+    uint32_t bucket[PUBSTATS_BUCKETS];
+    uint32_t count;
+    uint32_t failed;
+    uint64_t sum;       /* usec */
+    uint32_t max;       /* usec */
+} histogram_t;
+
+typedef struct {
+    char name[PUBSTATS_NAME_MAXLEN];
+    uint32_t messages;
+    uint32_t bytes;
+    uint32_t errors;
+} topic_stats_t;
+
+static const char *const op_names[] = {
+    [PUBSTATS_REGISTER] = "register",
+    [PUBSTATS_PUBLISH]  = "publish",
+};
+
+static mutex_t lock = MUTEX_INIT;
+static histogram_t hist[PUBSTATS_OP_NUMOF];
+/* the last entry collects the topics that found no entry of their own */
+static topic_stats_t topics[PUBSTATS_TOPICS + 1];
+static unsigned last_hit;
+
+static unsigned _bucket(uint32_t usec)
+{
+    uint32_t ms = usec / 1000;
+
+    /* 0 for < 1 ms, then one bucket per power of two */
+    unsigned b = (ms == 0) ? 0 : (32 - __builtin_clz(ms));
+    return (b < PUBSTATS_BUCKETS) ? b : (PUBSTATS_BUCKETS - 1);
+}
+
+static topic_stats_t *_topic(const char *name)
+{
+    /* consecutive publishes usually go to the same topic */
+    if (strncmp(topics[last_hit].name, name, PUBSTATS_NAME_MAXLEN - 1) == 0) {
+        return &topics[last_hit];
+    }
+    for (unsigned i = 0; i < PUBSTATS_TOPICS; i++) {
+        if (topics[i].name[0] == '\0') {
+            strncpy(topics[i].name, name, PUBSTATS_NAME_MAXLEN - 1);
+        }
+        if (strncmp(topics[i].name, name, PUBSTATS_NAME_MAXLEN - 1) == 0) {
+            last_hit = i;
+            return &topics[i];
+        }
+    }
+    return &topics[PUBSTATS_TOPICS];
+}
+
+void pubstats_record(pubstats_op_t op, const char *topic, size_t bytes,
+                     uint32_t usec, int res)
+{
+    histogram_t *h = &hist[op];
+
+    mutex_lock(&lock);
+    if (res == EMCUTE_OK) {
+        h->bucket[_bucket(usec)]++;
+        h->count++;
+        h->sum += usec;
+        if (usec > h->max) {
+            h->max = usec;
+        }
+    }
+    else {
+        h->failed++;
+    }
+
+    if (op == PUBSTATS_PUBLISH) {
+        topic_stats_t *t = _topic(topic);
+        if (res == EMCUTE_OK) {
+            t->messages++;
+            t->bytes += bytes;
+        }
+        else {
+            t->errors++;
+        }
+    }
+    mutex_unlock(&lock);
+}
+
+void pubstats_reset(void)
+{
+    mutex_lock(&lock);
+    memset(hist, 0, sizeof(hist));
+    memset(topics, 0, sizeof(topics));
+    last_hit = 0;
+    mutex_unlock(&lock);
+}
+
+static void _print_histogram(pubstats_op_t op, const histogram_t *h)
+{
+    printf("%s: %lu ok, %lu failed", op_names[op], (unsigned long)h->count,
+           (unsigned long)h->failed);
+    if (h->count == 0) {
+        puts("");
+        return;
+    }
+    printf(", avg %lu us, max %lu us\n",
+           (unsigned long)(h->sum / h->count), (unsigned long)h->max);
+
+    for (unsigned b = 0; b < PUBSTATS_BUCKETS; b++) {
+        if (h->bucket[b] == 0) {
+            continue;
+        }
+        if (b == PUBSTATS_BUCKETS - 1) {
+            printf("  >= %5lu ms", 1UL << (b - 1));
+        }
+        else {
+            printf("  <  %5lu ms", 1UL << b);
+        }
+        printf(" %8lu\n", (unsigned long)h->bucket[b]);
+    }
+}
+
+int pubstats_cmd(int argc, char **argv)
+{
+    if ((argc >= 2) && (strcmp(argv[1], "reset") == 0)) {
+        pubstats_reset();
+        puts("statistics cleared");
+        return 0;
+    }
+    if (argc >= 2) {
+        printf("usage: %s [reset]\n", argv[0]);
+        return 1;
+    }
+
+    /* print from a copy, publishing goes on meanwhile */
+    static histogram_t h[PUBSTATS_OP_NUMOF];
+    static topic_stats_t t[PUBSTATS_TOPICS + 1];
+    mutex_lock(&lock);
+    memcpy(h, hist, sizeof(h));
+    memcpy(t, topics, sizeof(t));
+    mutex_unlock(&lock);
+
+    for (unsigned op = 0; op < PUBSTATS_OP_NUMOF; op++) {
+        _print_histogram(op, &h[op]);
+    }
+    printf("%-32s %8s %10s %8s\n", "topic", "messages", "bytes", "errors");
+    for (unsigned i = 0; i <= PUBSTATS_TOPICS; i++) {
+        if ((t[i].messages == 0) && (t[i].errors == 0)) {
+            continue;
+        }
+        printf("%-32s %8lu %10lu %8lu\n",
+               (i == PUBSTATS_TOPICS) ? "(other)" : t[i].name,
+               (unsigned long)t[i].messages, (unsigned long)t[i].bytes,
+               (unsigned long)t[i].errors);
+    }
+
+#ifdef MODULE_TOPIC_CACHE
+    topic_cache_stats_t tc;
+    topic_cache_get_stats(&tc);
+    printf("topic cache: %lu predefined, %lu hits, %lu registrations\n",
+           (unsigned long)tc.predef, (unsigned long)tc.hits,
+           (unsigned long)tc.registrations);
+#endif
+    return 0;
+}
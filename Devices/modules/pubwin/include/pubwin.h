@@ -0,0 +1,151 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    pubwin Windowed QoS 1 MQTT-SN publisher
+ * @{
+ *
+ * @file
+ * @brief       QoS 1 publishing with several messages in flight
+ *
+ * emcute_pub() holds the emcute lock until the PUBACK arrives, so a QoS 1
+ * publish costs a full round trip to the gateway. This module keeps its own
+ * MQTT-SN session, on its own UDP socket and with its own client ID, and
+ * lets up to PUBWIN_SIZE_MAX PUBLISH messages wait for their PUBACK at the
+ * same time:
+ *
+ * - pubwin_pub() only blocks while the window is full
+ * - every message is retransmitted with the DUP flag after
+ *   PUBWIN_T_RETRY seconds, up to PUBWIN_N_RETRY times
+ * - the completion callback is called once per message, in the order the
+ *   messages were sent, even if the PUBACKs arrive out of order
+ *
+ * The session never registers topics, so only predefined topic IDs and
+ * short topic names can be published (see the topic_cache module).
+ *
+ * @}
+ */
+
+#ifndef PUBWIN_H
+#define PUBWIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/sock/udp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum number of messages waiting for their PUBACK
+ */
+#ifndef PUBWIN_SIZE_MAX
+#define PUBWIN_SIZE_MAX     (4U)
+#endif
+
+/**
+ * @brief   Largest PUBLISH message, header included
+ */
+#ifndef PUBWIN_BUFSIZE
+#define PUBWIN_BUFSIZE      (512U)
+#endif
+
+/**
+ * @brief   Seconds to wait for a PUBACK (or CONNACK) before retrying
+ */
+#ifndef PUBWIN_T_RETRY
+#define PUBWIN_T_RETRY      (5U)
+#endif
+
+/**
+ * @brief   Number of retransmissions before a message fails
+ */
+#ifndef PUBWIN_N_RETRY
+#define PUBWIN_N_RETRY      (3U)
+#endif
+
+/**
+ * @brief   Keep alive of the session in seconds, a PINGREQ is sent when
+ *          idle for half of it
+ */
+#ifndef PUBWIN_KEEPALIVE
+#define PUBWIN_KEEPALIVE    (60U)
+#endif
+
+/**
+ * @brief   Called once per message when it completed
+ *
+ * @param[in] res       EMCUTE_OK, EMCUTE_REJECT if the gateway refused it or
+ *                      EMCUTE_TIMEOUT if all retransmissions went unanswered
+ * @param[in] rtt       microseconds from the first transmission to the end
+ * @param[in] arg       argument given to pubwin_pub()
+ */
+typedef void (*pubwin_done_cb_t)(int res, uint32_t rtt, void *arg);
+
+/**
+ * @brief   Open a session to a gateway
+ *
+ * Messages still in flight of a previous session fail with EMCUTE_TIMEOUT.
+ *
+ * @param[in] gw        gateway
+ * @param[in] client_id client ID, has to differ from the emcute one
+ * @param[in] window    messages allowed in flight, 1 to PUBWIN_SIZE_MAX
+ * @param[in] cb        completion callback
+ *
+ * @return  EMCUTE_OK on success
+ * @return  EMCUTE_NOGW if the gateway did not answer
+ * @return  EMCUTE_REJECT if the gateway refused the connection
+ * @return  EMCUTE_OVERFLOW if @p window is out of range
+ */
+int pubwin_connect(const sock_udp_ep_t *gw, const char *client_id,
+                   unsigned window, pubwin_done_cb_t cb);
+
+/**
+ * @brief   Close the session, after waiting for the messages in flight
+ */
+void pubwin_disconnect(void);
+
+/**
+ * @brief   Whether a session is open
+ */
+int pubwin_is_connected(void);
+
+/**
+ * @brief   Send a QoS 1 PUBLISH, blocks while the window is full
+ *
+ * @param[in] topic_id  topic ID
+ * @param[in] flags     topic ID type (EMCUTE_TIT_PREDEF or EMCUTE_TIT_SHORT),
+ *                      EMCUTE_RETAIN is honored, the QoS is always 1
+ * @param[in] data      payload, copied
+ * @param[in] len       length of @p data
+ * @param[in] arg       passed to the completion callback
+ *
+ * @return  EMCUTE_OK if the message is on its way
+ * @return  EMCUTE_NOGW if no session is open
+ * @return  EMCUTE_OVERFLOW if the message does not fit PUBWIN_BUFSIZE
+ * @return  EMCUTE_NOTSUP for a normal (registered) topic ID
+ */
+int pubwin_pub(uint16_t topic_id, unsigned flags, const void *data,
+               size_t len, void *arg);
+
+/**
+ * @brief   Wait until no message is in flight anymore
+ */
+void pubwin_flush(void);
+
+/**
+ * @brief   Number of messages in flight
+ */
+unsigned pubwin_inflight(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUBWIN_H */
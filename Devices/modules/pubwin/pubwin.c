@@ -0,0 +1,342 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     pubwin
+ * @{
+ *
+ * @file
+ * @brief       Windowed QoS 1 MQTT-SN publisher implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "mutex.h"
+#include "sema.h"
+#include "thread.h"
+#include "xtimer.h"
+#include "net/emcute.h"
+
+#include "mqttsn_frame.h"
+#include "pubwin.h"
+
+#define CLIENT_ID_MAXLEN (23U)
+
+/* longest the receiver sleeps, bounds the retransmission delay */
+#define RX_TIMEOUT      (US_PER_SEC)
+
+enum {
+    SLOT_WAIT,          /* waiting for the PUBACK */
+    SLOT_DONE,          /* completed, waiting for the older ones */
+};
+
+typedef struct {
+    uint8_t buf[PUBWIN_BUFSIZE];
+    size_t len;
+    uint16_t msg_id;
+    uint8_t state;
+    uint8_t retries;
+    int res;
+    uint32_t sent;      /* usec, first transmission */
+    uint32_t deadline;  /* usec, next retransmission */
+    void *arg;
+} slot_t;
+
+static char stack[THREAD_STACKSIZE_DEFAULT];
+static kernel_pid_t pid = KERNEL_PID_UNDEF;
+static sock_udp_t sock;
+static sock_udp_ep_t gateway;
+static uint8_t rxbuf[32];
+
+/* protects everything below and the socket for sending */
+static mutex_t lock = MUTEX_INIT;
+static bool connected;
+static mutex_t connack = MUTEX_INIT_LOCKED;
+static uint8_t connack_rc;
+static pubwin_done_cb_t done_cb;
+static uint32_t last_tx;
+static uint16_t next_id;
+
+/* slots in send order, 'head' is the oldest of 'count' used ones */
+static slot_t slots[PUBWIN_SIZE_MAX];
+static unsigned window = 1;
+static unsigned head;
+static unsigned count;
+static sema_t free_slots;
+
+static void _send(const uint8_t *buf, size_t len)
+{
+    sock_udp_send(&sock, buf, len, &gateway);
+    last_tx = xtimer_now_usec();
+}
+
+static void _send_simple(uint8_t type)
+{
+    uint8_t buf[2];
+
+    mqttsn_frame_hdr(buf, 0, type);
+    _send(buf, sizeof(buf));
+}
+
+/* completes every message still waiting, lock must be held */
+static void _fail_all(void)
+{
+    for (unsigned i = 0; i < count; i++) {
+        slot_t *slot = &slots[(head + i) % window];
+        if (slot->state == SLOT_WAIT) {
+            slot->state = SLOT_DONE;
+            slot->res = EMCUTE_TIMEOUT;
+        }
+    }
+}
+
+/* calls the callback for completed messages in send order, lock must be
+ * held and is released while the callback runs */
+static void _deliver(void)
+{
+    while ((count > 0) && (slots[head].state == SLOT_DONE)) {
+        slot_t *slot = &slots[head];
+        int res = slot->res;
+        uint32_t rtt = xtimer_now_usec() - slot->sent;
+        void *arg = slot->arg;
+
+        head = (head + 1) % window;
+        count--;
+
+        mutex_unlock(&lock);
+        if (done_cb) {
+            done_cb(res, rtt, arg);
+        }
+        sema_post(&free_slots);
+        mutex_lock(&lock);
+    }
+}
+
+static void _on_puback(const uint8_t *msg, size_t len)
+{
+    if (len < 5) {
+        return;
+    }
+    uint16_t msg_id = ((uint16_t)msg[2] << 8) | msg[3];
+
+    for (unsigned i = 0; i < count; i++) {
+        slot_t *slot = &slots[(head + i) % window];
+        if ((slot->state == SLOT_WAIT) && (slot->msg_id == msg_id)) {
+            slot->state = SLOT_DONE;
+            slot->res = (msg[4] == 0) ? EMCUTE_OK : EMCUTE_REJECT;
+            return;
+        }
+    }
+}
+
+static void _retransmit(uint32_t now)
+{
+    for (unsigned i = 0; i < count; i++) {
+        slot_t *slot = &slots[(head + i) % window];
+        if ((slot->state != SLOT_WAIT) ||
+            ((int32_t)(now - slot->deadline) < 0)) {
+            continue;
+        }
+        if (slot->retries >= PUBWIN_N_RETRY) {
+            slot->state = SLOT_DONE;
+            slot->res = EMCUTE_TIMEOUT;
+            continue;
+        }
+        mqttsn_frame_set_dup(slot->buf);
+        _send(slot->buf, slot->len);
+        slot->retries++;
+        slot->deadline = now + (PUBWIN_T_RETRY * US_PER_SEC);
+    }
+}
+
+static void *_thread(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        sock_udp_ep_t remote;
+        ssize_t n = sock_udp_recv(&sock, rxbuf, sizeof(rxbuf), RX_TIMEOUT,
+                                  &remote);
+        const uint8_t *msg;
+        uint8_t type;
+        int len = (n > 0) ? mqttsn_frame_parse(rxbuf, n, &type, &msg)
+                          : -EBADMSG;
+
+        mutex_lock(&lock);
+        if (len >= 0) {
+            switch (type) {
+                case MQTTSN_FRAME_CONNACK:
+                    if (len >= 1) {
+                        connack_rc = msg[0];
+                        mutex_unlock(&connack);
+                    }
+                    break;
+                case MQTTSN_FRAME_PUBACK:
+                    _on_puback(msg, len);
+                    break;
+                case MQTTSN_FRAME_DISCONNECT:
+                    connected = false;
+                    _fail_all();
+                    break;
+                default:
+                    /* PINGRESP and anything else */
+                    break;
+            }
+        }
+
+        uint32_t now = xtimer_now_usec();
+        _retransmit(now);
+        if (connected &&
+            ((now - last_tx) > (PUBWIN_KEEPALIVE * US_PER_SEC / 2))) {
+            _send_simple(MQTTSN_FRAME_PINGREQ);
+        }
+        _deliver();
+        mutex_unlock(&lock);
+    }
+
+    return NULL;
+}
+
+int pubwin_connect(const sock_udp_ep_t *gw, const char *client_id,
+                   unsigned win, pubwin_done_cb_t cb)
+{
+    uint8_t buf[MQTTSN_FRAME_CONNECT_LEN(CLIENT_ID_MAXLEN)];
+    size_t id_len = strlen(client_id);
+
+    if ((win < 1) || (win > PUBWIN_SIZE_MAX) ||
+        (id_len > CLIENT_ID_MAXLEN)) {
+        return EMCUTE_OVERFLOW;
+    }
+
+    if (pid == KERNEL_PID_UNDEF) {
+        sock_udp_ep_t local = SOCK_IPV6_EP_ANY;
+        if (sock_udp_create(&sock, &local, NULL, 0) < 0) {
+            return EMCUTE_NOGW;
+        }
+        pid = thread_create(stack, sizeof(stack), THREAD_PRIORITY_MAIN - 1,
+                            THREAD_CREATE_STACKTEST, _thread, NULL, "pubwin");
+    }
+
+    mutex_lock(&lock);
+    /* whatever is still in flight belongs to the old session */
+    _fail_all();
+    _deliver();
+    connected = false;
+    gateway = *gw;
+    window = win;
+    head = 0;
+    count = 0;
+    done_cb = cb;
+    sema_create(&free_slots, win);
+    /* make sure a late CONNACK of an earlier attempt is not taken */
+    mutex_trylock(&connack);
+
+    size_t pos = mqttsn_frame_connect(buf, EMCUTE_CS, PUBWIN_KEEPALIVE,
+                                      client_id);
+    mutex_unlock(&lock);
+
+    for (unsigned i = 0; i <= PUBWIN_N_RETRY; i++) {
+        mutex_lock(&lock);
+        _send(buf, pos);
+        mutex_unlock(&lock);
+        if (xtimer_mutex_lock_timeout(&connack,
+                                      PUBWIN_T_RETRY * US_PER_SEC) == 0) {
+            if (connack_rc != 0) {
+                return EMCUTE_REJECT;
+            }
+            connected = true;
+            return EMCUTE_OK;
+        }
+    }
+    return EMCUTE_NOGW;
+}
+
+void pubwin_disconnect(void)
+{
+    if (!connected) {
+        return;
+    }
+    pubwin_flush();
+
+    mutex_lock(&lock);
+    _send_simple(MQTTSN_FRAME_DISCONNECT);
+    connected = false;
+    mutex_unlock(&lock);
+}
+
+int pubwin_is_connected(void)
+{
+    return connected;
+}
+
+int pubwin_pub(uint16_t topic_id, unsigned flags, const void *data,
+               size_t len, void *arg)
+{
+    unsigned tit = flags & EMCUTE_TIT_MASK;
+
+    if (tit == EMCUTE_TIT_NORMAL) {
+        return EMCUTE_NOTSUP;
+    }
+    if (len + MQTTSN_FRAME_PUB_HDR_MAXLEN > PUBWIN_BUFSIZE) {
+        return EMCUTE_OVERFLOW;
+    }
+    if (!connected) {
+        return EMCUTE_NOGW;
+    }
+
+    sema_wait(&free_slots);
+    mutex_lock(&lock);
+    if (!connected) {
+        mutex_unlock(&lock);
+        sema_post(&free_slots);
+        return EMCUTE_NOGW;
+    }
+
+    slot_t *slot = &slots[(head + count) % window];
+    count++;
+
+    /* message IDs wrap around but are never 0 */
+    if (++next_id == 0) {
+        next_id = 1;
+    }
+    size_t pos = mqttsn_frame_pub(slot->buf, len,
+                                  EMCUTE_QOS_1 | tit | (flags & EMCUTE_RETAIN),
+                                  topic_id, next_id);
+    memcpy(&slot->buf[pos], data, len);
+    slot->len = pos + len;
+    slot->msg_id = next_id;
+    slot->state = SLOT_WAIT;
+    slot->retries = 0;
+    slot->arg = arg;
+
+    _send(slot->buf, slot->len);
+    slot->sent = last_tx;
+    slot->deadline = last_tx + (PUBWIN_T_RETRY * US_PER_SEC);
+    mutex_unlock(&lock);
+
+    return EMCUTE_OK;
+}
+
+void pubwin_flush(void)
+{
+    /* all slots free means nothing is in flight */
+    for (unsigned i = 0; i < window; i++) {
+        sema_wait(&free_slots);
+    }
+    for (unsigned i = 0; i < window; i++) {
+        sema_post(&free_slots);
+    }
+}
+
+unsigned pubwin_inflight(void)
+{
+    return count;
+}
@@ -0,0 +1,181 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    qosm1 Connectionless MQTT-SN QoS -1 publisher
+ * @{
+ *
+ * @file
+ * @brief       Fire-and-forget PUBLISH messages without CONNECT or REGISTER
+ *
+ * A node that wakes up, sends one reading and goes back to sleep pays for
+ * CONNECT/CONNACK, maybe REGISTER/REGACK and DISCONNECT before and after
+ * its single PUBLISH with emcute. With QoS -1 the PUBLISH is the only
+ * message: it goes from its own UDP socket straight to the gateway, with no
+ * session, no answer and no retransmission.
+ *
+ * Only topics the gateway knows without a REGISTER can be used: the
+ * predefined topics of Gateway/predefined_topics.csv and two character
+ * short topic names. The gateway needs QoS-1=YES and the node in its
+ * ClientsList, see Gateway/gateway_qosm1.conf.
+ *
+ * qosm1_pub() copies the payload into the transmit buffer. A caller that
+ * builds the payload anyway can write it there directly instead:
+ * qosm1_pub_begin() hands out the payload part of the buffer, and
+ * qosm1_pub_commit() puts the PUBLISH header right in front of it and sends
+ * the message without copying it again.
+ *
+ * Shell usage:
+ *
+ *     qosm1 <gateway ipv6 addr> [port]     set the gateway
+ *     qosm1                                show the gateway and the counters
+ *
+ * @}
+ */
+
+#ifndef QOSM1_H
+#define QOSM1_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mqttsn_frame.h"
+#include "net/emcute.h"
+#include "net/sock/udp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   QoS -1 in the emcute flags, the same bits as on the wire
+ */
+#define QOSM1_QOS           (EMCUTE_QOS_MASK)
+
+/**
+ * @brief   Local UDP port, the gateway's ClientsList identifies the node by
+ *          its address and this port
+ */
+#ifndef QOSM1_LOCAL_PORT
+#define QOSM1_LOCAL_PORT    (1886U)
+#endif
+
+/**
+ * @brief   Default gateway port
+ */
+#ifndef QOSM1_GW_PORT
+#define QOSM1_GW_PORT       (1885U)
+#endif
+
+/**
+ * @brief   Largest PUBLISH message, header included
+ */
+#ifndef QOSM1_BUFSIZE
+#define QOSM1_BUFSIZE       (512U)
+#endif
+
+/**
+ * @brief   PUBLISH header of a payload shorter than 249 bytes
+ */
+#define QOSM1_HDR_LEN       (MQTTSN_FRAME_PUB_HDR_MAXLEN - 2U)
+
+/**
+ * @brief   PUBLISH header with a three byte length, room qosm1_pub_begin()
+ *          keeps in front of the payload
+ */
+#define QOSM1_HDR_MAXLEN    (MQTTSN_FRAME_PUB_HDR_MAXLEN)
+
+/**
+ * @brief   What was sent so far
+ */
+typedef struct {
+    uint32_t messages;      /**< PUBLISH messages sent */
+    uint32_t bytes;         /**< MQTT-SN bytes sent, headers included */
+    uint32_t failed;        /**< messages the socket refused */
+} qosm1_stats_t;
+
+/**
+ * @brief   Set the gateway, opens the socket on the first call
+ *
+ * @param[in] gw    gateway address and port
+ *
+ * @return  EMCUTE_OK on success
+ * @return  EMCUTE_NOGW if the socket could not be created
+ */
+int qosm1_set_gateway(const sock_udp_ep_t *gw);
+
+/**
+ * @brief   Get the topic ID the gateway knows @p name by
+ *
+ * @param[in]  name     topic name
+ * @param[out] id       predefined topic ID or short topic name
+ * @param[out] tit      EMCUTE_TIT_PREDEF or EMCUTE_TIT_SHORT
+ *
+ * @return  EMCUTE_OK on success
+ * @return  EMCUTE_NOTSUP if @p name is neither predefined nor short
+ */
+int qosm1_topic(const char *name, uint16_t *id, unsigned *tit);
+
+/**
+ * @brief   Send one QoS -1 PUBLISH
+ *
+ * @param[in] topic     predefined topic or short topic name
+ * @param[in] data      payload
+ * @param[in] len       length of @p data
+ *
+ * @return  EMCUTE_OK once the message is handed to the network stack
+ * @return  EMCUTE_NOGW if no gateway was set
+ * @return  EMCUTE_NOTSUP if the gateway cannot know @p topic
+ * @return  EMCUTE_OVERFLOW if the message exceeds QOSM1_BUFSIZE
+ * @return  EMCUTE_REJECT if the network stack refused the message
+ */
+int qosm1_pub(const char *topic, const void *data, size_t len);
+
+/**
+ * @brief   Reserve the transmit buffer to write a payload into
+ *
+ * Other senders wait until the message is committed or aborted, so nothing
+ * else may be sent through this module in between.
+ *
+ * @param[out] room     bytes the payload may take
+ *
+ * @return  where the payload goes
+ */
+void *qosm1_pub_begin(size_t *room);
+
+/**
+ * @brief   Send the payload written after qosm1_pub_begin()
+ *
+ * Releases the transmit buffer in any case.
+ *
+ * @param[in] topic     predefined topic or short topic name
+ * @param[in] len       length of the payload
+ *
+ * @return  the same as qosm1_pub()
+ */
+int qosm1_pub_commit(const char *topic, size_t len);
+
+/**
+ * @brief   Release the transmit buffer without sending anything
+ */
+void qosm1_pub_abort(void);
+
+/**
+ * @brief   Get a copy of the counters
+ */
+void qosm1_get_stats(qosm1_stats_t *stats);
+
+/**
+ * @brief   The qosm1 shell command
+ */
+int qosm1_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QOSM1_H */
@@ -0,0 +1,190 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     qosm1
+ * @{
+ *
+ * @file
+ * @brief       Connectionless MQTT-SN QoS -1 publisher implementation
+ *
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel_defines.h"
+#include "mutex.h"
+#include "net/ipv6/addr.h"
+
+#include "predefined_topics.h"
+#include "qosm1.h"
+
+static const struct {
+    const char *name;
+    uint16_t id;
+} predef[] = PREDEF_TOPICS_INIT;
+
+/* protects everything below */
+static mutex_t lock = MUTEX_INIT;
+static sock_udp_t sock;
+static bool have_sock;
+static sock_udp_ep_t gateway;
+static bool have_gateway;
+static qosm1_stats_t stats;
+static uint8_t buf[QOSM1_BUFSIZE];
+
+int qosm1_set_gateway(const sock_udp_ep_t *gw)
+{
+    int res = EMCUTE_OK;
+
+    mutex_lock(&lock);
+    if (!have_sock) {
+        sock_udp_ep_t local = SOCK_IPV6_EP_ANY;
+        local.port = QOSM1_LOCAL_PORT;
+        have_sock = (sock_udp_create(&sock, &local, NULL, 0) == 0);
+    }
+    if (have_sock) {
+        gateway = *gw;
+        have_gateway = true;
+    }
+    else {
+        res = EMCUTE_NOGW;
+    }
+    mutex_unlock(&lock);
+    return res;
+}
+
+int qosm1_topic(const char *name, uint16_t *id, unsigned *tit)
+{
+    for (unsigned i = 0; i < ARRAY_SIZE(predef); i++) {
+        if (strcmp(predef[i].name, name) == 0) {
+            *id = predef[i].id;
+            *tit = EMCUTE_TIT_PREDEF;
+            return EMCUTE_OK;
+        }
+    }
+    /* a short topic name is its own ID */
+    if ((strlen(name) == 2) && (strpbrk(name, "+#") == NULL)) {
+        *id = ((uint16_t)(uint8_t)name[0] << 8) | (uint8_t)name[1];
+        *tit = EMCUTE_TIT_SHORT;
+        return EMCUTE_OK;
+    }
+    return EMCUTE_NOTSUP;
+}
+
+void *qosm1_pub_begin(size_t *room)
+{
+    mutex_lock(&lock);
+    *room = sizeof(buf) - QOSM1_HDR_MAXLEN;
+    return &buf[QOSM1_HDR_MAXLEN];
+}
+
+int qosm1_pub_commit(const char *topic, size_t len)
+{
+    uint16_t id;
+    unsigned tit;
+    int res = EMCUTE_OK;
+
+    if (qosm1_topic(topic, &id, &tit) != EMCUTE_OK) {
+        res = EMCUTE_NOTSUP;
+    }
+    else if (len > sizeof(buf) - QOSM1_HDR_MAXLEN) {
+        res = EMCUTE_OVERFLOW;
+    }
+    else if (!have_gateway) {
+        res = EMCUTE_NOGW;
+    }
+    if (res != EMCUTE_OK) {
+        mutex_unlock(&lock);
+        return res;
+    }
+
+    /* the header goes right in front of the payload, no session, the
+     * message ID is always 0 */
+    uint8_t *msg = &buf[QOSM1_HDR_MAXLEN - mqttsn_frame_pub_hdrlen(len)];
+    size_t total = mqttsn_frame_pub(msg, len, QOSM1_QOS | tit, id, 0) + len;
+
+    if (sock_udp_send(&sock, msg, total, &gateway) < 0) {
+        stats.failed++;
+        res = EMCUTE_REJECT;
+    }
+    else {
+        stats.messages++;
+        stats.bytes += total;
+    }
+    mutex_unlock(&lock);
+    return res;
+}
+
+void qosm1_pub_abort(void)
+{
+    mutex_unlock(&lock);
+}
+
+int qosm1_pub(const char *topic, const void *data, size_t len)
+{
+    size_t room;
+    void *payload = qosm1_pub_begin(&room);
+
+    if (len > room) {
+        qosm1_pub_abort();
+        return EMCUTE_OVERFLOW;
+    }
+    memcpy(payload, data, len);
+    return qosm1_pub_commit(topic, len);
+}
+
+void qosm1_get_stats(qosm1_stats_t *out)
+{
+    mutex_lock(&lock);
+    *out = stats;
+    mutex_unlock(&lock);
+}
+
+int qosm1_cmd(int argc, char **argv)
+{
+    if (argc >= 2) {
+        sock_udp_ep_t gw = { .family = AF_INET6, .port = QOSM1_GW_PORT };
+
+        if (ipv6_addr_from_str((ipv6_addr_t *)&gw.addr.ipv6, argv[1]) == NULL) {
+            printf("usage: %s [<gateway ipv6 addr> [port]]\n", argv[0]);
+            return 1;
+        }
+        if (argc >= 3) {
+            gw.port = atoi(argv[2]);
+        }
+        if (qosm1_set_gateway(&gw) != EMCUTE_OK) {
+            printf("error: unable to open UDP port %u\n", QOSM1_LOCAL_PORT);
+            return 1;
+        }
+        printf("QoS -1 messages go to [%s]:%u from port %u\n", argv[1],
+               (unsigned)gw.port, QOSM1_LOCAL_PORT);
+        return 0;
+    }
+
+    qosm1_stats_t s;
+    char addr[IPV6_ADDR_MAX_STR_LEN];
+
+    mutex_lock(&lock);
+    if (have_gateway) {
+        ipv6_addr_to_str(addr, (ipv6_addr_t *)&gateway.addr.ipv6, sizeof(addr));
+        printf("gateway [%s]:%u\n", addr, (unsigned)gateway.port);
+    }
+    else {
+        puts("no gateway set");
+    }
+    mutex_unlock(&lock);
+
+    qosm1_get_stats(&s);
+    printf("%lu messages, %lu bytes, %lu failed\n", (unsigned long)s.messages,
+           (unsigned long)s.bytes, (unsigned long)s.failed);
+    return 0;
+}
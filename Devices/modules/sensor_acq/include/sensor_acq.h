@@ -0,0 +1,119 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sensor_acq SAUL sensor acquisition
+ * @{
+ *
+ * @file
+ * @brief       Reads every SAUL sensor in one pass and publishes them all in
+ *              a single message
+ *
+ * sensor_acq_init() walks the SAUL registry once and keeps every device of
+ * the sensor category, so the M3 gets its temperature, pressure, light,
+ * accelerometer, magnetometer and gyroscope without any code per driver.
+ * Each value gets a JSON key after its class, with _x, _y and _z for
+ * three-axis sensors and a number if a class shows up twice:
+ *
+ *     {"ts": 1700000000000, "values": {"device": "1", "temperature": 21.5,
+ *      "pressure": 1013, "light": 312, "accel_x": -0.016, ...}}
+ *
+ * Shell usage:
+ *
+ *     sensors                              read all sensors and list them
+ *     sensors pub <topic> [seconds] [QoS]  publish a pass every few seconds
+ *     sensors stop
+ *
+ * @}
+ */
+
+#ifndef SENSOR_ACQ_H
+#define SENSOR_ACQ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "phydat.h"
+#include "saul_reg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Most SAUL sensors kept
+ */
+#ifndef SENSOR_ACQ_NUMOF
+#define SENSOR_ACQ_NUMOF            (12U)
+#endif
+
+/**
+ * @brief   Default seconds between two published passes
+ */
+#ifndef SENSOR_ACQ_PERIOD
+#define SENSOR_ACQ_PERIOD           (60U)
+#endif
+
+/**
+ * @brief   Largest published pass, has to stay below EMCUTE_BUFSIZE
+ */
+#ifndef SENSOR_ACQ_PAYLOAD_MAXLEN
+#define SENSOR_ACQ_PAYLOAD_MAXLEN   (480U)
+#endif
+
+/**
+ * @brief   Longest JSON key of a sensor, including the terminator
+ */
+#define SENSOR_ACQ_KEY_MAXLEN       (14U)
+
+/**
+ * @brief   A SAUL sensor and its latest reading
+ */
+typedef struct {
+    saul_reg_t *dev;                    /**< registry entry */
+    char key[SENSOR_ACQ_KEY_MAXLEN];    /**< JSON key, without axis suffix */
+    phydat_t data;                      /**< latest reading */
+    int dims;                           /**< dimensions read, <= 0 on error */
+} sensor_acq_entry_t;
+
+/**
+ * @brief   Find the sensors in the SAUL registry, call after auto_init
+ *
+ * @return  number of sensors found
+ */
+unsigned sensor_acq_init(void);
+
+/**
+ * @brief   Read all sensors once
+ *
+ * @return  number of sensors read successfully
+ */
+unsigned sensor_acq_read(void);
+
+/**
+ * @brief   Encode the latest pass as Thingsboard JSON
+ *
+ * @param[out] buf      output buffer
+ * @param[in]  len      size of @p buf
+ * @param[in]  device   device number
+ * @param[in]  ts       milliseconds since the epoch
+ *
+ * @return  length of the JSON without the terminator
+ * @return  -EOVERFLOW if it does not fit into @p buf
+ */
+int sensor_acq_json(char *buf, size_t len, uint8_t device, uint64_t ts);
+
+/**
+ * @brief   The sensors shell command
+ */
+int sensor_acq_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_ACQ_H */
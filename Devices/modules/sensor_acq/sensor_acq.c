@@ -0,0 +1,298 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_acq
+ * @{
+ *
+ * @file
+ * @brief       SAUL sensor acquisition implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mutex.h"
+#include "thread.h"
+#include "ztimer.h"
+#include "net/emcute.h"
+
+#include "periodic.h"
+#include "sensor_acq.h"
+#include "topic_cache.h"
+
+static const struct {
+    uint8_t type;
+    const char *key;
+} keys[] = {
+    { SAUL_SENSE_TEMP,  "temperature" },
+    { SAUL_SENSE_HUM,   "humidity" },
+    { SAUL_SENSE_PRESS, "pressure" },
+    { SAUL_SENSE_LIGHT, "light" },
+    { SAUL_SENSE_ACCEL, "accel" },
+    { SAUL_SENSE_MAG,   "mag" },
+    { SAUL_SENSE_GYRO,  "gyro" },
+};
+
+static const char axis[] = { 'x', 'y', 'z' };
+
+/* filled once by sensor_acq_init(), read by the shell and the thread */
+static mutex_t lock = MUTEX_INIT;
+static sensor_acq_entry_t sensors[SENSOR_ACQ_NUMOF];
+static unsigned numof;
+static uint32_t pass_ms;
+
+static char stack[THREAD_STACKSIZE_DEFAULT];
+static kernel_pid_t pid = KERNEL_PID_UNDEF;
+static char topic[TOPIC_CACHE_NAME_MAXLEN];
+static unsigned flags;
+static uint32_t period;
+static volatile bool running;
+/* locked while not publishing, the thread waits on it */
+static mutex_t gate = MUTEX_INIT_LOCKED;
+static char payload[SENSOR_ACQ_PAYLOAD_MAXLEN];
+
+static void _key(sensor_acq_entry_t *s, unsigned index)
+{
+    const char *key = NULL;
+    unsigned same = 0;
+
+    for (unsigned i = 0; i < (sizeof(keys) / sizeof(keys[0])); i++) {
+        if (keys[i].type == s->dev->driver->type) {
+            key = keys[i].key;
+        }
+    }
+    if (key == NULL) {
+        snprintf(s->key, sizeof(s->key), "sensor%u", index);
+        return;
+    }
+    /* a second sensor of the same class, e.g. the temperature of the IMU */
+    for (unsigned i = 0; i < index; i++) {
+        same += (sensors[i].dev->driver->type == s->dev->driver->type);
+    }
+    if (same > 0) {
+        snprintf(s->key, sizeof(s->key), "%s%u", key, same + 1);
+    }
+    else {
+        snprintf(s->key, sizeof(s->key), "%s", key);
+    }
+}
+
+unsigned sensor_acq_init(void)
+{
+    mutex_lock(&lock);
+    numof = 0;
+    for (saul_reg_t *dev = saul_reg; dev && (numof < SENSOR_ACQ_NUMOF);
+         dev = dev->next) {
+        if ((dev->driver->type & SAUL_CAT_MASK) != SAUL_CAT_SENSE) {
+            continue;
+        }
+        sensors[numof].dev = dev;
+        sensors[numof].dims = 0;
+        _key(&sensors[numof], numof);
+        numof++;
+    }
+    mutex_unlock(&lock);
+    return numof;
+}
+
+unsigned sensor_acq_read(void)
+{
+    unsigned ok = 0;
+
+    mutex_lock(&lock);
+    uint32_t start = ztimer_now(ZTIMER_MSEC);
+    for (unsigned i = 0; i < numof; i++) {
+        sensors[i].dims = saul_reg_read(sensors[i].dev, &sensors[i].data);
+        ok += (sensors[i].dims > 0);
+    }
+    pass_ms = ztimer_now(ZTIMER_MSEC) - start;
+    mutex_unlock(&lock);
+    return ok;
+}
+
+/* val * 10^scale without floating point */
+static int _fmt(char *buf, size_t len, int16_t val, int8_t scale)
+{
+    if (scale >= 0) {
+        long v = val;
+        while (scale-- > 0) {
+            v *= 10;
+        }
+        return snprintf(buf, len, "%ld", v);
+    }
+
+    unsigned div = 1;
+    for (int8_t i = scale; i < 0; i++) {
+        div *= 10;
+    }
+    unsigned mag = (val < 0) ? -(int)val : val;
+    return snprintf(buf, len, "%s%u.%0*u", (val < 0) ? "-" : "", mag / div,
+                    -scale, mag % div);
+}
+
+int sensor_acq_json(char *buf, size_t len, uint8_t device, uint64_t ts)
+{
+    size_t pos = 0;
+    int n = snprintf(buf, len, "{\"ts\": %llu, \"values\": {\"device\": \"%u\"",
+                     (unsigned long long)ts, device);
+
+    mutex_lock(&lock);
+    for (unsigned i = 0; (n >= 0) && (i < numof); i++) {
+        pos += n;
+        n = 0;
+        if ((pos >= len) || (sensors[i].dims <= 0)) {
+            continue;
+        }
+        for (int d = 0; (n >= 0) && (d < sensors[i].dims); d++) {
+            pos += n;
+            if (pos >= len) {
+                break;
+            }
+            if (sensors[i].dims > 1) {
+                n = snprintf(buf + pos, len - pos, ", \"%s_%c\": ",
+                             sensors[i].key, axis[d]);
+            }
+            else {
+                n = snprintf(buf + pos, len - pos, ", \"%s\": ", sensors[i].key);
+            }
+            pos += n;
+            if (pos >= len) {
+                break;
+            }
+            n = _fmt(buf + pos, len - pos, sensors[i].data.val[d],
+                     sensors[i].data.scale);
+        }
+    }
+    mutex_unlock(&lock);
+
+    pos += n;
+    if (pos < len) {
+        pos += snprintf(buf + pos, len - pos, "}}");
+    }
+    if ((n < 0) || (pos >= len)) {
+        return -EOVERFLOW;
+    }
+    return pos;
+}
+
+static void _print(void)
+{
+    char val[16];
+
+    mutex_lock(&lock);
+    for (unsigned i = 0; i < numof; i++) {
+        printf("%-12s %-16s", sensors[i].key, sensors[i].dev->name);
+        if (sensors[i].dims <= 0) {
+            printf(" read error %d\n", sensors[i].dims);
+            continue;
+        }
+        for (int d = 0; d < sensors[i].dims; d++) {
+            _fmt(val, sizeof(val), sensors[i].data.val[d], sensors[i].data.scale);
+            printf(" %s", val);
+        }
+        printf(" %s\n", phydat_unit_to_str(sensors[i].data.unit));
+    }
+    printf("%u sensors read in %lu ms\n", numof, (unsigned long)pass_ms);
+    mutex_unlock(&lock);
+}
+
+static void *_pub_thread(void *arg)
+{
+    (void)arg;
+    periodic_task_t task;
+
+    while (1) {
+        if (!running) {
+            mutex_lock(&gate);
+            mutex_unlock(&gate);
+            periodic_init(&task, "sensors", period, NULL, NULL);
+        }
+
+        sensor_acq_read();
+        int len = sensor_acq_json(payload, sizeof(payload), 1,
+                                  (uint64_t)time(NULL) * 1000);
+        emcute_topic_t t;
+        unsigned f = flags;
+        if (len < 0) {
+            puts("sensors: the pass does not fit into one message");
+        }
+        else if ((topic_cache_get(&t, &f, topic) != EMCUTE_OK) ||
+                 (emcute_pub(&t, payload, len, f) != EMCUTE_OK)) {
+            printf("sensors: unable to publish to %s\n", topic);
+        }
+
+        periodic_wait(&task);
+    }
+
+    return NULL;
+}
+
+static unsigned _get_qos(const char *str)
+{
+    switch (atoi(str)) {
+        case 1:     return EMCUTE_QOS_1;
+        case 2:     return EMCUTE_QOS_2;
+        default:    return EMCUTE_QOS_0;
+    }
+}
+
+int sensor_acq_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        sensor_acq_read();
+        _print();
+        return 0;
+    }
+    if (strcmp(argv[1], "stop") == 0) {
+        if (!running) {
+            puts("error: sensors are not published");
+            return 1;
+        }
+        mutex_lock(&gate);
+        running = false;
+        return 0;
+    }
+    if ((strcmp(argv[1], "pub") == 0) && (argc >= 3)) {
+        if (running) {
+            puts("error: sensors are already published, stop first");
+            return 1;
+        }
+        if (strlen(argv[2]) >= sizeof(topic)) {
+            puts("error: topic name exceeds maximum possible size");
+            return 1;
+        }
+        uint32_t secs = (argc >= 4) ? (unsigned)atoi(argv[3]) : SENSOR_ACQ_PERIOD;
+        if (secs == 0) {
+            puts("error: the period has to be at least one second");
+            return 1;
+        }
+        strcpy(topic, argv[2]);
+        flags = (argc >= 5) ? _get_qos(argv[4]) : EMCUTE_QOS_0;
+        period = secs * 1000;
+
+        if (pid == KERNEL_PID_UNDEF) {
+            pid = thread_create(stack, sizeof(stack), THREAD_PRIORITY_MAIN + 1,
+                                THREAD_CREATE_STACKTEST, _pub_thread, NULL,
+                                "sensors");
+        }
+        running = true;
+        mutex_unlock(&gate);
+        printf("publishing %u sensors to %s every %lu s\n", numof, topic,
+               (unsigned long)secs);
+        return 0;
+    }
+
+    printf("usage: %s [pub <topic> [seconds] [QoS level]|stop]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,118 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sensor_cache Background sensor sampling
+ * @{
+ *
+ * @file
+ * @brief       Latest reading of a sensor, refreshed by a thread of its own
+ *
+ * A thread reads the sensor every period and keeps the newest reading with
+ * its timestamp. Commands that publish take the cached reading instead of
+ * waiting for the bus, as long as it is not older than the maximum age.
+ *
+ * The thread only reads while the readings are asked for: it starts with
+ * the first sensor_cache_get() or `cache <period>` and goes back to sleep
+ * once nobody asked for SENSOR_CACHE_IDLE ms. The first request after a
+ * pause finds no recent reading and has to read the sensor itself. A read
+ * that takes longer than the period stretches the period to its duration.
+ *
+ * Shell usage:
+ *
+ *     cache                        print the reading and the counters
+ *     cache <period ms> [max age ms]
+ *
+ * @}
+ */
+
+#ifndef SENSOR_CACHE_H
+#define SENSOR_CACHE_H
+
+#include <stdint.h>
+
+#include "fixp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Default milliseconds between two readings
+ */
+#ifndef SENSOR_CACHE_PERIOD
+#define SENSOR_CACHE_PERIOD         (100U)
+#endif
+
+/**
+ * @brief   Default age in milliseconds after which a reading is stale
+ */
+#ifndef SENSOR_CACHE_MAXAGE
+#define SENSOR_CACHE_MAXAGE         (1000U)
+#endif
+
+/**
+ * @brief   Milliseconds without a request after which the thread stops
+ *          reading
+ */
+#ifndef SENSOR_CACHE_IDLE
+#define SENSOR_CACHE_IDLE           (5000U)
+#endif
+
+/**
+ * @brief   Reads the sensor, called from the cache thread
+ *
+ * @param[out] v    reading in hundredths of the unit
+ *
+ * @return  0 on success, negative otherwise
+ */
+typedef int (*sensor_cache_read_cb_t)(fixp_t *v);
+
+/**
+ * @brief   Start the thread, the first reading is taken on the first request
+ *
+ * @param[in] cb    sensor to read
+ */
+void sensor_cache_init(sensor_cache_read_cb_t cb);
+
+/**
+ * @brief   Get the latest reading
+ *
+ * @param[out] v    reading
+ * @param[out] ts   seconds since the epoch when it was taken, may be NULL
+ *
+ * @return  0 on success
+ * @return  -EAGAIN if there was no successful reading yet
+ * @return  -ESTALE if the latest reading is older than the maximum age
+ */
+int sensor_cache_get(fixp_t *v, uint32_t *ts);
+
+/**
+ * @brief   Get the latest reading, only if it was not returned before
+ *
+ * For consumers that sample the cache and must not count one reading twice.
+ *
+ * @param[out]    v     reading
+ * @param[in,out] seq   number of the reading returned last, 0 at first;
+ *                      the number of @p v on success
+ *
+ * @return  0 on success
+ * @return  -EAGAIN if there was no new reading since @p seq
+ * @return  -ESTALE if the latest reading is older than the maximum age
+ */
+int sensor_cache_get_new(fixp_t *v, uint32_t *seq);
+
+/**
+ * @brief   The cache shell command
+ */
+int sensor_cache_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_CACHE_H */
@@ -0,0 +1,209 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_cache
+ * @{
+ *
+ * @file
+ * @brief       Background sensor sampling implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mutex.h"
+#include "thread.h"
+#include "ztimer.h"
+
+#include "periodic.h"
+#include "sensor_cache.h"
+
+static char stack[THREAD_STACKSIZE_DEFAULT];
+static sensor_cache_read_cb_t read_cb;
+static periodic_task_t task;
+static volatile uint32_t period = SENSOR_CACHE_PERIOD;
+static volatile uint32_t maxage = SENSOR_CACHE_MAXAGE;
+
+/* the thread only reads while someone asks for the readings */
+static mutex_t wake = MUTEX_INIT_LOCKED;
+static volatile bool idle = true;
+static volatile bool used;
+static volatile uint32_t last_use;  /* ZTIMER_MSEC */
+
+/* the reading and its counters, written by the thread */
+static mutex_t lock = MUTEX_INIT;
+static bool valid;
+static fixp_t value;
+static uint32_t taken;          /* ZTIMER_MSEC */
+static uint32_t taken_ts;       /* seconds since the epoch */
+static uint32_t reads;           /* also the number of the latest reading */
+static uint32_t read_time;      /* ms of the last bus read */
+static uint32_t errors;
+static uint32_t hits;
+static uint32_t stale;
+static uint32_t wakeups;
+
+/* a consumer asked, keeps the thread reading or wakes it up */
+static void _touch(void)
+{
+    last_use = ztimer_now(ZTIMER_MSEC);
+    used = true;
+    if (idle) {
+        mutex_unlock(&wake);
+    }
+}
+
+static bool _wanted(void)
+{
+    return used && (ztimer_now(ZTIMER_MSEC) - last_use <= SENSOR_CACHE_IDLE);
+}
+
+static void *_thread(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        /* nobody asked for a while, leave the bus alone; idle is set before
+         * checking again, so _touch() either sees it or is seen */
+        while (!_wanted()) {
+            idle = true;
+            if (!_wanted()) {
+                mutex_lock(&wake);
+            }
+        }
+        if (idle) {
+            idle = false;
+            wakeups++;
+            periodic_init(&task, "sensor cache", period, NULL, NULL);
+        }
+
+        fixp_t v;
+        uint32_t start = ztimer_now(ZTIMER_MSEC);
+        int res = read_cb(&v);
+        uint32_t now = ztimer_now(ZTIMER_MSEC);
+
+        mutex_lock(&lock);
+        if (res == 0) {
+            valid = true;
+            value = v;
+            taken = now;
+            taken_ts = (uint32_t)time(NULL);
+            reads++;
+            read_time = now - start;
+        }
+        else {
+            errors++;
+        }
+        mutex_unlock(&lock);
+
+        /* the shell may have changed the period, and a read that takes
+         * longer than that would make every run late */
+        task.period = (read_time > period) ? read_time : period;
+        periodic_wait(&task);
+    }
+
+    return NULL;
+}
+
+void sensor_cache_init(sensor_cache_read_cb_t cb)
+{
+    read_cb = cb;
+    periodic_init(&task, "sensor cache", period, NULL, NULL);
+    thread_create(stack, sizeof(stack), THREAD_PRIORITY_MAIN - 2,
+                  THREAD_CREATE_STACKTEST, _thread, NULL, "sensor cache");
+}
+
+/* called with the lock held */
+static int _get(fixp_t *v)
+{
+    if (!valid) {
+        return -EAGAIN;
+    }
+    if (ztimer_now(ZTIMER_MSEC) - taken > maxage) {
+        stale++;
+        return -ESTALE;
+    }
+    hits++;
+    *v = value;
+    return 0;
+}
+
+int sensor_cache_get(fixp_t *v, uint32_t *ts)
+{
+    _touch();
+    mutex_lock(&lock);
+    int res = _get(v);
+    if ((res == 0) && ts) {
+        *ts = taken_ts;
+    }
+    mutex_unlock(&lock);
+    return res;
+}
+
+int sensor_cache_get_new(fixp_t *v, uint32_t *seq)
+{
+    int res = -EAGAIN;
+
+    _touch();
+    mutex_lock(&lock);
+    if (reads != *seq) {
+        res = _get(v);
+        if (res == 0) {
+            *seq = reads;
+        }
+    }
+    mutex_unlock(&lock);
+    return res;
+}
+
+int sensor_cache_cmd(int argc, char **argv)
+{
+    if (argc >= 2) {
+        uint32_t p = atoi(argv[1]);
+        uint32_t a = (argc >= 3) ? (uint32_t)atoi(argv[2]) : maxage;
+        if ((p == 0) || (a < p)) {
+            printf("usage: %s [<period ms> [max age ms]], the age has to be "
+                   "at least one period\n", argv[0]);
+            return 1;
+        }
+        period = p;
+        maxage = a;
+        /* reading at the new period right away */
+        _touch();
+    }
+
+    mutex_lock(&lock);
+    bool v = valid;
+    fixp_t val = value;
+    uint32_t age = ztimer_now(ZTIMER_MSEC) - taken;
+    mutex_unlock(&lock);
+
+    printf("reading every %lu ms, stale after %lu ms, %s\n",
+           (unsigned long)period, (unsigned long)maxage,
+           idle ? "idle" : "active");
+    if (read_time > period) {
+        printf("period stretched to the %lu ms of a bus read\n",
+               (unsigned long)read_time);
+    }
+    if (v) {
+        char str[FIXP_FMT_MAXLEN];
+        fixp_to_str(str, val, 2);
+        printf("latest %s, %lu ms old, bus read took %lu ms\n", str,
+               (unsigned long)age, (unsigned long)read_time);
+    }
+    printf("%lu reads, %lu errors, %lu hits, %lu stale, %lu wake-ups\n",
+           (unsigned long)reads, (unsigned long)errors, (unsigned long)hits,
+           (unsigned long)stale, (unsigned long)wakeups);
+    periodic_print_stats(&task, 1);
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_loop
+ * @{
+ *
+ * @file
+ * @brief       Store-and-forward backlog implementation
+ *
+ * @}
+ */
+
+#include "backlog.h"
+
+#define MASK    (BACKLOG_SIZE - 1)
+
+_Static_assert((BACKLOG_SIZE & MASK) == 0,
+               "BACKLOG_SIZE must be a power of two");
+
+void backlog_init(backlog_t *b)
+{
+    b->head = 0;
+    b->tail = 0;
+    b->buffered = 0;
+    b->replayed = 0;
+    b->discarded = 0;
+    b->dropped = 0;
+}
+
+void backlog_put(backlog_t *b, const telemetry_sample_t *s)
+{
+    if (backlog_level(b) >= BACKLOG_SIZE) {
+        b->tail++;
+        b->dropped++;
+    }
+    b->buf[b->head & MASK] = *s;
+    b->head++;
+    b->buffered++;
+}
+
+unsigned backlog_peek(const backlog_t *b, telemetry_batch_t *out, unsigned max)
+{
+    unsigned level = backlog_level(b);
+
+    telemetry_batch_clear(out);
+    if (max > TELEMETRY_BATCH_MAX) {
+        max = TELEMETRY_BATCH_MAX;
+    }
+    for (unsigned i = 0; (i < level) && (i < max); i++) {
+        telemetry_batch_add(out, &b->buf[(b->tail + i) & MASK]);
+    }
+    return out->numof;
+}
+
+static unsigned _remove(backlog_t *b, unsigned n)
+{
+    if (n > backlog_level(b)) {
+        n = backlog_level(b);
+    }
+    b->tail += n;
+    return n;
+}
+
+void backlog_consume(backlog_t *b, unsigned n)
+{
+    b->replayed += _remove(b, n);
+}
+
+void backlog_discard(backlog_t *b, unsigned n)
+{
+    b->discarded += _remove(b, n);
+}
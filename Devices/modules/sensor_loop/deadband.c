@@ -0,0 +1,128 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_loop
+ * @{
+ *
+ * @file
+ * @brief       Send-on-delta filter implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "deadband.h"
+
+void deadband_init(deadband_t *db)
+{
+    memset(db, 0, sizeof(*db));
+    db->heartbeat = DEADBAND_HEARTBEAT;
+}
+
+int deadband_parse(deadband_t *db, const char *opt)
+{
+    const char *sep = strchr(opt, ':');
+    fixp_t band;
+    fixp_t hyst = 0;
+    unsigned first = 0;
+    unsigned last = TELEMETRY_FIELD_NUMOF;
+
+    if (sep == NULL) {
+        return -EINVAL;
+    }
+    if ((sep - opt != 3) || (strncmp(opt, "all", 3) != 0)) {
+        for (first = 0; first < TELEMETRY_FIELD_NUMOF; first++) {
+            const char *name = telemetry_field_name(first);
+            if ((strlen(name) == (size_t)(sep - opt)) &&
+                (strncmp(opt, name, sep - opt) == 0)) {
+                break;
+            }
+        }
+        if (first == TELEMETRY_FIELD_NUMOF) {
+            return -EINVAL;
+        }
+        last = first + 1;
+    }
+
+    const char *p = sep + 1;
+    size_t n = fixp_parse(p, &band);
+    if ((n == 0) || (band < 0)) {
+        return -EINVAL;
+    }
+    p += n;
+    if (*p == ':') {
+        p++;
+        n = fixp_parse(p, &hyst);
+        if ((n == 0) || (hyst < 0)) {
+            return -EINVAL;
+        }
+        p += n;
+    }
+    if (*p != '\0') {
+        return -EINVAL;
+    }
+
+    for (unsigned f = first; f < last; f++) {
+        db->band[f] = band;
+        db->hyst[f] = hyst;
+    }
+    db->enabled = true;
+    return 0;
+}
+
+bool deadband_check(deadband_t *db, const telemetry_sample_t *s, uint32_t now)
+{
+    if (!db->enabled) {
+        db->passed++;
+        return true;
+    }
+
+    /* the first value of a field always goes out */
+    bool send = ((s->mask & ~db->sent_mask) != 0);
+
+    for (unsigned f = 0; !send && (f < TELEMETRY_FIELD_NUMOF); f++) {
+        if (!(s->mask & (1U << f))) {
+            continue;
+        }
+        fixp_t d = s->value[f] - db->sent[f];
+        if (d == 0) {
+            continue;
+        }
+        int8_t dir = (d > 0) ? 1 : -1;
+        fixp_t need = db->band[f];
+        if ((db->dir[f] != 0) && (dir != db->dir[f])) {
+            need += db->hyst[f];
+        }
+        send = (((d > 0) ? d : -d) >= need);
+    }
+
+    if (!send && (db->heartbeat > 0) && (now - db->sent_at >= db->heartbeat)) {
+        send = true;
+        db->heartbeats++;
+    }
+    if (!send) {
+        db->suppressed++;
+        return false;
+    }
+
+    for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+        if (!(s->mask & (1U << f))) {
+            continue;
+        }
+        if (s->value[f] != db->sent[f]) {
+            db->dir[f] = (s->value[f] > db->sent[f]) ? 1 : -1;
+        }
+        db->sent[f] = s->value[f];
+    }
+    db->sent_mask |= s->mask;
+    db->sent_at = now;
+    db->passed++;
+    return true;
+}
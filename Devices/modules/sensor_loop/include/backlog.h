@@ -0,0 +1,98 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_loop
+ * @{
+ *
+ * @file
+ * @brief       Store-and-forward backlog of samples that could not be sent
+ *
+ * The publisher keeps samples here while the gateway is unreachable and
+ * replays them once it is back. Only the publisher thread touches it. When
+ * the backlog is full the oldest sample makes room for the newest one.
+ *
+ * @}
+ */
+
+#ifndef BACKLOG_H
+#define BACKLOG_H
+
+#include <stdint.h>
+
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Number of samples kept while disconnected, must be a power of two
+ */
+#ifndef BACKLOG_SIZE
+#define BACKLOG_SIZE                (64U)
+#endif
+
+/**
+ * @brief   Backlog of samples
+ */
+typedef struct {
+    telemetry_sample_t buf[BACKLOG_SIZE];   /**< storage */
+    unsigned head;                          /**< put so far */
+    unsigned tail;                          /**< consumed or dropped so far */
+    uint32_t buffered;                      /**< samples put */
+    uint32_t replayed;                      /**< samples consumed */
+    uint32_t discarded;                     /**< samples that could not be
+                                                 sent, see backlog_discard() */
+    uint32_t dropped;                       /**< samples overwritten, full */
+} backlog_t;
+
+/**
+ * @brief   Empty the backlog and reset its counters
+ */
+void backlog_init(backlog_t *b);
+
+/**
+ * @brief   Keep a sample, drops the oldest one if the backlog is full
+ */
+void backlog_put(backlog_t *b, const telemetry_sample_t *s);
+
+/**
+ * @brief   Copy the oldest samples into a batch without removing them
+ *
+ * @param[in]  b    backlog
+ * @param[out] out  batch to fill, previous content is cleared
+ * @param[in]  max  most samples to copy, at most TELEMETRY_BATCH_MAX
+ *
+ * @return  number of samples copied
+ */
+unsigned backlog_peek(const backlog_t *b, telemetry_batch_t *out, unsigned max);
+
+/**
+ * @brief   Remove the @p n oldest samples once they are sent
+ */
+void backlog_consume(backlog_t *b, unsigned n);
+
+/**
+ * @brief   Remove the @p n oldest samples because they can never be sent,
+ *          e.g. they do not fit into a message
+ */
+void backlog_discard(backlog_t *b, unsigned n);
+
+/**
+ * @brief   Number of samples in the backlog
+ */
+static inline unsigned backlog_level(const backlog_t *b)
+{
+    return b->head - b->tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BACKLOG_H */
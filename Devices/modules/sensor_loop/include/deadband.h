@@ -0,0 +1,97 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_loop
+ * @{
+ *
+ * @file
+ * @brief       Send-on-delta filter of the sampled values
+ *
+ * A sample is only sent if one of its fields moved away from the value sent
+ * last by at least the band of that field. A field that turns around needs
+ * the band plus its hysteresis, so a value flapping between two readings
+ * does not produce a message every period. Whatever happens, a sample is
+ * sent after @ref deadband_t::heartbeat seconds without any, so the broker
+ * can tell a quiet node from a dead one.
+ *
+ * Whole samples are kept or dropped, so every format still sees samples
+ * with all their fields. Only the sampler thread calls deadband_check().
+ *
+ * @}
+ */
+
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixp.h"
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Default seconds after which a sample is sent anyway
+ */
+#ifndef DEADBAND_HEARTBEAT
+#define DEADBAND_HEARTBEAT          (300U)
+#endif
+
+/**
+ * @brief   Filter settings, the values sent last and the counters
+ */
+typedef struct {
+    bool enabled;                           /**< false lets everything pass */
+    fixp_t band[TELEMETRY_FIELD_NUMOF];     /**< change needed, 0 = any */
+    fixp_t hyst[TELEMETRY_FIELD_NUMOF];     /**< extra change to turn around */
+    uint32_t heartbeat;                     /**< seconds, 0 = never */
+    fixp_t sent[TELEMETRY_FIELD_NUMOF];     /**< values sent last */
+    int8_t dir[TELEMETRY_FIELD_NUMOF];      /**< direction of the last change */
+    uint8_t sent_mask;                      /**< fields sent so far */
+    uint32_t sent_at;                       /**< seconds, last sample sent */
+    uint32_t passed;                        /**< samples sent */
+    uint32_t suppressed;                    /**< samples dropped */
+    uint32_t heartbeats;                    /**< passed only for the heartbeat */
+} deadband_t;
+
+/**
+ * @brief   Disable the filter and reset its state and counters
+ */
+void deadband_init(deadband_t *db);
+
+/**
+ * @brief   Set the band of one field, or of all, and enable the filter
+ *
+ * @param[in] db    filter
+ * @param[in] opt   `<field>:<band>[:<hysteresis>]` in the unit of the field,
+ *                  e.g. `temperature:0.5:0.2`, `all` sets every field
+ *
+ * @return  0 on success
+ * @return  -EINVAL if @p opt can not be parsed
+ */
+int deadband_parse(deadband_t *db, const char *opt);
+
+/**
+ * @brief   Decide whether a sample is sent
+ *
+ * @param[in] db    filter
+ * @param[in] s     new sample
+ * @param[in] now   seconds on any clock that does not jump
+ *
+ * @return  true if @p s has to be sent, it is then the new reference
+ */
+bool deadband_check(deadband_t *db, const telemetry_sample_t *s, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEADBAND_H */
@@ -0,0 +1,83 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_loop
+ * @{
+ *
+ * @file
+ * @brief       Lock-free single producer, single consumer ring of samples
+ *
+ * Exactly one thread may push and exactly one thread may pop. Head and tail
+ * are free running counters, each written by one side only, so neither side
+ * ever blocks the other. A push into a full ring drops the new sample.
+ *
+ * @}
+ */
+
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Number of samples in the ring, must be a power of two
+ */
+#ifndef SAMPLE_RING_SIZE
+#define SAMPLE_RING_SIZE            (16U)
+#endif
+
+/**
+ * @brief   Sample ring
+ */
+typedef struct {
+    telemetry_sample_t buf[SAMPLE_RING_SIZE];   /**< storage */
+    atomic_uint head;                           /**< pushed so far */
+    atomic_uint tail;                           /**< popped so far */
+    unsigned high_water;                        /**< highest fill level */
+    uint32_t drops;                             /**< samples lost, ring full */
+} sample_ring_t;
+
+/**
+ * @brief   Empty the ring and reset its counters
+ */
+void sample_ring_init(sample_ring_t *r);
+
+/**
+ * @brief   Add a sample, producer side
+ *
+ * @return  true on success
+ * @return  false if the ring is full, the sample is counted as dropped
+ */
+bool sample_ring_push(sample_ring_t *r, const telemetry_sample_t *s);
+
+/**
+ * @brief   Take the oldest sample, consumer side
+ *
+ * @return  true on success
+ * @return  false if the ring is empty
+ */
+bool sample_ring_pop(sample_ring_t *r, telemetry_sample_t *s);
+
+/**
+ * @brief   Number of samples in the ring
+ */
+unsigned sample_ring_level(sample_ring_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_RING_H */
@@ -0,0 +1,215 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sensor_loop Periodic sampling and publishing
+ * @{
+ *
+ * @file
+ * @brief       The loop shell command of the MQTT-SN clients
+ *
+ * Sampling and publishing run in two threads of their own, so the shell
+ * stays usable and a slow PUBLISH never delays the next sample:
+ *
+ * - the sampler wakes up every period, asks the application for a sample
+ *   and pushes it into a @ref sample_ring_t
+ * - the publisher drains the ring into a batch and sends it to the gateway
+ *   once the batch is full or its oldest sample is too old
+ *
+ * Shell usage:
+ *
+ *     loop start <topic> [QoS level] [fmt=json|bin|delta] [period=S] [batch=N]
+ *                [maxage=S] [window=W] [db=<field|all>:<band>[:<hyst>]]...
+ *                [heartbeat=S] [sleep] [frame=auto|off|N]
+ *     loop stop
+ *     loop status
+ *
+ * `loop <topic> [data] [QoS level] [options]` is still accepted and starts
+ * the loop like before.
+ *
+ * window=W publishes with QoS 1 through the @ref pubwin module with up to W
+ * messages waiting for their PUBACK, instead of one emcute_pub() round trip
+ * per message. It opens a second session to the gateway given to
+ * sensor_loop_set_gateway() and needs a predefined topic. The samples of a
+ * message stay in RAM until its PUBACK arrives, if it never does they go to
+ * the backlog like those of a failed emcute_pub().
+ *
+ * QoS level -1 sends every message through the @ref qosm1 module, without
+ * a connection to the gateway and without an answer. A lost message is
+ * counted as failed but neither kept nor replayed. The topic has to be
+ * predefined or a short topic name. These messages are encoded straight into
+ * the transmit buffer of qosm1 with qosm1_pub_begin().
+ *
+ * sleep hands the client ID over from emcute to a @ref sleepcl session that
+ * turns the radio off between messages. After every message the node tells
+ * the gateway it sleeps for the time until the next batch plus
+ * SENSOR_LOOP_SLEEP_MARGIN seconds, and wakes up with CONNECT for the next
+ * one. If nothing was sent for that long, a PINGREQ fetches the messages the
+ * gateway kept meanwhile. The config topic of @ref devcfg is subscribed in
+ * the sleeping session. `loop status` shows the radio-on time per hour, and
+ * `loop stop` closes the session, `con` connects emcute again.
+ *
+ * Messages are kept small enough for a single link layer frame, see
+ * @ref framebudget: a batch that does not fit is sent in several messages
+ * of as many samples as fit, and a sample that does not fit on its own a
+ * few fields at a time. frame=N sets the payload budget by hand, for
+ * trying it on native, frame=off lets 6LoWPAN fragment like before but
+ * still counts the messages against the budget. `loop status` shows the
+ * budget and how many messages were fragmented.
+ *
+ * When a publish fails the samples are kept in a @ref backlog_t and the
+ * publisher reconnects to the same gateway in the background, waiting
+ * SENSOR_LOOP_BACKOFF_MIN seconds at first and twice as long after every
+ * failed attempt. Once connected it replays the backlog in messages as full
+ * as the payload allows, one every SENSOR_LOOP_REPLAY_INTERVAL ms. A
+ * stopped loop keeps the backlog and goes on with it after the next start.
+ * `loop stop` returns once the publisher is done, and a `loop start` that
+ * fails leaves the parameters of the last run in place.
+ *
+ * db= options turn on the send-on-delta filter of deadband.h: a sample is
+ * only queued if a field moved by at least its band since the last sample
+ * sent, or heartbeat seconds went by. Fields without a db= option count any
+ * change. `loop status` shows how many samples the filter suppressed.
+ *
+ * The period, batch size and QoS level of a running loop can be changed
+ * with sensor_loop_tune(), see the @ref devcfg module.
+ *
+ * @}
+ */
+
+#ifndef SENSOR_LOOP_H
+#define SENSOR_LOOP_H
+
+#include "net/sock/udp.h"
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Seconds between two samples, unless loop start says otherwise
+ */
+#ifndef SENSOR_LOOP_PERIOD
+#define SENSOR_LOOP_PERIOD          (5U)
+#endif
+
+/**
+ * @brief   Largest payload of one publish, has to stay below EMCUTE_BUFSIZE
+ */
+#ifndef SENSOR_LOOP_PAYLOAD_MAXLEN
+#define SENSOR_LOOP_PAYLOAD_MAXLEN  (480U)
+#endif
+
+/**
+ * @brief   Header bytes every message pays for, used for the bytes on air
+ *
+ * The default is the native board: Ethernet, IPv6, UDP and the MQTT-SN
+ * PUBLISH header.
+ */
+#ifndef SENSOR_LOOP_PUB_OVERHEAD
+#define SENSOR_LOOP_PUB_OVERHEAD    (14U + 40U + 8U + 7U)
+#endif
+
+/**
+ * @brief   Seconds before the first reconnect attempt
+ */
+#ifndef SENSOR_LOOP_BACKOFF_MIN
+#define SENSOR_LOOP_BACKOFF_MIN     (1U)
+#endif
+
+/**
+ * @brief   Longest wait between two reconnect attempts, in seconds
+ */
+#ifndef SENSOR_LOOP_BACKOFF_MAX
+#define SENSOR_LOOP_BACKOFF_MAX     (64U)
+#endif
+
+/**
+ * @brief   Milliseconds between two messages replaying the backlog
+ */
+#ifndef SENSOR_LOOP_REPLAY_INTERVAL
+#define SENSOR_LOOP_REPLAY_INTERVAL (500U)
+#endif
+
+/**
+ * @brief   Seconds of sleep duration announced on top of the time until the
+ *          next message, for the jitter of the sampler
+ */
+#ifndef SENSOR_LOOP_SLEEP_MARGIN
+#define SENSOR_LOOP_SLEEP_MARGIN    (5U)
+#endif
+
+/**
+ * @brief   Stack size of the sampler and the publisher thread
+ */
+#ifndef SENSOR_LOOP_STACKSIZE
+#define SENSOR_LOOP_STACKSIZE       (THREAD_STACKSIZE_DEFAULT)
+#endif
+
+/**
+ * @brief   Takes one sample, called from the sampler thread
+ *
+ * @param[out] s    sample to fill, including device number and timestamp
+ */
+typedef void (*sensor_loop_sample_cb_t)(telemetry_sample_t *s);
+
+/**
+ * @brief   Start the sampler and publisher threads, the loop stays stopped
+ *
+ * @param[in] cb    sample source of the application
+ */
+void sensor_loop_init(sensor_loop_sample_cb_t cb);
+
+/**
+ * @brief   Tell the loop which gateway the client is connected to
+ *
+ * @param[in] gw        gateway given to emcute_con(), NULL after a disconnect
+ * @param[in] client_id client ID of the emcute session
+ */
+void sensor_loop_set_gateway(const sock_udp_ep_t *gw, const char *client_id);
+
+/**
+ * @brief   Loop parameters that can change while it runs
+ */
+typedef struct {
+    unsigned period;    /**< seconds between two samples, 0 keeps the current */
+    unsigned batch;     /**< samples per message, 0 keeps the current */
+    int qos;            /**< QoS level 0, 1 or 2, -1 keeps the current and
+                             is returned for a loop sending with QoS -1 */
+} sensor_loop_tune_t;
+
+/**
+ * @brief   Change the parameters of the loop without stopping it
+ *
+ * Can be called from any thread. It only waits for a short lock, the
+ * values are handed to the publisher thread, which applies them the next
+ * time it wakes up. The new period starts after the sample that is already
+ * scheduled, a new batch size with the next sample. `loop start` sets all
+ * of them again and drops values not applied yet.
+ *
+ * @param[in,out] t     new values, holds the values the loop switches to on
+ *                      return
+ *
+ * @return  0 on success
+ * @return  -EINVAL if a value is out of range, @p t asks a loop started
+ *          with QoS -1 for another QoS level or a sleeping loop for QoS 2,
+ *          nothing was changed then
+ * @return  -EAGAIN if the loop is not running, nothing was changed then
+ */
+int sensor_loop_tune(sensor_loop_tune_t *t);
+
+/**
+ * @brief   The loop shell command
+ */
+int sensor_loop_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_LOOP_H */
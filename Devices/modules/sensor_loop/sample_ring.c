@@ -0,0 +1,68 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_loop
+ * @{
+ *
+ * @file
+ * @brief       Sample ring implementation
+ *
+ * @}
+ */
+
+#include "sample_ring.h"
+
+#define MASK    (SAMPLE_RING_SIZE - 1)
+
+_Static_assert((SAMPLE_RING_SIZE & MASK) == 0,
+               "SAMPLE_RING_SIZE must be a power of two");
+
+void sample_ring_init(sample_ring_t *r)
+{
+    atomic_store(&r->head, 0);
+    atomic_store(&r->tail, 0);
+    r->high_water = 0;
+    r->drops = 0;
+}
+
+bool sample_ring_push(sample_ring_t *r, const telemetry_sample_t *s)
+{
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned level = head - atomic_load_explicit(&r->tail, memory_order_acquire);
+
+    if (level >= SAMPLE_RING_SIZE) {
+        r->drops++;
+        return false;
+    }
+    r->buf[head & MASK] = *s;
+    /* publish the sample only after it is completely written */
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+
+    if (level + 1 > r->high_water) {
+        r->high_water = level + 1;
+    }
+    return true;
+}
+
+bool sample_ring_pop(sample_ring_t *r, telemetry_sample_t *s)
+{
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    if (tail == atomic_load_explicit(&r->head, memory_order_acquire)) {
+        return false;
+    }
+    *s = r->buf[tail & MASK];
+    /* hand the slot back only after it is read */
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+unsigned sample_ring_level(sample_ring_t *r)
+{
+    return atomic_load(&r->head) - atomic_load(&r->tail);
+}
@@ -0,0 +1,1316 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sensor_loop
+ * @{
+ *
+ * @file
+ * @brief       Sampler and publisher threads of the loop command
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "msg.h"
+#include "mutex.h"
+#include "thread.h"
+#include "xtimer.h"
+#include "net/emcute.h"
+
+#include "backlog.h"
+#include "deadband.h"
+#include "framebudget.h"
+#include "periodic.h"
+#include "pubstats.h"
+#include "pubwin.h"
+#include "qosm1.h"
+#include "sample_ring.h"
+#include "sensor_loop.h"
+#include "sleepcl.h"
+#include "topic_cache.h"
+#ifdef MODULE_DEVCFG
+#include "devcfg.h"
+#endif
+
+#define SAMPLER_PRIO        (THREAD_PRIORITY_MAIN - 2)
+#define PUBLISHER_PRIO      (THREAD_PRIORITY_MAIN - 1)
+
+#define MSG_SAMPLE          (0x5301)    /* new sample in the ring */
+#define MSG_STOP            (0x5302)    /* send what is left and stop, the
+                                         * publisher replies when done */
+#define MSG_GATEWAY         (0x5303)    /* the shell changed the gateway */
+#define MSG_TUNE            (0x5304)    /* sensor_loop_tune() left values */
+
+#define NO_DEADLINE         (UINT64_MAX)
+
+#define FRAME_AUTO          (0)         /* budget of the gateway interface */
+#define FRAME_OFF           (-1)        /* only count, let 6LoWPAN fragment */
+
+/* payload formats */
+typedef enum {
+    FMT_JSON,           /* Thingsboard JSON */
+    FMT_BIN,            /* one binary telemetry record per sample */
+    FMT_DELTA,          /* one delta record per batch */
+} fmt_t;
+
+/* options of the loop command, given after the topic */
+typedef struct {
+    char topic[TOPIC_CACHE_NAME_MAXLEN];
+    unsigned period;    /* seconds between two samples */
+    unsigned flags;     /* QoS level */
+    fmt_t fmt;          /* payload format */
+    unsigned batch;     /* samples per message */
+    unsigned maxage;    /* seconds a sample may wait for its batch, 0 = forever */
+    unsigned window;    /* QoS 1 messages in flight, 0 = use emcute_pub() */
+    bool sleep;         /* sleeping session, radio off between messages */
+    int frame;          /* payload bytes per frame, FRAME_AUTO or FRAME_OFF */
+} params_t;
+
+/* what the loop sent so far, to compare the modes */
+typedef struct {
+    uint64_t start;     /* usec */
+    uint32_t sampled;
+    uint32_t samples;   /* samples sent */
+    uint32_t messages;
+    uint32_t bytes;     /* payload bytes */
+    uint32_t failed;    /* messages that could not be sent */
+    uint32_t unsendable; /* samples in messages that can never be sent */
+} stats_t;
+
+static char sampler_stack[SENSOR_LOOP_STACKSIZE];
+static char publisher_stack[SENSOR_LOOP_STACKSIZE];
+static kernel_pid_t publisher_pid = KERNEL_PID_UNDEF;
+static msg_t publisher_queue[4];
+
+static sensor_loop_sample_cb_t sample_cb;
+static volatile bool running;
+/* locked while the loop is stopped, the sampler waits on it */
+static mutex_t gate = MUTEX_INIT_LOCKED;
+
+static params_t params;
+static stats_t stats;
+/* values of sensor_loop_tune() the publisher has not applied yet, 0 and -1
+ * keep the current ones */
+static mutex_t tune_lock = MUTEX_INIT;
+static sensor_loop_tune_t tune = { .qos = -1 };
+
+/* gateway of the emcute session, reconnects and the windowed publisher
+ * go to it, written by the shell */
+static mutex_t gw_lock = MUTEX_INIT;
+static sock_udp_ep_t gateway;
+static volatile bool have_gateway;
+static char win_client_id[24];
+static char sleep_client_id[24];
+static sample_ring_t ring;
+static periodic_task_t sample_task;
+/* send-on-delta filter, set up by the shell before the sampler runs */
+static deadband_t filter;
+
+/* publisher state */
+static telemetry_batch_t batch;
+static uint64_t oldest;
+static char payload[SENSOR_LOOP_PAYLOAD_MAXLEN];
+/* payload that fits into one frame, messages are counted against it even
+ * with frame=off */
+static framebudget_t budget;
+static telemetry_batch_t part;
+
+/* store-and-forward state, publisher only */
+static backlog_t backlog;
+static telemetry_batch_t replay;
+static bool online = true;
+static uint32_t backoff;        /* seconds until the next reconnect */
+static uint64_t retry_at;       /* usec */
+static uint64_t replay_at;      /* usec */
+/* set by the pubwin thread when a windowed message got no PUBACK */
+static volatile bool link_lost;
+/* samples of the windowed messages until their PUBACK, in send order: the
+ * publisher fills an entry before pubwin_pub() and takes it back with
+ * _collect(), the pubwin thread only sets the result and the round trip
+ * time. One more entry than the window, pubwin_pub() may complete one
+ * before it returns. */
+#define INFLIGHT_PENDING    (1)
+#define INFLIGHT_NUMOF      (PUBWIN_SIZE_MAX + 1)
+typedef struct {
+    telemetry_batch_t batch;    /* samples of the message, as sent */
+    unsigned samples;           /* samples it completes */
+    size_t len;                 /* payload length */
+    uint32_t rtt;               /* usec, set by _on_done() */
+    volatile int res;           /* INFLIGHT_PENDING until _on_done() */
+} inflight_t;
+static inflight_t inflight[INFLIGHT_NUMOF];
+static unsigned inflight_head;  /* entries filled */
+static unsigned inflight_tail;  /* entries collected */
+/* sleeping session, publisher only */
+static uint64_t poll_at;        /* usec */
+#ifdef MODULE_DEVCFG
+static char cfg_topic[TOPIC_CACHE_NAME_MAXLEN];
+#endif
+
+static const char *const fmt_names[] = {
+    [FMT_JSON]  = "json",
+    [FMT_BIN]   = "bin",
+    [FMT_DELTA] = "delta",
+};
+
+static unsigned _get_qos(const char *str)
+{
+    switch (atoi(str)) {
+        case -1:    return QOSM1_QOS;
+        case 1:     return EMCUTE_QOS_1;
+        case 2:     return EMCUTE_QOS_2;
+        default:    return EMCUTE_QOS_0;
+    }
+}
+
+/* the whole batch has to fit into a single publish */
+static unsigned _batch_max(fmt_t fmt)
+{
+    static const unsigned rec_max[] = {
+        [FMT_JSON]  = TELEMETRY_JSON_MAXLEN,
+        [FMT_BIN]   = TELEMETRY_BIN_MAXLEN,
+        [FMT_DELTA] = TELEMETRY_DELTA_SAMPLE_MAXLEN,
+    };
+    unsigned batch_max = (SENSOR_LOOP_PAYLOAD_MAXLEN - TELEMETRY_DELTA_HDR_LEN) /
+                         rec_max[fmt];
+
+    return (batch_max > TELEMETRY_BATCH_MAX) ? TELEMETRY_BATCH_MAX : batch_max;
+}
+
+static int _parse(int argc, char **argv, params_t *p, deadband_t *db)
+{
+    deadband_init(db);
+    memset(p, 0, sizeof(*p));
+    p->period = SENSOR_LOOP_PERIOD;
+    p->batch = 1;
+
+    if (strlen(argv[0]) >= sizeof(p->topic)) {
+        puts("error: topic name exceeds maximum possible size");
+        return 1;
+    }
+    strcpy(p->topic, argv[0]);
+
+    for (int i = 1; i < argc; i++) {
+        unsigned f;
+        for (f = 0; f < (sizeof(fmt_names) / sizeof(fmt_names[0])); f++) {
+            if ((strncmp(argv[i], "fmt=", 4) == 0) &&
+                (strcmp(argv[i] + 4, fmt_names[f]) == 0)) {
+                p->fmt = f;
+                break;
+            }
+        }
+        if (f < (sizeof(fmt_names) / sizeof(fmt_names[0]))) {
+            continue;
+        }
+        if (strncmp(argv[i], "batch=", 6) == 0) {
+            p->batch = atoi(argv[i] + 6);
+        }
+        else if (strncmp(argv[i], "period=", 7) == 0) {
+            p->period = atoi(argv[i] + 7);
+            if (p->period < 1) {
+                puts("error: period has to be at least 1 second");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "db=", 3) == 0) {
+            if (deadband_parse(db, argv[i] + 3) != 0) {
+                printf("error: '%s' is not db=<field|all>:<band>[:<hysteresis>]\n",
+                       argv[i]);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "heartbeat=", 10) == 0) {
+            db->heartbeat = atoi(argv[i] + 10);
+        }
+        else if (strncmp(argv[i], "maxage=", 7) == 0) {
+            p->maxage = atoi(argv[i] + 7);
+        }
+        else if (strncmp(argv[i], "frame=", 6) == 0) {
+            if (strcmp(argv[i] + 6, "auto") == 0) {
+                p->frame = FRAME_AUTO;
+            }
+            else if (strcmp(argv[i] + 6, "off") == 0) {
+                p->frame = FRAME_OFF;
+            }
+            else if ((p->frame = atoi(argv[i] + 6)) < 1) {
+                puts("error: frame has to be auto, off or a number of bytes");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "sleep") == 0) {
+            p->sleep = true;
+        }
+        else if (strncmp(argv[i], "window=", 7) == 0) {
+            p->window = atoi(argv[i] + 7);
+            if ((p->window < 1) || (p->window > PUBWIN_SIZE_MAX)) {
+                printf("error: window has to be between 1 and %u\n",
+                       PUBWIN_SIZE_MAX);
+                return 1;
+            }
+        }
+        else if (strchr(argv[i], '=') == NULL) {
+            p->flags |= _get_qos(argv[i]);
+        }
+        else {
+            printf("error: unknown option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    unsigned batch_max = _batch_max(p->fmt);
+    if ((p->batch < 1) || (p->batch > batch_max)) {
+        printf("error: batch has to be between 1 and %u\n", batch_max);
+        return 1;
+    }
+
+    /* only QoS 1 gets acknowledged, that is what the window is for */
+    if (p->window > 0) {
+        p->flags = (p->flags & ~EMCUTE_QOS_MASK) | EMCUTE_QOS_1;
+    }
+
+    uint16_t id;
+    unsigned tit;
+    if (((p->flags & EMCUTE_QOS_MASK) == QOSM1_QOS) &&
+        (qosm1_topic(p->topic, &id, &tit) != EMCUTE_OK)) {
+        puts("error: QoS -1 needs a predefined topic or a short topic name");
+        return 1;
+    }
+
+    if (p->sleep) {
+        unsigned qos = p->flags & EMCUTE_QOS_MASK;
+        if ((p->window > 0) || ((qos != EMCUTE_QOS_0) && (qos != EMCUTE_QOS_1))) {
+            puts("error: sleep works with QoS 0 or 1 and without a window");
+            return 1;
+        }
+        /* the sleeping session never registers topics */
+        if (qosm1_topic(p->topic, &id, &tit) != EMCUTE_OK) {
+            puts("error: sleep needs a predefined topic or a short topic name");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* called by the pubwin thread, in the order the messages were sent; stats
+ * and budget belong to the publisher, _collect() does the accounting */
+static void _on_done(int res, uint32_t rtt, void *arg)
+{
+    inflight_t *m = arg;
+
+    if (res != EMCUTE_OK) {
+        link_lost = true;
+    }
+    m->rtt = rtt;
+    /* last, _collect() may take the entry from here on */
+    m->res = res;
+}
+
+static void _keep(const telemetry_batch_t *b, unsigned from);
+
+/* publisher only: counts the completed windowed messages, the samples of
+ * failed ones go to the backlog */
+static void _collect(void)
+{
+    while (inflight_tail != inflight_head) {
+        inflight_t *m = &inflight[inflight_tail % INFLIGHT_NUMOF];
+        int res = m->res;
+        if (res == INFLIGHT_PENDING) {
+            break;
+        }
+        pubstats_record(PUBSTATS_PUBLISH, params.topic, m->len, m->rtt, res);
+        framebudget_record(&budget, m->len, res);
+        if (res == EMCUTE_OK) {
+            stats.samples += m->samples;
+            stats.messages++;
+        }
+        else {
+            printf("error: windowed publish of %u samples failed (%i) after "
+                   "%lu us, keeping them\n", m->batch.numof, res,
+                   (unsigned long)m->rtt);
+            stats.failed++;
+            _keep(&m->batch, 0);
+        }
+        inflight_tail++;
+    }
+}
+
+static int _publish_window(const telemetry_batch_t *b, unsigned samples,
+                           emcute_topic_t *t, unsigned flags, int len)
+{
+    if ((flags & EMCUTE_TIT_MASK) == EMCUTE_TIT_NORMAL) {
+        puts("error: the windowed publish needs a predefined topic");
+        return -EINVAL;
+    }
+    if (!pubwin_is_connected()) {
+        if (!have_gateway) {
+            puts("error: not connected to any gateway");
+            return -ENOTCONN;
+        }
+        mutex_lock(&gw_lock);
+        sock_udp_ep_t gw = gateway;
+        mutex_unlock(&gw_lock);
+        if (pubwin_connect(&gw, win_client_id, params.window,
+                           _on_done) != EMCUTE_OK) {
+            puts("error: unable to open the windowed session");
+            return -ENOTCONN;
+        }
+    }
+
+    /* at most a window of entries is still pending after this */
+    _collect();
+    inflight_t *m = &inflight[inflight_head % INFLIGHT_NUMOF];
+    m->batch = *b;
+    m->samples = samples;
+    m->len = len;
+    m->res = INFLIGHT_PENDING;
+
+    /* only blocks while the window is full */
+    if (pubwin_pub(t->id, flags, payload, len, m) != EMCUTE_OK) {
+        printf("error: unable to publish data to topic '%s [%i]'\n",
+               t->name, (int)t->id);
+        return -ENOTCONN;
+    }
+    inflight_head++;
+
+    printf("Queued %i bytes to topic '%s [%i]', %u in flight\n",
+           len, t->name, t->id, pubwin_inflight());
+    stats.bytes += len;
+    return 0;
+}
+
+/* no session behind it, so nothing to reconnect and nothing to replay; the
+ * payload is already in the transmit buffer, see _reserve() */
+static int _publish_qosm1(unsigned samples, int len)
+{
+    uint32_t start = xtimer_now_usec();
+    int res = qosm1_pub_commit(params.topic, len);
+    pubstats_record(PUBSTATS_PUBLISH, params.topic, len,
+                    xtimer_now_usec() - start, res);
+    if (res != EMCUTE_OK) {
+        printf("error: unable to send QoS -1 message to '%s' (%i), "
+               "see the qosm1 command\n", params.topic, res);
+        return -EIO;
+    }
+
+    printf("Sent %i bytes to topic '%s' with QoS -1\n", len, params.topic);
+    stats.samples += samples;
+    stats.messages++;
+    stats.bytes += len;
+    return 0;
+}
+
+/* wakes the sleeping session if needed, _doze() puts it back to sleep */
+static int _publish_sleep(unsigned samples, int len)
+{
+    uint16_t id;
+    unsigned tit;
+
+    qosm1_topic(params.topic, &id, &tit);
+    uint32_t start = xtimer_now_usec();
+    int res = sleepcl_wake();
+    if (res != EMCUTE_OK) {
+        printf("warning: wake up incomplete (%i)\n", res);
+    }
+    if (sleepcl_state() == SLEEPCL_ACTIVE) {
+        res = sleepcl_pub(id, (params.flags & EMCUTE_QOS_MASK) | tit, payload,
+                          len);
+    }
+    pubstats_record(PUBSTATS_PUBLISH, params.topic, len,
+                    xtimer_now_usec() - start, res);
+    if (res != EMCUTE_OK) {
+        printf("error: unable to publish data to topic '%s [%i]'\n",
+               params.topic, (int)id);
+        return -ENOTCONN;
+    }
+
+    printf("Published %i bytes to topic '%s [%i]' while awake\n", len,
+           params.topic, (int)id);
+    stats.samples += samples;
+    stats.messages++;
+    stats.bytes += len;
+    return 0;
+}
+
+static int _encode_to(char *out, size_t len, const telemetry_batch_t *b)
+{
+    switch (params.fmt) {
+        case FMT_BIN:
+            return telemetry_batch_bin_encode((uint8_t *)out, len, b);
+        case FMT_DELTA:
+            return telemetry_batch_delta_encode((uint8_t *)out, len, b);
+        default:
+            return telemetry_batch_json_encode(out, len, b);
+    }
+}
+
+/* payload limit the messages are split to, 0 for none */
+static unsigned _limit(void)
+{
+    return (params.frame == FRAME_OFF) ? 0 : budget.payload;
+}
+
+static bool _fits(int len)
+{
+    return (len >= 0) && ((_limit() == 0) || ((unsigned)len <= _limit()));
+}
+
+/* trial encoding, to find out what fits */
+static int _encode(const telemetry_batch_t *b)
+{
+    return _encode_to(payload, sizeof(payload), b);
+}
+
+/* QoS -1 messages are encoded straight into the transmit buffer of qosm1,
+ * emcute and pubwin copy the payload anyway */
+static char *_reserve(unsigned flags, size_t *room)
+{
+    if ((flags & EMCUTE_QOS_MASK) == QOSM1_QOS) {
+        char *out = qosm1_pub_begin(room);
+        /* the same limit for every mode */
+        if (*room > sizeof(payload)) {
+            *room = sizeof(payload);
+        }
+        return out;
+    }
+    *room = sizeof(payload);
+    return payload;
+}
+
+static void _release(unsigned flags)
+{
+    if ((flags & EMCUTE_QOS_MASK) == QOSM1_QOS) {
+        qosm1_pub_abort();
+    }
+}
+
+/* encodes and sends one message, counting @p samples once it went out;
+ * returns -EMSGSIZE without sending if @p check is set and the message
+ * does not fit into one frame */
+static int _send(const telemetry_batch_t *b, unsigned samples, bool check)
+{
+    emcute_topic_t t;
+    unsigned flags = params.flags;
+    size_t room;
+    int res;
+
+    /* the flags of this message, sensor_loop_tune() may change params */
+    char *out = _reserve(flags, &room);
+    uint32_t enc_start = xtimer_now_usec();
+    int len = _encode_to(out, room, b);
+    uint32_t enc_time = xtimer_now_usec() - enc_start;
+    if ((len < 0) || (check && !_fits(len))) {
+        _release(flags);
+        /* with a budget it can still go out in parts */
+        if (check && (_limit() > 0)) {
+            return -EMSGSIZE;
+        }
+        stats.unsendable += samples;
+        return -EOVERFLOW;
+    }
+
+    if (params.fmt == FMT_JSON) {
+        printf("pub with topic: %s and name %s and flags 0x%02x\n",
+               params.topic, out, (int)flags);
+    }
+    else {
+        /* compare against the same samples as version 1 records */
+        unsigned raw = 0;
+        for (unsigned i = 0; i < b->numof; i++) {
+            raw += TELEMETRY_BIN_HDR_LEN + 2 * __builtin_popcount(b->sample[i].mask);
+        }
+        printf("pub with topic: %s and %u samples in %i bytes (%u%% of the "
+               "records, encoded in %lu us) and flags 0x%02x\n",
+               params.topic, b->numof, len, (unsigned)((len * 100) / raw),
+               (unsigned long)enc_time, (int)flags);
+    }
+
+    if ((flags & EMCUTE_QOS_MASK) == QOSM1_QOS) {
+        res = _publish_qosm1(samples, len);
+        framebudget_record(&budget, len, res);
+        return res;
+    }
+    if (params.sleep) {
+        res = _publish_sleep(samples, len);
+        framebudget_record(&budget, len, res);
+        return res;
+    }
+
+    /* step 1: get topic id, only registered once per connection */
+    if (topic_cache_get(&t, &flags, params.topic) != EMCUTE_OK) {
+        puts("error: unable to obtain topic ID");
+        return -ENOTCONN;
+    }
+
+    /* step 2: publish data, _collect() counts windowed messages */
+    if (params.window > 0) {
+        return _publish_window(b, samples, &t, flags, len);
+    }
+    uint32_t pub_start = xtimer_now_usec();
+    res = emcute_pub(&t, payload, len, flags);
+    pubstats_record(PUBSTATS_PUBLISH, params.topic, len,
+                    xtimer_now_usec() - pub_start, res);
+    framebudget_record(&budget, len, res);
+    if (res != EMCUTE_OK) {
+        printf("error: unable to publish data to topic '%s [%i]'\n",
+                t.name, (int)t.id);
+        return -ENOTCONN;
+    }
+
+    printf("Published %i bytes to topic '%s [%i]'\n", len, t.name, t.id);
+
+    stats.samples += samples;
+    stats.messages++;
+    stats.bytes += len;
+    return 0;
+}
+
+/* a sample too big for one frame goes out a few fields at a time, every
+ * part with the timestamp of the sample, the last one counts it */
+static int _publish_fields(const telemetry_sample_t *s)
+{
+    uint8_t left = s->mask;
+    int res = 0;
+
+    part.sample[0] = *s;
+    part.numof = 1;
+    while (left != 0) {
+        uint8_t mask = 0;
+        for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+            if (!(left & (1U << f))) {
+                continue;
+            }
+            part.sample[0].mask = mask | (1U << f);
+            /* a single field too big for a frame goes out fragmented */
+            if ((mask != 0) && !_fits(_encode(&part))) {
+                break;
+            }
+            mask |= (1U << f);
+        }
+        left &= ~mask;
+
+        part.sample[0].mask = mask;
+        int r = _send(&part, (left == 0), false);
+        if (r == -ENOTCONN) {
+            return r;
+        }
+        if (r != 0) {
+            res = r;
+        }
+    }
+    return res;
+}
+
+/* packs as many samples into one message as fit into a frame */
+static int _publish_frames(const telemetry_batch_t *b, unsigned *sent)
+{
+    int res = 0;
+
+    *sent = 0;
+    while (*sent < b->numof) {
+        part.numof = 0;
+        while ((*sent + part.numof) < b->numof) {
+            part.sample[part.numof] = b->sample[*sent + part.numof];
+            part.numof++;
+            if (!_fits(_encode(&part))) {
+                part.numof--;
+                break;
+            }
+        }
+
+        int r;
+        if (part.numof == 0) {
+            r = _publish_fields(&b->sample[*sent]);
+            part.numof = 1;
+        }
+        else {
+            r = _send(&part, part.numof, false);
+        }
+        if (r == -ENOTCONN) {
+            return r;
+        }
+        if (r != 0) {
+            res = r;
+        }
+        *sent += part.numof;
+    }
+    return res;
+}
+
+/* returns -EOVERFLOW if the batch can never be sent, -ENOTCONN if it may
+ * go through later, -EIO if a QoS -1 message was lost; @p sent is the
+ * number of samples at the front of the batch that are done with */
+static int _publish(const telemetry_batch_t *b, unsigned *sent)
+{
+    int res = _send(b, b->numof, true);
+
+    if (res == -EMSGSIZE) {
+        /* fragments of a lost frame take the whole message with them,
+         * rather send more messages that fit into one frame each */
+        return _publish_frames(b, sent);
+    }
+    if (res == -EOVERFLOW) {
+        puts("error: batch does not fit into one message");
+    }
+    *sent = (res == -ENOTCONN) ? 0 : b->numof;
+    return res;
+}
+
+static void _print_stats(void)
+{
+    /* bytes on air also count the headers every message pays for */
+    uint32_t air = stats.bytes + (stats.messages * SENSOR_LOOP_PUB_OVERHEAD);
+    uint32_t ms = (uint32_t)((xtimer_now_usec64() - stats.start) / US_PER_MS);
+    uint32_t rate = (ms > 0) ? (uint32_t)((stats.messages * 100000ULL) / ms) : 0;
+
+    printf("stats: %lu samples in %lu messages, %lu bytes on air "
+           "(%lu per sample), %lu.%02lu msg/s\n",
+           (unsigned long)stats.samples, (unsigned long)stats.messages,
+           (unsigned long)air,
+           (unsigned long)(stats.samples ? air / stats.samples : 0),
+           (unsigned long)(rate / 100), (unsigned long)(rate % 100));
+}
+
+static void _keep(const telemetry_batch_t *b, unsigned from)
+{
+    for (unsigned i = from; i < b->numof; i++) {
+        backlog_put(&backlog, &b->sample[i]);
+    }
+}
+
+static void _go_offline(void)
+{
+    if (!online) {
+        return;
+    }
+    online = false;
+    backoff = SENSOR_LOOP_BACKOFF_MIN;
+    retry_at = xtimer_now_usec64() + (backoff * US_PER_SEC);
+    printf("gateway lost, keeping samples, reconnect in %lus\n",
+           (unsigned long)backoff);
+}
+
+static void _flush(void)
+{
+    if (batch.numof == 0) {
+        return;
+    }
+    if (link_lost) {
+        link_lost = false;
+        _go_offline();
+    }
+
+    /* older samples go first, the batch waits behind them */
+    if (!online || (backlog_level(&backlog) > 0)) {
+        _keep(&batch, 0);
+    }
+    else {
+        unsigned sent;
+        int res = _publish(&batch, &sent);
+        if (res == -ENOTCONN) {
+            _keep(&batch, sent);
+            _go_offline();
+        }
+        if (res != 0) {
+            stats.failed++;
+        }
+    }
+    telemetry_batch_clear(&batch);
+    _print_stats();
+}
+
+static void _reconnect(void)
+{
+    if (params.sleep) {
+        if (sleepcl_wake() == EMCUTE_OK) {
+            printf("woke up the gateway, %u samples to replay\n",
+                   backlog_level(&backlog));
+            online = true;
+            replay_at = xtimer_now_usec64();
+            return;
+        }
+        goto backoff;
+    }
+
+    mutex_lock(&gw_lock);
+    sock_udp_ep_t gw = gateway;
+    mutex_unlock(&gw_lock);
+
+    /* after a gateway restart emcute still believes it is connected */
+    emcute_discon();
+    topic_cache_invalidate();
+    pubwin_disconnect();
+
+    if (emcute_con(&gw, true, NULL, NULL, 0, 0) == EMCUTE_OK) {
+        printf("reconnected to the gateway, %u samples to replay\n",
+               backlog_level(&backlog));
+        online = true;
+        replay_at = xtimer_now_usec64();
+        return;
+    }
+
+backoff:
+    /* exponential backoff, the gateway may take a while to come back */
+    backoff = (backoff * 2 > SENSOR_LOOP_BACKOFF_MAX) ?
+              SENSOR_LOOP_BACKOFF_MAX : backoff * 2;
+    retry_at = xtimer_now_usec64() + (backoff * US_PER_SEC);
+    printf("reconnect failed, next try in %lus\n", (unsigned long)backoff);
+}
+
+static void _replay(void)
+{
+    /* as many samples as fit into one message */
+    backlog_peek(&backlog, &replay, TELEMETRY_BATCH_MAX);
+    while ((replay.numof > 1) && (_encode(&replay) < 0)) {
+        replay.numof--;
+    }
+
+    unsigned sent;
+    uint32_t unsendable = stats.unsendable;
+    int res = _publish(&replay, &sent);
+    /* a sample that can never be sent would block the backlog forever, it
+     * goes but is not counted as replayed */
+    unsendable = stats.unsendable - unsendable;
+    if (unsendable > sent) {
+        unsendable = sent;
+    }
+    backlog_consume(&backlog, sent - unsendable);
+    backlog_discard(&backlog, unsendable);
+    if (res == -ENOTCONN) {
+        _go_offline();
+        return;
+    }
+    if (res != 0) {
+        stats.failed++;
+    }
+    replay_at = xtimer_now_usec64() + (SENSOR_LOOP_REPLAY_INTERVAL * US_PER_MS);
+
+    if (backlog_level(&backlog) == 0) {
+        printf("backlog replayed, %lu samples in total, %lu discarded\n",
+               (unsigned long)backlog.replayed,
+               (unsigned long)backlog.discarded);
+    }
+}
+
+/* back to sleep once nothing is left to send, until the next batch is due */
+static void _doze(void)
+{
+    if (!params.sleep || !online || (sleepcl_state() != SLEEPCL_ACTIVE) ||
+        (backlog_level(&backlog) > 0)) {
+        return;
+    }
+
+    unsigned duration = (params.period * params.batch) + SENSOR_LOOP_SLEEP_MARGIN;
+    if (sleepcl_sleep(duration) != EMCUTE_OK) {
+        puts("warning: the gateway did not confirm the sleep, staying awake");
+        return;
+    }
+    /* the next batch normally comes first, unless deadband holds it back */
+    poll_at = xtimer_now_usec64() + ((duration - 1) * US_PER_SEC);
+}
+
+/* nothing sent for a whole sleep duration, show up before the gateway gives
+ * up on the node and fetch what it kept meanwhile */
+static void _poll(void)
+{
+    unsigned duration = (params.period * params.batch) + SENSOR_LOOP_SLEEP_MARGIN;
+
+    if (sleepcl_poll() != EMCUTE_OK) {
+        _go_offline();
+        return;
+    }
+    poll_at = xtimer_now_usec64() + ((duration - 1) * US_PER_SEC);
+}
+
+static void _print_sleep(void)
+{
+    sleepcl_stats_t s;
+
+    sleepcl_get_stats(&s);
+    uint32_t on_ms = (uint32_t)(s.radio_on_us / US_PER_MS);
+    uint32_t secs = (uint32_t)(s.elapsed_us / US_PER_SEC);
+    /* always on would be 3600 s per hour */
+    uint32_t per_hour = s.elapsed_us ?
+                        (uint32_t)((s.radio_on_us * 3600ULL) / (s.elapsed_us / US_PER_MS)) : 0;
+    uint32_t pct = s.elapsed_us ?
+                   (uint32_t)((s.radio_on_us * 10000ULL) / s.elapsed_us) : 0;
+
+    printf("sleep: radio on %lu ms in %lu s, %lu ms per hour (%lu.%02lu%% of "
+           "always on), %lu wakes, %lu sleeps, %lu polls, %lu downlink\n",
+           (unsigned long)on_ms, (unsigned long)secs, (unsigned long)per_hour,
+           (unsigned long)(pct / 100), (unsigned long)(pct % 100),
+           (unsigned long)s.wakes, (unsigned long)s.sleeps,
+           (unsigned long)s.polls, (unsigned long)s.received);
+}
+
+/* called by the publisher, the netif may have changed with the gateway */
+static void _update_budget(void)
+{
+    sock_udp_ep_t gw = { .family = AF_INET6 };
+
+    /* without a gateway, assume a global address that is not elided */
+    if (have_gateway) {
+        mutex_lock(&gw_lock);
+        gw = gateway;
+        mutex_unlock(&gw_lock);
+    }
+    framebudget_get(&budget, &gw);
+    if (params.frame > 0) {
+        budget.pdu = 0;
+        budget.payload = params.frame;
+    }
+}
+
+/* the earliest moment the publisher has something to do without a message */
+static uint64_t _next_deadline(void)
+{
+    uint64_t deadline = NO_DEADLINE;
+
+    /* a partial batch is sent when its oldest sample gets too old */
+    if ((batch.numof > 0) && (params.maxage > 0)) {
+        deadline = oldest + (params.maxage * US_PER_SEC);
+    }
+    /* a stopped loop keeps its backlog for the next start */
+    if (running && !online && have_gateway && (retry_at < deadline)) {
+        deadline = retry_at;
+    }
+    if (running && online && (backlog_level(&backlog) > 0) &&
+        (replay_at < deadline)) {
+        deadline = replay_at;
+    }
+    if (params.sleep && online && (sleepcl_state() == SLEEPCL_ASLEEP) &&
+        (poll_at < deadline)) {
+        deadline = poll_at;
+    }
+    return deadline;
+}
+
+static void _timeout(void)
+{
+    uint64_t now = xtimer_now_usec64();
+
+    if ((batch.numof > 0) && (params.maxage > 0) &&
+        (now >= oldest + (params.maxage * US_PER_SEC))) {
+        _flush();
+    }
+    if (!running) {
+        return;
+    }
+    if (!online && have_gateway && (now >= retry_at)) {
+        _reconnect();
+    }
+    else if (online && (backlog_level(&backlog) > 0) && (now >= replay_at)) {
+        _replay();
+    }
+    else if (params.sleep && online && (sleepcl_state() == SLEEPCL_ASLEEP) &&
+             (now >= poll_at)) {
+        _poll();
+    }
+}
+
+/* publisher only, the single writer of params while the loop runs */
+static void _apply_tune(void)
+{
+    static const unsigned qos_flags[] = { EMCUTE_QOS_0, EMCUTE_QOS_1, EMCUTE_QOS_2 };
+
+    mutex_lock(&tune_lock);
+    sensor_loop_tune_t t = tune;
+    tune = (sensor_loop_tune_t){ .qos = -1 };
+    mutex_unlock(&tune_lock);
+
+    /* the sampler picks the period up before its next wait */
+    if (t.period > 0) {
+        params.period = t.period;
+    }
+    if (t.batch > 0) {
+        params.batch = t.batch;
+    }
+    if (t.qos >= 0) {
+        params.flags = (params.flags & ~EMCUTE_QOS_MASK) | qos_flags[t.qos];
+    }
+}
+
+static void _drain(void)
+{
+    telemetry_sample_t s;
+
+    while (sample_ring_pop(&ring, &s)) {
+        if (batch.numof == 0) {
+            oldest = xtimer_now_usec64();
+        }
+        telemetry_batch_add(&batch, &s);
+        /* a full batch goes out right away */
+        if (batch.numof >= params.batch) {
+            _flush();
+        }
+    }
+}
+
+static void *_publisher(void *arg)
+{
+    (void)arg;
+    msg_init_queue(publisher_queue,
+                   sizeof(publisher_queue) / sizeof(publisher_queue[0]));
+
+    while (1) {
+        msg_t msg = { .type = 0 };
+        uint64_t deadline = _next_deadline();
+
+        if (deadline == NO_DEADLINE) {
+            msg_receive(&msg);
+        }
+        else {
+            uint64_t now = xtimer_now_usec64();
+            if ((deadline <= now) ||
+                (xtimer_msg_receive_timeout(&msg, (uint32_t)(deadline - now)) < 0)) {
+                _timeout();
+                _doze();
+                continue;
+            }
+        }
+
+        _collect();
+        _apply_tune();
+        if (msg.type == MSG_GATEWAY) {
+            _update_budget();
+            /* the shell connected by hand, no need to wait for the backoff */
+            if (have_gateway && !online) {
+                online = true;
+                replay_at = xtimer_now_usec64();
+            }
+            continue;
+        }
+
+        _drain();
+        if (msg.type == MSG_STOP) {
+            _flush();
+            /* wait for the last acknowledgements */
+            if (params.window > 0) {
+                pubwin_flush();
+                _collect();
+                _print_stats();
+            }
+            if (params.sleep) {
+                _print_sleep();
+                sleepcl_close();
+                puts("sleeping session closed, con connects emcute again");
+            }
+            /* the shell may change params from here on */
+            msg_reply(&msg, &msg);
+        }
+        _doze();
+    }
+
+    return NULL;
+}
+
+static void *_sampler(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        if (!running) {
+            /* wait for loop start, then sample right away */
+            mutex_lock(&gate);
+            mutex_unlock(&gate);
+            periodic_init(&sample_task, "sampler", params.period * MS_PER_SEC,
+                          NULL, NULL);
+        }
+
+        telemetry_sample_t s;
+        sample_cb(&s);
+        stats.sampled++;
+        /* nothing moved enough, the broker already has these values */
+        if (deadband_check(&filter, &s,
+                           (uint32_t)(xtimer_now_usec64() / US_PER_SEC))) {
+            if (!sample_ring_push(&ring, &s)) {
+                puts("warning: sample ring full, sample dropped");
+            }
+            msg_t msg = { .type = MSG_SAMPLE };
+            msg_try_send(&msg, publisher_pid);
+        }
+
+        /* absolute deadlines keep the period independent of the work above,
+         * a tuned period starts after the deadline already set */
+        sample_task.period = params.period * MS_PER_SEC;
+        periodic_wait(&sample_task);
+    }
+
+    return NULL;
+}
+
+void sensor_loop_init(sensor_loop_sample_cb_t cb)
+{
+    sample_cb = cb;
+    sample_ring_init(&ring);
+    backlog_init(&backlog);
+    telemetry_batch_clear(&batch);
+
+    publisher_pid = thread_create(publisher_stack, sizeof(publisher_stack),
+                                  PUBLISHER_PRIO, THREAD_CREATE_STACKTEST,
+                                  _publisher, NULL, "publisher");
+    thread_create(sampler_stack, sizeof(sampler_stack), SAMPLER_PRIO,
+                  THREAD_CREATE_STACKTEST, _sampler, NULL, "sampler");
+}
+
+void sensor_loop_set_gateway(const sock_udp_ep_t *gw, const char *client_id)
+{
+    msg_t msg = { .type = MSG_GATEWAY };
+
+    /* after disc the loop keeps samples but does not reconnect on its own */
+    if (gw == NULL) {
+        have_gateway = false;
+        pubwin_disconnect();
+        return;
+    }
+
+    mutex_lock(&gw_lock);
+    gateway = *gw;
+    /* a session of its own, the gateway would drop the emcute one otherwise */
+    snprintf(win_client_id, sizeof(win_client_id), "%.19s-win", client_id);
+    snprintf(sleep_client_id, sizeof(sleep_client_id), "%s", client_id);
+    mutex_unlock(&gw_lock);
+    have_gateway = true;
+
+    msg_try_send(&msg, publisher_pid);
+}
+
+/* the sleeping session takes the client ID over from emcute, with the
+ * config topic if devcfg listens to it */
+static int _hand_over(void)
+{
+    const char *topic = NULL;
+    sleepcl_cb_t cb = NULL;
+
+    if (!have_gateway) {
+        puts("error: sleep needs the gateway, con first");
+        return 1;
+    }
+#ifdef MODULE_DEVCFG
+    devcfg_stop();
+    snprintf(cfg_topic, sizeof(cfg_topic), DEVCFG_TOPIC_FMT, sleep_client_id);
+    topic = cfg_topic;
+    cb = devcfg_handle;
+#endif
+    emcute_discon();
+    topic_cache_invalidate();
+
+    mutex_lock(&gw_lock);
+    sock_udp_ep_t gw = gateway;
+    mutex_unlock(&gw_lock);
+    if (sleepcl_open(&gw, sleep_client_id, topic, cb, NULL) != EMCUTE_OK) {
+        puts("error: unable to open the sleeping session");
+        return 1;
+    }
+    online = true;
+    return 0;
+}
+
+static int _start(int argc, char **argv)
+{
+    /* only the shell thread starts and stops the loop */
+    static params_t p;
+    static deadband_t db;
+
+    if (running) {
+        puts("error: loop is already running, stop it first");
+        return 1;
+    }
+    /* a failed start leaves the parameters of the last run alone */
+    if (_parse(argc, argv, &p, &db) != 0) {
+        return 1;
+    }
+    if (p.sleep && (_hand_over() != 0)) {
+        return 1;
+    }
+
+    /* the publisher is done with the last run, see _stop(), and the
+     * sampler waits on the gate */
+    params = p;
+    filter = db;
+    mutex_lock(&tune_lock);
+    tune = (sensor_loop_tune_t){ .qos = -1 };
+    mutex_unlock(&tune_lock);
+    _update_budget();
+
+    memset(&stats, 0, sizeof(stats));
+    stats.start = xtimer_now_usec64();
+    running = true;
+    mutex_unlock(&gate);
+
+    printf("loop started on %s, %s, %u samples per message\n",
+           params.topic, fmt_names[params.fmt], params.batch);
+    if ((params.fmt == FMT_JSON) && (_limit() > 0) &&
+        (_limit() < TELEMETRY_JSON_MAXLEN)) {
+        printf("note: %u bytes fit into one frame, JSON samples may be sent "
+               "a few fields at a time, fmt=bin fits %u samples\n",
+               budget.payload, budget.payload / TELEMETRY_BIN_MAXLEN);
+    }
+    return 0;
+}
+
+static int _qos(unsigned flags)
+{
+    switch (flags & EMCUTE_QOS_MASK) {
+        case QOSM1_QOS:     return -1;
+        case EMCUTE_QOS_1:  return 1;
+        case EMCUTE_QOS_2:  return 2;
+        default:            return 0;
+    }
+}
+
+int sensor_loop_tune(sensor_loop_tune_t *t)
+{
+    msg_t msg = { .type = MSG_TUNE };
+    int res = -EINVAL;
+
+    mutex_lock(&tune_lock);
+    if (!running) {
+        /* params are those of the last run and _start() drops the values */
+        res = -EAGAIN;
+        goto out;
+    }
+    /* check everything first, a config is applied completely or not at all;
+     * fmt, window and QoS -1 only change with loop start */
+    if ((t->batch > _batch_max(params.fmt)) || (t->qos < -1) || (t->qos > 2)) {
+        goto out;
+    }
+    if ((params.window > 0) && (t->qos >= 0) && (t->qos != 1)) {
+        /* the window only works with acknowledged messages */
+        goto out;
+    }
+    if ((_qos(params.flags) == -1) && (t->qos >= 0)) {
+        /* no emcute session to publish with, restart the loop instead */
+        goto out;
+    }
+    if (params.sleep && (t->qos == 2)) {
+        /* the sleeping session publishes with QoS 0 or 1 only */
+        goto out;
+    }
+
+    /* the publisher applies them when it wakes up, on top of values of an
+     * earlier call it did not get to yet */
+    if (t->period > 0) {
+        tune.period = t->period;
+    }
+    if (t->batch > 0) {
+        tune.batch = t->batch;
+    }
+    if (t->qos >= 0) {
+        tune.qos = t->qos;
+    }
+    t->period = tune.period ? tune.period : params.period;
+    t->batch = tune.batch ? tune.batch : params.batch;
+    t->qos = (tune.qos >= 0) ? tune.qos : _qos(params.flags);
+    res = 0;
+
+out:
+    mutex_unlock(&tune_lock);
+    if (res == 0) {
+        /* a full queue is fine, any other message wakes it up as well */
+        msg_try_send(&msg, publisher_pid);
+    }
+    return res;
+}
+
+static int _stop(void)
+{
+    if (!running) {
+        puts("error: loop is not running");
+        return 1;
+    }
+    mutex_lock(&gate);
+    running = false;
+
+    /* the publisher sends what is still queued and replies once it no
+     * longer uses params */
+    msg_t msg = { .type = MSG_STOP };
+    msg_send_receive(&msg, &msg, publisher_pid);
+
+    puts("loop stopped");
+    return 0;
+}
+
+static int _status(void)
+{
+    printf("loop %s", running ? "running" : "stopped");
+    if (params.topic[0]) {
+        printf(" on %s, %s, period %us, batch %u, maxage %us, window %u, "
+               "flags 0x%02x", params.topic, fmt_names[params.fmt],
+               params.period, params.batch, params.maxage, params.window,
+               params.flags);
+    }
+    puts("");
+    printf("sampled %lu, ring %u/%u (high water %u), %lu dropped\n",
+           (unsigned long)stats.sampled, sample_ring_level(&ring),
+           SAMPLE_RING_SIZE, ring.high_water, (unsigned long)ring.drops);
+    printf("batch %u/%u, %lu messages failed, %lu samples too big to send",
+           batch.numof, params.batch, (unsigned long)stats.failed,
+           (unsigned long)stats.unsendable);
+    if (params.window > 0) {
+        printf(", %u/%u in flight", pubwin_inflight(), params.window);
+    }
+    puts("");
+    printf("gateway %s, backlog %u/%u, %lu buffered, %lu replayed, "
+           "%lu discarded, %lu dropped\n", online ? "online" : "offline",
+           backlog_level(&backlog), BACKLOG_SIZE,
+           (unsigned long)backlog.buffered, (unsigned long)backlog.replayed,
+           (unsigned long)backlog.discarded, (unsigned long)backlog.dropped);
+    if (params.frame == FRAME_OFF) {
+        printf("frame=off, ");
+    }
+    framebudget_print(&budget);
+    if (params.sleep) {
+        _print_sleep();
+    }
+    if (filter.enabled) {
+        uint32_t total = filter.passed + filter.suppressed;
+        printf("deadband: %lu sent, %lu suppressed (%lu%%), %lu heartbeats "
+               "every %lus\n", (unsigned long)filter.passed,
+               (unsigned long)filter.suppressed,
+               (unsigned long)(total ? (filter.suppressed * 100ULL) / total : 0),
+               (unsigned long)filter.heartbeats,
+               (unsigned long)filter.heartbeat);
+    }
+    _print_stats();
+    periodic_print_stats(&sample_task, 1);
+    return 0;
+}
+
+int sensor_loop_cmd(int argc, char **argv)
+{
+    if ((argc >= 2) && (strcmp(argv[1], "stop") == 0)) {
+        return _stop();
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "status") == 0)) {
+        return _status();
+    }
+    if ((argc >= 3) && (strcmp(argv[1], "start") == 0)) {
+        return _start(argc - 2, argv + 2);
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "start") != 0)) {
+        /* old form: loop <topic> [data] [QoS level] [options], data unused */
+        if (argc >= 3) {
+            argv[2] = argv[1];
+            return _start(argc - 2, argv + 2);
+        }
+        return _start(argc - 1, argv + 1);
+    }
+
+    printf("usage: %s start <topic name> [QoS level] [fmt=json|bin|delta] "
+           "[period=S] [batch=N] [maxage=S] [window=W]\n"
+           "       [db=<field|all>:<band>[:<hysteresis>]]... [heartbeat=S] [sleep]\n"
+           "       [frame=auto|off|N]\n"
+           "       %s stop|status\n", argv[0], argv[0]);
+    return 1;
+}
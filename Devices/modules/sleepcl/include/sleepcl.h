@@ -0,0 +1,204 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sleepcl MQTT-SN sleeping client
+ * @{
+ *
+ * @file
+ * @brief       MQTT-SN session that tells the gateway when the node sleeps
+ *
+ * emcute only knows connected and disconnected. A node that turns its radio
+ * off while connected misses its keepalive and whatever the gateway sends
+ * meanwhile. This module runs the sleep cycle of MQTT-SN v1.2 instead, on a
+ * UDP socket of its own and without a thread:
+ *
+ * - sleepcl_wake() sends CONNECT, the first time with a clean session,
+ *   afterwards keeping the session, and a SUBSCRIBE to the downlink topic:
+ *   a gateway that restarted while the node slept accepts the CONNECT but
+ *   no longer knows the subscription
+ * - sleepcl_pub() publishes with QoS 0 or 1 while awake
+ * - sleepcl_sleep() sends DISCONNECT with a duration and turns the radio
+ *   off, the gateway keeps messages for the node until it is back
+ * - sleepcl_poll() turns the radio on for a PINGREQ with the client ID,
+ *   takes the buffered messages and goes back to sleep at the PINGRESP,
+ *   repeating the PINGREQ after a message for gateways that hold the
+ *   PINGRESP back until then, like Gateway/MQTT-SNGateway
+ *
+ * Publications on the downlink topic are handed to the callback while the
+ * module waits for an answer of the gateway. The radio is the first network
+ * interface, set to NETOPT_STATE_SLEEP while asleep. Its time on is counted
+ * either way, native's tap interface cannot sleep.
+ *
+ * Only predefined topic IDs and short topic names can be published, the
+ * session never registers topics.
+ *
+ * @}
+ */
+
+#ifndef SLEEPCL_H
+#define SLEEPCL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/sock/udp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Seconds to wait for an answer of the gateway before retrying
+ */
+#ifndef SLEEPCL_T_RETRY
+#define SLEEPCL_T_RETRY     (2U)
+#endif
+
+/**
+ * @brief   Retransmissions before giving up
+ */
+#ifndef SLEEPCL_N_RETRY
+#define SLEEPCL_N_RETRY     (2U)
+#endif
+
+/**
+ * @brief   Keepalive in seconds announced in CONNECT
+ */
+#ifndef SLEEPCL_KEEPALIVE
+#define SLEEPCL_KEEPALIVE   (900U)
+#endif
+
+/**
+ * @brief   Largest PUBLISH message, header included
+ */
+#ifndef SLEEPCL_BUFSIZE
+#define SLEEPCL_BUFSIZE     (512U)
+#endif
+
+/**
+ * @brief   Largest downlink message, header included
+ */
+#ifndef SLEEPCL_RX_BUFSIZE
+#define SLEEPCL_RX_BUFSIZE  (128U)
+#endif
+
+/**
+ * @brief   State of the session as the gateway sees it
+ */
+typedef enum {
+    SLEEPCL_CLOSED,     /**< no session */
+    SLEEPCL_ACTIVE,     /**< connected, radio on */
+    SLEEPCL_ASLEEP,     /**< gateway keeps messages, radio off */
+} sleepcl_state_t;
+
+/**
+ * @brief   Called for every publication on the downlink topic
+ *
+ * Same signature as subreg_cb_t, so the handlers of subreg can be reused.
+ */
+typedef void (*sleepcl_cb_t)(const char *topic, const void *data, size_t len,
+                             void *arg);
+
+/**
+ * @brief   Counters of the session
+ */
+typedef struct {
+    uint64_t radio_on_us;   /**< time with the radio on */
+    uint64_t elapsed_us;    /**< time since sleepcl_open() */
+    uint32_t wakes;         /**< CONNECT to the gateway */
+    uint32_t sleeps;        /**< DISCONNECT with a duration */
+    uint32_t polls;         /**< PINGREQ while asleep */
+    uint32_t received;      /**< publications on the downlink topic */
+} sleepcl_stats_t;
+
+/**
+ * @brief   Set up the session, nothing is sent yet
+ *
+ * @param[in] gw        gateway address and port
+ * @param[in] client_id client ID, at most 23 characters
+ * @param[in] topic     downlink topic, may be NULL, must stay valid
+ * @param[in] cb        called for publications on @p topic
+ * @param[in] arg       argument of @p cb
+ *
+ * @return  EMCUTE_OK on success
+ * @return  EMCUTE_NOGW if the socket could not be created
+ * @return  EMCUTE_OVERFLOW if @p client_id is too long
+ */
+int sleepcl_open(const sock_udp_ep_t *gw, const char *client_id,
+                 const char *topic, sleepcl_cb_t cb, void *arg);
+
+/**
+ * @brief   Turn the radio on and connect, subscribes after every CONNECT
+ *
+ * The session is active after a failed SUBSCRIBE, the subscription is
+ * tried again on the next call.
+ *
+ * @return  EMCUTE_OK on success
+ * @return  EMCUTE_TIMEOUT if the gateway did not answer
+ * @return  EMCUTE_REJECT if the gateway refused the connection or the
+ *          subscription
+ */
+int sleepcl_wake(void);
+
+/**
+ * @brief   Publish while awake
+ *
+ * @param[in] topic_id  predefined topic ID or short topic name
+ * @param[in] flags     QoS 0 or 1 and the topic ID type
+ * @param[in] data      payload
+ * @param[in] len       length of @p data
+ *
+ * @return  EMCUTE_OK on success
+ * @return  EMCUTE_NOGW if not awake
+ * @return  EMCUTE_NOTSUP for QoS 2 or a normal topic ID
+ * @return  EMCUTE_OVERFLOW if the message exceeds SLEEPCL_BUFSIZE
+ * @return  EMCUTE_TIMEOUT if a QoS 1 message got no PUBACK
+ */
+int sleepcl_pub(uint16_t topic_id, unsigned flags, const void *data,
+                size_t len);
+
+/**
+ * @brief   Tell the gateway the node sleeps and turn the radio off
+ *
+ * @param[in] duration  seconds until the node shows up again at the latest
+ *
+ * @return  EMCUTE_OK on success
+ * @return  EMCUTE_NOGW if not awake
+ * @return  EMCUTE_TIMEOUT if the gateway did not answer, still awake then
+ */
+int sleepcl_sleep(uint16_t duration);
+
+/**
+ * @brief   Fetch the messages the gateway kept and go back to sleep
+ *
+ * @return  EMCUTE_OK on success, the sleep duration starts again
+ * @return  EMCUTE_NOGW if not asleep
+ * @return  EMCUTE_TIMEOUT if the gateway did not answer
+ */
+int sleepcl_poll(void);
+
+/**
+ * @brief   End the session, the radio stays on
+ */
+void sleepcl_close(void);
+
+/**
+ * @brief   Get the state of the session
+ */
+sleepcl_state_t sleepcl_state(void);
+
+/**
+ * @brief   Get a copy of the counters
+ */
+void sleepcl_get_stats(sleepcl_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLEEPCL_H */
@@ -0,0 +1,411 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sleepcl
+ * @{
+ *
+ * @file
+ * @brief       MQTT-SN sleeping client implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "mutex.h"
+#include "xtimer.h"
+#include "net/emcute.h"
+#ifdef MODULE_GNRC_NETIF
+#include "net/gnrc/netif.h"
+#include "net/netopt.h"
+#endif
+
+#include "mqttsn_frame.h"
+#include "sleepcl.h"
+
+#define CLIENT_ID_MAXLEN (23U)
+
+/* protects everything below, one caller at a time */
+static mutex_t lock = MUTEX_INIT;
+static sock_udp_t sock;
+static bool have_sock;
+static sock_udp_ep_t gateway;
+static char client_id[CLIENT_ID_MAXLEN + 1];
+static sleepcl_state_t state;
+static bool subscribed;
+static uint16_t next_id;
+
+/* downlink */
+static const char *topic;
+static uint16_t topic_id;
+static sleepcl_cb_t cb;
+static void *cb_arg;
+
+static uint8_t txbuf[SLEEPCL_BUFSIZE];
+static uint8_t rxbuf[SLEEPCL_RX_BUFSIZE];
+/* body of the answer _await() returned */
+static const uint8_t *rx_body;
+
+static bool radio_on = true;
+static uint64_t radio_since;    /* usec, last switch of the radio */
+static uint64_t opened;         /* usec */
+static sleepcl_stats_t stats;
+
+static void _radio(bool on)
+{
+    uint64_t now = xtimer_now_usec64();
+
+    if (on == radio_on) {
+        return;
+    }
+    if (radio_on) {
+        stats.radio_on_us += now - radio_since;
+    }
+    radio_since = now;
+    radio_on = on;
+
+#ifdef MODULE_GNRC_NETIF
+    gnrc_netif_t *netif = gnrc_netif_iter(NULL);
+    netopt_state_t st = on ? NETOPT_STATE_IDLE : NETOPT_STATE_SLEEP;
+    if (netif != NULL) {
+        /* not supported by every driver, the time is counted anyway */
+        gnrc_netapi_set(netif->pid, NETOPT_STATE, 0, &st, sizeof(st));
+    }
+#endif
+}
+
+static uint16_t _next_id(void)
+{
+    /* message IDs wrap around but are never 0 */
+    if (++next_id == 0) {
+        next_id = 1;
+    }
+    return next_id;
+}
+
+static void _puback(uint16_t id, uint16_t msg_id)
+{
+    uint8_t buf[7];
+    size_t pos = mqttsn_frame_hdr(buf, 5, MQTTSN_FRAME_PUBACK);
+
+    buf[pos++] = (uint8_t)(id >> 8);
+    buf[pos++] = (uint8_t)id;
+    buf[pos++] = (uint8_t)(msg_id >> 8);
+    buf[pos++] = (uint8_t)msg_id;
+    buf[pos++] = 0;
+    sock_udp_send(&sock, buf, sizeof(buf), &gateway);
+}
+
+static void _on_publish(const uint8_t *msg, size_t len)
+{
+    if (len < 5) {
+        return;
+    }
+    uint16_t id = ((uint16_t)msg[1] << 8) | msg[2];
+    uint16_t msg_id = ((uint16_t)msg[3] << 8) | msg[4];
+
+    if ((msg[0] & EMCUTE_QOS_MASK) == EMCUTE_QOS_1) {
+        _puback(id, msg_id);
+    }
+    /* the gateway may hand over kept messages before the SUBSCRIBE of this
+     * wake up is answered, the topic ID of the last SUBACK still holds */
+    if ((topic_id != 0) && (id == topic_id) && cb) {
+        stats.received++;
+        cb(topic, msg + 5, len - 5, cb_arg);
+    }
+}
+
+/* waits for a message of the given type and message ID (0 for none) and
+ * delivers publications meanwhile, returns the length of its body; a wait
+ * for PINGRESP ends with -EAGAIN at the first publication instead */
+static int _await(uint8_t type, uint16_t msg_id, uint32_t timeout)
+{
+    uint32_t start = xtimer_now_usec();
+    uint32_t waited = 0;
+
+    while (waited < timeout) {
+        sock_udp_ep_t remote;
+        ssize_t n = sock_udp_recv(&sock, rxbuf, sizeof(rxbuf),
+                                  timeout - waited, &remote);
+        waited = xtimer_now_usec() - start;
+        const uint8_t *msg;
+        uint8_t t;
+        int len = (n > 0) ? mqttsn_frame_parse(rxbuf, n, &t, &msg) : -EBADMSG;
+        if (len < 0) {
+            continue;
+        }
+
+        if (t == MQTTSN_FRAME_PUBLISH) {
+            _on_publish(msg, len);
+            if (type == MQTTSN_FRAME_PINGRESP) {
+                return -EAGAIN;
+            }
+        }
+        else if ((t == type) && (msg_id == 0)) {
+            rx_body = msg;
+            return len;
+        }
+        else if ((t == type) && (len >= 5) &&
+                 (((uint16_t)msg[len - 3] << 8 | msg[len - 2]) == msg_id)) {
+            /* PUBACK and SUBACK end with message ID and return code */
+            rx_body = msg;
+            return len;
+        }
+    }
+    return -ETIMEDOUT;
+}
+
+/* sends and waits for the answer, retrying a few times */
+static int _exchange(const uint8_t *buf, size_t len, uint8_t type,
+                     uint16_t msg_id)
+{
+    for (unsigned i = 0; i <= SLEEPCL_N_RETRY; i++) {
+        sock_udp_send(&sock, buf, len, &gateway);
+        int rlen = _await(type, msg_id, SLEEPCL_T_RETRY * US_PER_SEC);
+        if (rlen >= 0) {
+            return rlen;
+        }
+    }
+    return -ETIMEDOUT;
+}
+
+static int _subscribe(void)
+{
+    size_t name_len = strlen(topic);
+    size_t pos = mqttsn_frame_hdr(txbuf, 3 + name_len, MQTTSN_FRAME_SUBSCRIBE);
+    uint16_t msg_id = _next_id();
+
+    txbuf[pos++] = EMCUTE_QOS_1 | EMCUTE_TIT_NORMAL;
+    txbuf[pos++] = (uint8_t)(msg_id >> 8);
+    txbuf[pos++] = (uint8_t)msg_id;
+    memcpy(&txbuf[pos], topic, name_len);
+
+    int len = _exchange(txbuf, pos + name_len, MQTTSN_FRAME_SUBACK, msg_id);
+    if (len < 0) {
+        return EMCUTE_TIMEOUT;
+    }
+    /* flags, topic ID, message ID, return code */
+    if ((len < 6) || (rx_body[5] != 0)) {
+        return EMCUTE_REJECT;
+    }
+    topic_id = ((uint16_t)rx_body[1] << 8) | rx_body[2];
+    subscribed = true;
+    return EMCUTE_OK;
+}
+
+int sleepcl_open(const sock_udp_ep_t *gw, const char *id, const char *t,
+                 sleepcl_cb_t callback, void *arg)
+{
+    if (strlen(id) > CLIENT_ID_MAXLEN) {
+        return EMCUTE_OVERFLOW;
+    }
+
+    mutex_lock(&lock);
+    if (!have_sock) {
+        sock_udp_ep_t local = SOCK_IPV6_EP_ANY;
+        have_sock = (sock_udp_create(&sock, &local, NULL, 0) == 0);
+    }
+    if (!have_sock) {
+        mutex_unlock(&lock);
+        return EMCUTE_NOGW;
+    }
+    gateway = *gw;
+    strcpy(client_id, id);
+    topic = t;
+    cb = callback;
+    cb_arg = arg;
+    state = SLEEPCL_CLOSED;
+    subscribed = false;
+    topic_id = 0;
+
+    _radio(true);
+    memset(&stats, 0, sizeof(stats));
+    opened = xtimer_now_usec64();
+    radio_since = opened;
+    mutex_unlock(&lock);
+    return EMCUTE_OK;
+}
+
+int sleepcl_wake(void)
+{
+    size_t len;
+    int res = EMCUTE_OK;
+
+    mutex_lock(&lock);
+    if (state == SLEEPCL_ACTIVE) {
+        goto sub;
+    }
+
+    _radio(true);
+    /* a clean session only the first time */
+    len = mqttsn_frame_connect(txbuf, (state == SLEEPCL_CLOSED) ? EMCUTE_CS : 0,
+                               SLEEPCL_KEEPALIVE, client_id);
+
+    int ack = _exchange(txbuf, len, MQTTSN_FRAME_CONNACK, 0);
+    if (ack < 0) {
+        res = EMCUTE_TIMEOUT;
+        goto out;
+    }
+    if ((ack < 1) || (rx_body[0] != 0)) {
+        res = EMCUTE_REJECT;
+        goto out;
+    }
+    /* a gateway that restarted while the node slept answers like any other
+     * but has forgotten the subscription, so subscribe after every CONNECT */
+    subscribed = false;
+    state = SLEEPCL_ACTIVE;
+    stats.wakes++;
+
+sub:
+    /* tried again on every wake until the gateway takes it */
+    if (topic && !subscribed) {
+        res = _subscribe();
+    }
+
+out:
+    mutex_unlock(&lock);
+    return res;
+}
+
+int sleepcl_pub(uint16_t id, unsigned flags, const void *data, size_t len)
+{
+    unsigned qos = flags & EMCUTE_QOS_MASK;
+
+    if (((qos != EMCUTE_QOS_0) && (qos != EMCUTE_QOS_1)) ||
+        ((flags & EMCUTE_TIT_MASK) == EMCUTE_TIT_NORMAL)) {
+        return EMCUTE_NOTSUP;
+    }
+    if (len + MQTTSN_FRAME_PUB_HDR_MAXLEN > sizeof(txbuf)) {
+        return EMCUTE_OVERFLOW;
+    }
+
+    mutex_lock(&lock);
+    if (state != SLEEPCL_ACTIVE) {
+        mutex_unlock(&lock);
+        return EMCUTE_NOGW;
+    }
+
+    uint16_t msg_id = (qos == EMCUTE_QOS_1) ? _next_id() : 0;
+    size_t pos = mqttsn_frame_pub(txbuf, len,
+                                  qos | (flags & (EMCUTE_TIT_MASK |
+                                                  EMCUTE_RETAIN)),
+                                  id, msg_id);
+    memcpy(&txbuf[pos], data, len);
+
+    int res = EMCUTE_OK;
+    if (qos == EMCUTE_QOS_0) {
+        sock_udp_send(&sock, txbuf, pos + len, &gateway);
+    }
+    else {
+        if (_exchange(txbuf, pos + len, MQTTSN_FRAME_PUBACK, msg_id) < 0) {
+            res = EMCUTE_TIMEOUT;
+        }
+        else if (rx_body[4] != 0) {
+            res = EMCUTE_REJECT;
+        }
+    }
+    mutex_unlock(&lock);
+    return res;
+}
+
+int sleepcl_sleep(uint16_t duration)
+{
+    uint8_t buf[4];
+    size_t pos = mqttsn_frame_hdr(buf, 2, MQTTSN_FRAME_DISCONNECT);
+
+    buf[pos++] = (uint8_t)(duration >> 8);
+    buf[pos++] = (uint8_t)duration;
+
+    mutex_lock(&lock);
+    if (state != SLEEPCL_ACTIVE) {
+        mutex_unlock(&lock);
+        return EMCUTE_NOGW;
+    }
+    if (_exchange(buf, sizeof(buf), MQTTSN_FRAME_DISCONNECT, 0) < 0) {
+        mutex_unlock(&lock);
+        return EMCUTE_TIMEOUT;
+    }
+    state = SLEEPCL_ASLEEP;
+    stats.sleeps++;
+    _radio(false);
+    mutex_unlock(&lock);
+    return EMCUTE_OK;
+}
+
+int sleepcl_poll(void)
+{
+    mutex_lock(&lock);
+    if (state != SLEEPCL_ASLEEP) {
+        mutex_unlock(&lock);
+        return EMCUTE_NOGW;
+    }
+
+    _radio(true);
+    size_t id_len = strlen(client_id);
+    size_t pos = mqttsn_frame_hdr(txbuf, id_len, MQTTSN_FRAME_PINGREQ);
+    memcpy(&txbuf[pos], client_id, id_len);
+
+    /* the kept messages come first, PINGRESP sends the node back to sleep.
+     * The Paho gateway holds the PINGRESP after flushing its queue until the
+     * next PINGREQ, so ping again right after a message instead of waiting
+     * for the retry timer; only timeouts count as retries */
+    int res = EMCUTE_TIMEOUT;
+    for (unsigned i = 0; i <= SLEEPCL_N_RETRY;) {
+        sock_udp_send(&sock, txbuf, pos + id_len, &gateway);
+        int len = _await(MQTTSN_FRAME_PINGRESP, 0,
+                         SLEEPCL_T_RETRY * US_PER_SEC);
+        if (len >= 0) {
+            res = EMCUTE_OK;
+            break;
+        }
+        if (len != -EAGAIN) {
+            i++;
+        }
+    }
+    stats.polls++;
+    _radio(false);
+    mutex_unlock(&lock);
+    return res;
+}
+
+void sleepcl_close(void)
+{
+    uint8_t buf[2];
+
+    mutex_lock(&lock);
+    _radio(true);
+    if (state != SLEEPCL_CLOSED) {
+        mqttsn_frame_hdr(buf, 0, MQTTSN_FRAME_DISCONNECT);
+        /* best effort, the gateway drops the session after a while anyway */
+        sock_udp_send(&sock, buf, sizeof(buf), &gateway);
+        _await(MQTTSN_FRAME_DISCONNECT, 0, SLEEPCL_T_RETRY * US_PER_SEC);
+    }
+    state = SLEEPCL_CLOSED;
+    subscribed = false;
+    topic_id = 0;
+    mutex_unlock(&lock);
+}
+
+sleepcl_state_t sleepcl_state(void)
+{
+    return state;
+}
+
+void sleepcl_get_stats(sleepcl_stats_t *out)
+{
+    mutex_lock(&lock);
+    uint64_t now = xtimer_now_usec64();
+    *out = stats;
+    if (radio_on) {
+        out->radio_on_us += now - radio_since;
+    }
+    out->elapsed_us = now - opened;
+    mutex_unlock(&lock);
+}
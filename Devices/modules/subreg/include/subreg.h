@@ -0,0 +1,115 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    subreg MQTT-SN subscription registry
+ * @{
+ *
+ * @file
+ * @brief       Subscriptions with wildcards and per-subscription callbacks
+ *
+ * A subscription is a topic filter with a callback. Filters may use the
+ * MQTT wildcards `+` (one level) and `#` (all remaining levels).
+ *
+ * emcute only delivers publications whose topic ID it got in a SUBACK and
+ * ignores the REGISTER a gateway sends for topics matched by a wildcard. So
+ * the registry subscribes at the gateway to concrete topics only: the
+ * filter itself when it has no wildcard, otherwise every predefined topic
+ * and every topic already subscribed that matches it. Each concrete topic is
+ * subscribed once, whatever the number of filters matching it, and carries
+ * the set of filters to call. An incoming PUBLISH finds its topic straight
+ * from the emcute subscription, without any search.
+ *
+ * Topic names and filters are kept once each, with their exact length, in
+ * a shared pool. Callbacks get the payload in the emcute receive buffer,
+ * without a copy.
+ *
+ * @}
+ */
+
+#ifndef SUBREG_H
+#define SUBREG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Concrete topics subscribed at the gateway
+ */
+#ifndef SUBREG_TOPICS
+#define SUBREG_TOPICS               (24U)
+#endif
+
+/**
+ * @brief   Topic filters with a callback, at most 32
+ */
+#ifndef SUBREG_FILTERS
+#define SUBREG_FILTERS              (24U)
+#endif
+
+/**
+ * @brief   Bytes for all topic names and filters, one byte more per name
+ */
+#ifndef SUBREG_POOL_SIZE
+#define SUBREG_POOL_SIZE            (384U)
+#endif
+
+/**
+ * @brief   Called for every publication matching a filter
+ *
+ * @param[in] topic     concrete topic of the publication
+ * @param[in] data      payload, only valid during the call
+ * @param[in] len       payload length
+ * @param[in] arg       argument given to subreg_sub()
+ */
+typedef void (*subreg_cb_t)(const char *topic, const void *data, size_t len,
+                            void *arg);
+
+/**
+ * @brief   Subscribe to a topic filter
+ *
+ * @param[in] filter    topic name or filter with wildcards
+ * @param[in] flags     QoS level of the subscriptions at the gateway
+ * @param[in] cb        callback
+ * @param[in] arg       argument of @p cb
+ *
+ * @return  number of concrete topics the filter matches on success
+ * @return  -EEXIST if the filter is already subscribed
+ * @return  -ENOMEM if a table or the name pool is full
+ * @return  -ENOENT if a wildcard filter matches no known topic
+ * @return  -EIO if the gateway refused a subscription
+ */
+int subreg_sub(const char *filter, unsigned flags, subreg_cb_t cb, void *arg);
+
+/**
+ * @brief   Remove a filter, topics no other filter needs are unsubscribed
+ *
+ * @return  0 on success
+ * @return  -ENOENT if the filter is not subscribed
+ */
+int subreg_unsub(const char *filter);
+
+/**
+ * @brief   Check a topic name against a filter with MQTT wildcards
+ */
+bool subreg_match(const char *filter, const char *topic);
+
+/**
+ * @brief   Print filters, topics and the use of the tables
+ */
+void subreg_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUBREG_H */
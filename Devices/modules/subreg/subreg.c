@@ -0,0 +1,356 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     subreg
+ * @{
+ *
+ * @file
+ * @brief       MQTT-SN subscription registry implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "kernel_defines.h"
+#include "net/emcute.h"
+
+#include "predefined_topics.h"
+#include "subreg.h"
+
+_Static_assert(SUBREG_FILTERS <= 32, "one bit per filter in a uint32_t");
+
+/* a topic subscribed at the gateway, its name in the pool is the one of
+ * sub.topic, NULL for an unused entry */
+typedef struct {
+    emcute_sub_t sub;       /* emcute hands back its topic, see _on_pub() */
+    uint32_t filters;       /* bit per filter to call */
+} topic_entry_t;
+
+typedef struct {
+    uint16_t name;          /* pool offset, 0 = unused entry */
+    subreg_cb_t cb;
+    void *arg;
+} filter_t;
+
+typedef struct {
+    const char *name;
+    uint16_t id;
+} predef_topic_t;
+
+static const predef_topic_t predef[] = PREDEF_TOPICS_INIT;
+
+static topic_entry_t topics[SUBREG_TOPICS];
+static filter_t filters[SUBREG_FILTERS];
+
+/* names one after the other, each as a reference count byte followed by
+ * the terminated string, offsets point at the string */
+static uint8_t pool[SUBREG_POOL_SIZE];
+static size_t pool_used;
+
+static const char *_str(uint16_t off)
+{
+    return (const char *)&pool[off];
+}
+
+static uint16_t _off(const char *str)
+{
+    return (uint16_t)((const uint8_t *)str - pool);
+}
+
+/* a name moved from one offset to another during compaction */
+static void _relocate(uint16_t from, uint16_t to)
+{
+    for (unsigned i = 0; i < SUBREG_TOPICS; i++) {
+        if (topics[i].sub.topic.name == _str(from)) {
+            topics[i].sub.topic.name = _str(to);
+        }
+    }
+    for (unsigned i = 0; i < SUBREG_FILTERS; i++) {
+        if (filters[i].name == from) {
+            filters[i].name = to;
+        }
+    }
+}
+
+/* squeeze out the names nobody refers to any more */
+static void _compact(void)
+{
+    size_t dst = 0;
+
+    for (size_t pos = 0; pos < pool_used;) {
+        size_t n = strlen((const char *)&pool[pos + 1]) + 2;
+        if (pool[pos] > 0) {
+            if (dst != pos) {
+                memmove(&pool[dst], &pool[pos], n);
+                _relocate(pos + 1, dst + 1);
+            }
+            dst += n;
+        }
+        pos += n;
+    }
+    pool_used = dst;
+}
+
+/* returns the offset of the name in the pool, shared if already there */
+static int _intern(const char *name)
+{
+    size_t len = strlen(name) + 1;
+
+    for (size_t pos = 0; pos < pool_used;
+         pos += strlen((const char *)&pool[pos + 1]) + 2) {
+        if ((pool[pos] > 0) && (pool[pos] < UINT8_MAX) &&
+            (strcmp((const char *)&pool[pos + 1], name) == 0)) {
+            pool[pos]++;
+            return pos + 1;
+        }
+    }
+
+    if (pool_used + 1 + len > sizeof(pool)) {
+        _compact();
+        if (pool_used + 1 + len > sizeof(pool)) {
+            return -ENOMEM;
+        }
+    }
+    pool[pool_used] = 1;
+    memcpy(&pool[pool_used + 1], name, len);
+    pool_used += 1 + len;
+    return pool_used - len;
+}
+
+static void _release(uint16_t off)
+{
+    pool[off - 1]--;
+}
+
+bool subreg_match(const char *filter, const char *topic)
+{
+    while (*filter) {
+        if (*filter == '#') {
+            /* matches the rest, including nothing at all */
+            return true;
+        }
+        if (*filter == '+') {
+            while (*topic && (*topic != '/')) {
+                topic++;
+            }
+            filter++;
+            continue;
+        }
+        if (*topic == '\0') {
+            /* "a/#" also matches "a" */
+            return (strcmp(filter, "/#") == 0);
+        }
+        if (*filter != *topic) {
+            return false;
+        }
+        filter++;
+        topic++;
+    }
+    return (*topic == '\0');
+}
+
+static void _on_pub(const emcute_topic_t *topic, void *data, size_t len)
+{
+    /* the topic belongs to one of our emcute_sub_t, no lookup needed */
+    topic_entry_t *t = (topic_entry_t *)container_of(topic, emcute_sub_t, topic);
+    uint32_t bits = t->filters;
+
+    while (bits) {
+        unsigned f = __builtin_ctz(bits);
+        bits &= bits - 1;
+        filters[f].cb(topic->name, data, len, filters[f].arg);
+    }
+}
+
+static int _find_filter(const char *filter)
+{
+    for (unsigned i = 0; i < SUBREG_FILTERS; i++) {
+        if (filters[i].name && (strcmp(_str(filters[i].name), filter) == 0)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static topic_entry_t *_find_topic(const char *name)
+{
+    for (unsigned i = 0; i < SUBREG_TOPICS; i++) {
+        if (topics[i].sub.topic.name &&
+            (strcmp(topics[i].sub.topic.name, name) == 0)) {
+            return &topics[i];
+        }
+    }
+    return NULL;
+}
+
+/* the concrete topic, subscribed at the gateway if it is new */
+static int _topic(const char *name, unsigned flags, topic_entry_t **out)
+{
+    topic_entry_t *t = _find_topic(name);
+
+    if (t) {
+        *out = t;
+        return 0;
+    }
+    for (unsigned i = 0; i < SUBREG_TOPICS; i++) {
+        if (topics[i].sub.topic.name == NULL) {
+            t = &topics[i];
+            break;
+        }
+    }
+    if (t == NULL) {
+        return -ENOMEM;
+    }
+    int off = _intern(name);
+    if (off < 0) {
+        return off;
+    }
+
+    memset(t, 0, sizeof(*t));
+    t->sub.cb = _on_pub;
+    t->sub.topic.name = _str(off);
+    if (emcute_sub(&t->sub, flags) != EMCUTE_OK) {
+        _release(off);
+        t->sub.topic.name = NULL;
+        return -EIO;
+    }
+
+    /* wildcard filters subscribed earlier want this topic as well */
+    for (unsigned i = 0; i < SUBREG_FILTERS; i++) {
+        if (filters[i].name && subreg_match(_str(filters[i].name), name)) {
+            t->filters |= (1UL << i);
+        }
+    }
+    *out = t;
+    return 0;
+}
+
+static void _drop_topic(topic_entry_t *t)
+{
+    /* emcute keeps the sub in its list unless the gateway confirmed, so the
+     * entry stays until a later unsub gets through */
+    if (emcute_unsub(&t->sub) != EMCUTE_OK) {
+        return;
+    }
+    _release(_off(t->sub.topic.name));
+    memset(t, 0, sizeof(*t));
+}
+
+int subreg_sub(const char *filter, unsigned flags, subreg_cb_t cb, void *arg)
+{
+    if (_find_filter(filter) >= 0) {
+        return -EEXIST;
+    }
+
+    unsigned f;
+    for (f = 0; (f < SUBREG_FILTERS) && filters[f].name; f++) {}
+    if (f == SUBREG_FILTERS) {
+        return -ENOMEM;
+    }
+    int off = _intern(filter);
+    if (off < 0) {
+        return off;
+    }
+    filters[f].name = off;
+    filters[f].cb = cb;
+    filters[f].arg = arg;
+    const char *name = _str(off);
+
+    int matched = 0;
+    int res = 0;
+    topic_entry_t *t;
+    if (strpbrk(filter, "+#") == NULL) {
+        res = _topic(name, flags, &t);
+        if (res == 0) {
+            t->filters |= (1UL << f);
+            matched++;
+        }
+    }
+    else {
+        /* the topics emcute can deliver: predefined and subscribed ones */
+        for (unsigned i = 0; i < ARRAY_SIZE(predef); i++) {
+            if (subreg_match(filter, predef[i].name)) {
+                res = _topic(predef[i].name, flags, &t);
+                if (res != 0) {
+                    break;
+                }
+                t->filters |= (1UL << f);
+                matched++;
+            }
+        }
+        for (unsigned i = 0; (res == 0) && (i < SUBREG_TOPICS); i++) {
+            if (topics[i].sub.topic.name &&
+                subreg_match(filter, topics[i].sub.topic.name)) {
+                if (!(topics[i].filters & (1UL << f))) {
+                    topics[i].filters |= (1UL << f);
+                    matched++;
+                }
+            }
+        }
+        if ((res == 0) && (matched == 0)) {
+            res = -ENOENT;
+        }
+    }
+
+    if (res != 0) {
+        subreg_unsub(filter);
+        return res;
+    }
+    return matched;
+}
+
+int subreg_unsub(const char *filter)
+{
+    int f = _find_filter(filter);
+
+    if (f < 0) {
+        return -ENOENT;
+    }
+    for (unsigned i = 0; i < SUBREG_TOPICS; i++) {
+        if (topics[i].sub.topic.name == NULL) {
+            continue;
+        }
+        topics[i].filters &= ~(1UL << f);
+        if (topics[i].filters == 0) {
+            _drop_topic(&topics[i]);
+        }
+    }
+    _release(filters[f].name);
+    memset(&filters[f], 0, sizeof(filters[f]));
+    return 0;
+}
+
+void subreg_print(void)
+{
+    unsigned numof_filters = 0;
+    unsigned numof_topics = 0;
+
+    for (unsigned f = 0; f < SUBREG_FILTERS; f++) {
+        if (filters[f].name == 0) {
+            continue;
+        }
+        numof_filters++;
+        printf("filter %s:", _str(filters[f].name));
+        for (unsigned i = 0; i < SUBREG_TOPICS; i++) {
+            if (topics[i].filters & (1UL << f)) {
+                printf(" %s [%u]", topics[i].sub.topic.name,
+                       (unsigned)topics[i].sub.topic.id);
+            }
+        }
+        puts("");
+    }
+    for (unsigned i = 0; i < SUBREG_TOPICS; i++) {
+        numof_topics += (topics[i].sub.topic.name != NULL);
+    }
+    printf("%u/%u filters, %u/%u topics, %u/%u bytes of names\n",
+           numof_filters, SUBREG_FILTERS, numof_topics, SUBREG_TOPICS,
+           (unsigned)pool_used, SUBREG_POOL_SIZE);
+}
@@ -0,0 +1,73 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sx127x_stub SX127x radio without a radio
+ * @{
+ *
+ * @file
+ * @brief       sx127x driver API that completes every transfer at once
+ *
+ * The semtech-loramac package drives the SX1276 through the functions of
+ * sx127x.h and the netdev driver `sx127x_driver`. This module provides both
+ * in place of the `sx1276` driver module, so the LoRaWAN send path runs on
+ * `native`: a frame handed to send() is done after
+ * @ref SX127X_STUB_TX_US, a receive window times out after
+ * @ref SX127X_STUB_RX_US, nothing is ever received and channels are always
+ * free. The IRQ of the radio is an xtimer callback, so the MAC sees the
+ * same ISR, TX_COMPLETE and RX_TIMEOUT events as on the board.
+ *
+ * It keeps when the last frame was handed over and how long it was, the
+ * PHY payload with the LoRaWAN header and MIC, for the benchmarks.
+ *
+ * @}
+ */
+
+#ifndef SX127X_STUB_H
+#define SX127X_STUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   usec from send() to TX_COMPLETE
+ */
+#ifndef SX127X_STUB_TX_US
+#define SX127X_STUB_TX_US   (1000U)
+#endif
+
+/**
+ * @brief   usec from the start of a receive window to RX_TIMEOUT
+ */
+#ifndef SX127X_STUB_RX_US
+#define SX127X_STUB_RX_US   (1000U)
+#endif
+
+/**
+ * @brief   xtimer_now_usec() when the last frame was handed to send()
+ */
+uint32_t sx127x_stub_sent_at(void);
+
+/**
+ * @brief   Length of the last frame, PHY payload in bytes
+ */
+size_t sx127x_stub_sent_len(void);
+
+/**
+ * @brief   Frames sent since boot
+ */
+unsigned sx127x_stub_sent(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SX127X_STUB_H */
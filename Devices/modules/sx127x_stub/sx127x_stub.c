@@ -0,0 +1,491 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sx127x_stub
+ * @{
+ *
+ * @file
+ * @brief       SX127x radio without a radio
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "xtimer.h"
+#include "net/netdev.h"
+
+#include "sx127x.h"
+#include "sx127x_internal.h"
+#include "sx127x_netdev.h"
+#include "sx127x_stub.h"
+
+/* what the MAC configured, only read back by the getters */
+static struct {
+    uint32_t channel;
+    uint32_t rx_timeout;
+    uint32_t tx_timeout;
+    uint16_t preamble_len;
+    uint16_t symbol_timeout;
+    uint8_t state;
+    uint8_t modem;
+    uint8_t bandwidth;
+    uint8_t sf;
+    uint8_t coderate;
+    uint8_t hop_period;
+    uint8_t payload_len;
+    uint8_t max_payload_len;
+    uint8_t syncword;
+    int8_t power;
+    bool crc;
+    bool fixed_len;
+    bool rx_single;
+    bool iq_invert;
+    bool freq_hop;
+} radio;
+
+/* the IRQ line: the event the next isr() reports, raised by the timer */
+static sx127x_t *irq_dev;
+static xtimer_t irq_timer;
+static netdev_event_t pending;
+
+static uint32_t sent_at;
+static size_t sent_len;
+static unsigned sent;
+static uint32_t seed;
+
+static void _irq(void *arg)
+{
+    sx127x_t *dev = arg;
+
+    if (dev->netdev.event_callback) {
+        dev->netdev.event_callback(&dev->netdev, NETDEV_EVENT_ISR);
+    }
+}
+
+static void _raise(sx127x_t *dev, netdev_event_t event, uint32_t us)
+{
+    xtimer_remove(&irq_timer);
+    irq_dev = dev;
+    pending = event;
+    irq_timer.callback = _irq;
+    irq_timer.arg = dev;
+    xtimer_set(&irq_timer, us);
+}
+
+static void _idle(sx127x_t *dev, uint8_t state)
+{
+    (void)dev;
+    /* a transfer that was cut short never reports */
+    xtimer_remove(&irq_timer);
+    radio.state = state;
+}
+
+uint32_t sx127x_stub_sent_at(void)
+{
+    return sent_at;
+}
+
+size_t sx127x_stub_sent_len(void)
+{
+    return sent_len;
+}
+
+unsigned sx127x_stub_sent(void)
+{
+    return sent;
+}
+
+void sx127x_setup(sx127x_t *dev, const sx127x_params_t *params, uint8_t index)
+{
+    (void)index;
+    dev->params = *params;
+}
+
+int sx127x_init(sx127x_t *dev)
+{
+    sx127x_init_radio_settings(dev);
+    seed = xtimer_now_usec() | 1;
+    return 0;
+}
+
+void sx127x_init_radio_settings(sx127x_t *dev)
+{
+    (void)dev;
+    memset(&radio, 0, sizeof(radio));
+    radio.state = SX127X_RF_IDLE;
+    radio.modem = SX127X_MODEM_LORA;
+    radio.max_payload_len = 0xff;
+    radio.syncword = LORA_SYNCWORD_PUBLIC;
+    radio.crc = true;
+}
+
+uint32_t sx127x_random(sx127x_t *dev)
+{
+    (void)dev;
+    /* xorshift32, good enough for nonces of a radio that sends nothing */
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+void sx127x_start_cad(sx127x_t *dev)
+{
+    _idle(dev, SX127X_RF_IDLE);
+}
+
+bool sx127x_is_channel_free(sx127x_t *dev, uint32_t freq, int16_t rssi_threshold)
+{
+    (void)rssi_threshold;
+    sx127x_set_channel(dev, freq);
+    return true;
+}
+
+void sx127x_set_rx(sx127x_t *dev)
+{
+    radio.state = SX127X_RF_RX_RUNNING;
+    _raise(dev, NETDEV_EVENT_RX_TIMEOUT, SX127X_STUB_RX_US);
+}
+
+void sx127x_set_tx(sx127x_t *dev)
+{
+    radio.state = SX127X_RF_TX_RUNNING;
+    _raise(dev, NETDEV_EVENT_TX_COMPLETE, SX127X_STUB_TX_US);
+}
+
+uint8_t sx127x_get_state(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.state;
+}
+
+void sx127x_set_state(sx127x_t *dev, uint8_t state)
+{
+    (void)dev;
+    radio.state = state;
+}
+
+void sx127x_set_modem(sx127x_t *dev, uint8_t modem)
+{
+    (void)dev;
+    radio.modem = modem;
+}
+
+uint8_t sx127x_get_syncword(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.syncword;
+}
+
+void sx127x_set_syncword(sx127x_t *dev, uint8_t syncword)
+{
+    (void)dev;
+    radio.syncword = syncword;
+}
+
+uint32_t sx127x_get_channel(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.channel;
+}
+
+void sx127x_set_channel(sx127x_t *dev, uint32_t freq)
+{
+    (void)dev;
+    radio.channel = freq;
+}
+
+uint32_t sx127x_get_time_on_air(const sx127x_t *dev, uint8_t pkt_len)
+{
+    (void)dev;
+    (void)pkt_len;
+    /* ms, as long as the stub takes */
+    return (SX127X_STUB_TX_US + US_PER_MS - 1) / US_PER_MS;
+}
+
+void sx127x_set_sleep(sx127x_t *dev)
+{
+    _idle(dev, SX127X_RF_IDLE);
+}
+
+void sx127x_set_standby(sx127x_t *dev)
+{
+    _idle(dev, SX127X_RF_IDLE);
+}
+
+void sx127x_set_rx_timeout(sx127x_t *dev, uint32_t timeout)
+{
+    (void)dev;
+    radio.rx_timeout = timeout;
+}
+
+void sx127x_set_tx_timeout(sx127x_t *dev, uint32_t timeout)
+{
+    (void)dev;
+    radio.tx_timeout = timeout;
+}
+
+uint8_t sx127x_get_bandwidth(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.bandwidth;
+}
+
+void sx127x_set_bandwidth(sx127x_t *dev, uint8_t bandwidth)
+{
+    (void)dev;
+    radio.bandwidth = bandwidth;
+}
+
+uint8_t sx127x_get_spreading_factor(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.sf;
+}
+
+void sx127x_set_spreading_factor(sx127x_t *dev, uint8_t sf)
+{
+    (void)dev;
+    radio.sf = sf;
+}
+
+uint8_t sx127x_get_coding_rate(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.coderate;
+}
+
+void sx127x_set_coding_rate(sx127x_t *dev, uint8_t coderate)
+{
+    (void)dev;
+    radio.coderate = coderate;
+}
+
+bool sx127x_get_rx_single(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.rx_single;
+}
+
+void sx127x_set_rx_single(sx127x_t *dev, bool single)
+{
+    (void)dev;
+    radio.rx_single = single;
+}
+
+bool sx127x_get_crc(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.crc;
+}
+
+void sx127x_set_crc(sx127x_t *dev, bool crc)
+{
+    (void)dev;
+    radio.crc = crc;
+}
+
+uint8_t sx127x_get_hop_period(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.hop_period;
+}
+
+void sx127x_set_hop_period(sx127x_t *dev, uint8_t hop_period)
+{
+    (void)dev;
+    radio.hop_period = hop_period;
+}
+
+bool sx127x_get_fixed_header_len_mode(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.fixed_len;
+}
+
+void sx127x_set_fixed_header_len_mode(sx127x_t *dev, bool fixed_len)
+{
+    (void)dev;
+    radio.fixed_len = fixed_len;
+}
+
+uint8_t sx127x_get_payload_length(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.payload_len;
+}
+
+void sx127x_set_payload_length(sx127x_t *dev, uint8_t len)
+{
+    (void)dev;
+    radio.payload_len = len;
+}
+
+uint8_t sx127x_get_tx_power(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.power;
+}
+
+void sx127x_set_tx_power(sx127x_t *dev, int8_t power)
+{
+    (void)dev;
+    radio.power = power;
+}
+
+uint16_t sx127x_get_preamble_length(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.preamble_len;
+}
+
+void sx127x_set_preamble_length(sx127x_t *dev, uint16_t preamble)
+{
+    (void)dev;
+    radio.preamble_len = preamble;
+}
+
+void sx127x_set_symbol_timeout(sx127x_t *dev, uint16_t timeout)
+{
+    (void)dev;
+    radio.symbol_timeout = timeout;
+}
+
+void sx127x_set_iq_invert(sx127x_t *dev, bool iq_invert)
+{
+    (void)dev;
+    radio.iq_invert = iq_invert;
+}
+
+void sx127x_set_freq_hop(sx127x_t *dev, bool freq_hop_on)
+{
+    (void)dev;
+    radio.freq_hop = freq_hop_on;
+}
+
+int16_t sx127x_read_rssi(sx127x_t *dev)
+{
+    (void)dev;
+    /* an empty channel */
+    return -120;
+}
+
+uint8_t sx127x_get_max_payload_len(const sx127x_t *dev)
+{
+    (void)dev;
+    return radio.max_payload_len;
+}
+
+void sx127x_set_max_payload_len(const sx127x_t *dev, uint8_t maxlen)
+{
+    (void)dev;
+    radio.max_payload_len = maxlen;
+}
+
+/* no registers behind it, the MAC only touches them for the sync word */
+void sx127x_reg_write(const sx127x_t *dev, uint8_t addr, uint8_t data)
+{
+    (void)dev;
+    (void)addr;
+    (void)data;
+}
+
+uint8_t sx127x_reg_read(const sx127x_t *dev, uint8_t addr)
+{
+    (void)dev;
+    (void)addr;
+    return 0;
+}
+
+void sx127x_reg_write_burst(const sx127x_t *dev, uint8_t addr, uint8_t *buffer,
+                            uint8_t size)
+{
+    (void)dev;
+    (void)addr;
+    (void)buffer;
+    (void)size;
+}
+
+void sx127x_reg_read_burst(const sx127x_t *dev, uint8_t addr, uint8_t *buffer,
+                           uint8_t size)
+{
+    (void)dev;
+    (void)addr;
+    memset(buffer, 0, size);
+}
+
+static int _send(netdev_t *netdev, const iolist_t *iolist)
+{
+    sx127x_t *dev = (sx127x_t *)netdev;
+    size_t len = iolist_size(iolist);
+
+    if (len > radio.max_payload_len) {
+        return -EOVERFLOW;
+    }
+    sent_at = xtimer_now_usec();
+    sent_len = len;
+    sent++;
+    sx127x_set_tx(dev);
+    return len;
+}
+
+static int _recv(netdev_t *netdev, void *buf, size_t len, void *info)
+{
+    (void)netdev;
+    (void)buf;
+    (void)len;
+    (void)info;
+    /* nothing was ever received */
+    return 0;
+}
+
+static int _init(netdev_t *netdev)
+{
+    return sx127x_init((sx127x_t *)netdev);
+}
+
+static void _isr(netdev_t *netdev)
+{
+    sx127x_t *dev = (sx127x_t *)netdev;
+
+    if ((dev != irq_dev) || !netdev->event_callback) {
+        return;
+    }
+    radio.state = SX127X_RF_IDLE;
+    netdev->event_callback(netdev, pending);
+}
+
+static int _get(netdev_t *netdev, netopt_t opt, void *val, size_t max_len)
+{
+    (void)netdev;
+    (void)opt;
+    (void)val;
+    (void)max_len;
+    return -ENOTSUP;
+}
+
+static int _set(netdev_t *netdev, netopt_t opt, const void *val, size_t len)
+{
+    (void)netdev;
+    (void)opt;
+    (void)val;
+    (void)len;
+    return -ENOTSUP;
+}
+
+const netdev_driver_t sx127x_driver = {
+    .send = _send,
+    .recv = _recv,
+    .init = _init,
+    .isr = _isr,
+    .get = _get,
+    .set = _set,
+};
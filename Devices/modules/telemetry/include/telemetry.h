@@ -0,0 +1,246 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    telemetry Telemetry records
+ * @{
+ *
+ * @file
+ * @brief       Environmental sample record and its compact binary encoding
+ *
+ * All values are kept in fixed point with two decimals (hundredths of the
+ * unit), so 12.30 °C is stored as 1230.
+ *
+ * Binary record, version 1, all multi-byte fields big endian:
+ *
+ *     0      version (TELEMETRY_BIN_VERSION)
+ *     1      device number
+ *     2..5   timestamp, seconds since the epoch
+ *     6      field mask, bit n set if field n is present
+ *     7..    one 16 bit value per present field, in field order; signed for
+ *            fields that can be negative, unsigned otherwise
+ *
+ * The first byte never equals '{', so a receiver can tell binary records
+ * and JSON payloads apart. The host side decoder lives in
+ * Gateway/telemetry.js and has to be kept in sync with this file.
+ *
+ * A batch is sent as the records one after the other in binary, or as a
+ * Thingsboard array of {ts, values} objects in JSON.
+ *
+ * Delta record, version 2, a whole batch of one device stored by column:
+ *
+ *     0      version (TELEMETRY_DELTA_VERSION)
+ *     1      device number
+ *     2      number of samples
+ *     3      field mask, the same for all samples
+ *     4..    timestamp column, then one column per present field, each
+ *            encoded with delta_encode()
+ *
+ * @}
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "delta_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Version of the binary record format
+ */
+#define TELEMETRY_BIN_VERSION       (1U)
+
+/**
+ * @brief   Version of the delta record format
+ */
+#define TELEMETRY_DELTA_VERSION     (2U)
+
+/**
+ * @brief   Length of the delta record header
+ */
+#define TELEMETRY_DELTA_HDR_LEN     (4U)
+
+/**
+ * @brief   Length of the binary record header
+ */
+#define TELEMETRY_BIN_HDR_LEN       (7U)
+
+/**
+ * @brief   Fields of a sample, the order is part of the binary format
+ */
+typedef enum {
+    TELEMETRY_TEMPERATURE,      /**< °C, signed */
+    TELEMETRY_HUMIDITY,         /**< % */
+    TELEMETRY_WIND_DIRECTION,   /**< ° */
+    TELEMETRY_WIND_INTENSITY,   /**< m/s */
+    TELEMETRY_RAIN_HEIGHT,      /**< mm/h */
+    TELEMETRY_FIELD_NUMOF
+} telemetry_field_t;
+
+/**
+ * @brief   Maximum length of a binary record
+ */
+#define TELEMETRY_BIN_MAXLEN        (TELEMETRY_BIN_HDR_LEN + \
+                                     (2 * TELEMETRY_FIELD_NUMOF))
+
+/**
+ * @brief   Maximum number of bytes a sample adds to a delta record
+ */
+#define TELEMETRY_DELTA_SAMPLE_MAXLEN   (DELTA_VARINT_MAXLEN * \
+                                         (1 + TELEMETRY_FIELD_NUMOF))
+
+/**
+ * @brief   Maximum length of a sample encoded as JSON, including the
+ *          terminator
+ */
+#define TELEMETRY_JSON_MAXLEN       (200U)
+
+/**
+ * @brief   Maximum number of samples in a batch
+ */
+#ifndef TELEMETRY_BATCH_MAX
+#define TELEMETRY_BATCH_MAX         (16U)
+#endif
+
+/**
+ * @brief   One sample of a device
+ */
+typedef struct {
+    uint32_t ts;                            /**< seconds since the epoch */
+    uint8_t device;                         /**< device number */
+    uint8_t mask;                           /**< present fields */
+    int32_t value[TELEMETRY_FIELD_NUMOF];   /**< hundredths of the unit */
+} telemetry_sample_t;
+
+/**
+ * @brief   Start a new sample without any field
+ */
+void telemetry_sample_init(telemetry_sample_t *s, uint8_t device, uint32_t ts);
+
+/**
+ * @brief   Set one field of a sample
+ *
+ * @param[in] s         sample
+ * @param[in] field     field to set
+ * @param[in] value     value in hundredths of the unit
+ */
+void telemetry_sample_set(telemetry_sample_t *s, telemetry_field_t field,
+                          int32_t value);
+
+/**
+ * @brief   Name of a field, as used in the Thingsboard JSON
+ */
+const char *telemetry_field_name(telemetry_field_t field);
+
+/**
+ * @brief   Whether a field can be negative
+ */
+bool telemetry_field_signed(telemetry_field_t field);
+
+/**
+ * @brief   Encode a sample as binary record
+ *
+ * Values that do not fit into 16 bit are saturated.
+ *
+ * @return  length of the record
+ * @return  -EOVERFLOW if @p len is too small
+ */
+int telemetry_bin_encode(uint8_t *buf, size_t len, const telemetry_sample_t *s);
+
+/**
+ * @brief   Decode one binary record
+ *
+ * @return  number of bytes consumed from @p buf
+ * @return  -EBADMSG if the record is truncated or has an unknown version
+ */
+int telemetry_bin_decode(telemetry_sample_t *s, const uint8_t *buf, size_t len);
+
+/**
+ * @brief   Samples waiting to be sent in one message
+ */
+typedef struct {
+    telemetry_sample_t sample[TELEMETRY_BATCH_MAX]; /**< queued samples */
+    unsigned numof;                                 /**< number of samples */
+} telemetry_batch_t;
+
+/**
+ * @brief   Encode a sample as Thingsboard JSON
+ *
+ * The output is the same the clients built with sprintf before, values are
+ * strings with two decimals and the timestamp is in milliseconds.
+ *
+ * @return  length of the string, without the terminator
+ * @return  -EOVERFLOW if @p len is too small
+ */
+int telemetry_json_encode(char *buf, size_t len, const telemetry_sample_t *s);
+
+/**
+ * @brief   Empty a batch
+ */
+void telemetry_batch_clear(telemetry_batch_t *b);
+
+/**
+ * @brief   Append a copy of @p s to a batch
+ *
+ * @return  number of samples in the batch
+ * @return  -ENOBUFS if the batch is full
+ */
+int telemetry_batch_add(telemetry_batch_t *b, const telemetry_sample_t *s);
+
+/**
+ * @brief   Encode a batch as one binary record per sample
+ *
+ * @return  length of the encoded batch
+ * @return  -EOVERFLOW if @p len is too small
+ */
+int telemetry_batch_bin_encode(uint8_t *buf, size_t len,
+                               const telemetry_batch_t *b);
+
+/**
+ * @brief   Encode a batch as Thingsboard JSON array
+ *
+ * A batch of one sample is encoded as plain object, like
+ * telemetry_json_encode() does.
+ *
+ * @return  length of the string, without the terminator
+ * @return  -EOVERFLOW if @p len is too small
+ */
+int telemetry_batch_json_encode(char *buf, size_t len,
+                                const telemetry_batch_t *b);
+
+/**
+ * @brief   Encode a batch as one delta record
+ *
+ * @return  length of the record
+ * @return  -EINVAL if the samples differ in device or fields
+ * @return  -EOVERFLOW if @p len is too small
+ */
+int telemetry_batch_delta_encode(uint8_t *buf, size_t len,
+                                 const telemetry_batch_t *b);
+
+/**
+ * @brief   Decode one delta record into @p b
+ *
+ * @return  number of bytes consumed from @p buf
+ * @return  -EBADMSG if the record is truncated, has an unknown version or
+ *          more samples than a batch holds
+ */
+int telemetry_batch_delta_decode(telemetry_batch_t *b, const uint8_t *buf,
+                                 size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,327 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     telemetry
+ * @{
+ *
+ * @file
+ * @brief       Telemetry record encoding
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fixp.h"
+#include "telemetry.h"
+
+static const char *const names[TELEMETRY_FIELD_NUMOF] = {
+    [TELEMETRY_TEMPERATURE]     = "temperature",
+    [TELEMETRY_HUMIDITY]        = "humidity",
+    [TELEMETRY_WIND_DIRECTION]  = "windDirection",
+    [TELEMETRY_WIND_INTENSITY]  = "windIntensity",
+    [TELEMETRY_RAIN_HEIGHT]     = "rainHeight",
+};
+
+void telemetry_sample_init(telemetry_sample_t *s, uint8_t device, uint32_t ts)
+{
+    memset(s, 0, sizeof(*s));
+    s->device = device;
+    s->ts = ts;
+}
+
+void telemetry_sample_set(telemetry_sample_t *s, telemetry_field_t field,
+                          int32_t value)
+{
+    s->value[field] = value;
+    s->mask |= (1U << field);
+}
+
+const char *telemetry_field_name(telemetry_field_t field)
+{
+    return names[field];
+}
+
+bool telemetry_field_signed(telemetry_field_t field)
+{
+    return (field == TELEMETRY_TEMPERATURE);
+}
+
+static uint16_t _to_wire(telemetry_field_t field, int32_t value)
+{
+    int32_t min = telemetry_field_signed(field) ? INT16_MIN : 0;
+    int32_t max = telemetry_field_signed(field) ? INT16_MAX : UINT16_MAX;
+
+    if (value < min) {
+        value = min;
+    }
+    else if (value > max) {
+        value = max;
+    }
+    return (uint16_t)value;
+}
+
+static int32_t _from_wire(telemetry_field_t field, uint16_t raw)
+{
+    return telemetry_field_signed(field) ? (int16_t)raw : raw;
+}
+
+int telemetry_bin_encode(uint8_t *buf, size_t len, const telemetry_sample_t *s)
+{
+    size_t pos = TELEMETRY_BIN_HDR_LEN;
+
+    if (len < TELEMETRY_BIN_HDR_LEN) {
+        return -EOVERFLOW;
+    }
+
+    buf[0] = TELEMETRY_BIN_VERSION;
+    buf[1] = s->device;
+    buf[2] = (uint8_t)(s->ts >> 24);
+    buf[3] = (uint8_t)(s->ts >> 16);
+    buf[4] = (uint8_t)(s->ts >> 8);
+    buf[5] = (uint8_t)s->ts;
+    buf[6] = s->mask;
+
+    for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+        if (!(s->mask & (1U << f))) {
+            continue;
+        }
+        if (pos + 2 > len) {
+            return -EOVERFLOW;
+        }
+        uint16_t raw = _to_wire(f, s->value[f]);
+        buf[pos++] = (uint8_t)(raw >> 8);
+        buf[pos++] = (uint8_t)raw;
+    }
+
+    return (int)pos;
+}
+
+int telemetry_bin_decode(telemetry_sample_t *s, const uint8_t *buf, size_t len)
+{
+    size_t pos = TELEMETRY_BIN_HDR_LEN;
+
+    if ((len < TELEMETRY_BIN_HDR_LEN) || (buf[0] != TELEMETRY_BIN_VERSION)) {
+        return -EBADMSG;
+    }
+    /* fields unknown to this side can not be skipped */
+    if (buf[6] >> TELEMETRY_FIELD_NUMOF) {
+        return -EBADMSG;
+    }
+
+    telemetry_sample_init(s, buf[1], ((uint32_t)buf[2] << 24) |
+                                     ((uint32_t)buf[3] << 16) |
+                                     ((uint32_t)buf[4] << 8) | buf[5]);
+
+    for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+        if (!(buf[6] & (1U << f))) {
+            continue;
+        }
+        if (pos + 2 > len) {
+            return -EBADMSG;
+        }
+        telemetry_sample_set(s, f, _from_wire(f, ((uint16_t)buf[pos] << 8) |
+                                                 buf[pos + 1]));
+        pos += 2;
+    }
+
+    return (int)pos;
+}
+
+/* appends to buf like snprintf, keeping track of the overflow in *pos */
+static void _append(char *buf, size_t len, size_t *pos, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void _append(char *buf, size_t len, size_t *pos, const char *fmt, ...)
+{
+    va_list args;
+    int res;
+
+    va_start(args, fmt);
+    res = vsnprintf(buf + ((*pos < len) ? *pos : len),
+                    (*pos < len) ? len - *pos : 0, fmt, args);
+    va_end(args);
+    *pos += (res > 0) ? (size_t)res : 0;
+}
+
+int telemetry_json_encode(char *buf, size_t len, const telemetry_sample_t *s)
+{
+    size_t pos = 0;
+    const char *sep = ",";
+
+    _append(buf, len, &pos, "{\"ts\": %llu, \"values\":{\"device\": \"%u\"",
+            (unsigned long long)s->ts * 1000, (unsigned)s->device);
+    for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+        if (!(s->mask & (1U << f))) {
+            continue;
+        }
+        char value[FIXP_FMT_MAXLEN];
+        fixp_to_str(value, s->value[f], 2);
+        _append(buf, len, &pos, "%s\"%s\": \"%s\"", sep, names[f], value);
+        sep = ", ";
+    }
+    _append(buf, len, &pos, "}}");
+
+    return (pos < len) ? (int)pos : -EOVERFLOW;
+}
+
+void telemetry_batch_clear(telemetry_batch_t *b)
+{
+    b->numof = 0;
+}
+
+int telemetry_batch_add(telemetry_batch_t *b, const telemetry_sample_t *s)
+{
+    if (b->numof >= TELEMETRY_BATCH_MAX) {
+        return -ENOBUFS;
+    }
+    b->sample[b->numof++] = *s;
+    return (int)b->numof;
+}
+
+int telemetry_batch_bin_encode(uint8_t *buf, size_t len,
+                               const telemetry_batch_t *b)
+{
+    size_t pos = 0;
+
+    for (unsigned i = 0; i < b->numof; i++) {
+        int res = telemetry_bin_encode(buf + pos, len - pos, &b->sample[i]);
+        if (res < 0) {
+            return res;
+        }
+        pos += res;
+    }
+    return (int)pos;
+}
+
+int telemetry_batch_json_encode(char *buf, size_t len,
+                                const telemetry_batch_t *b)
+{
+    size_t pos = 0;
+    bool array = (b->numof != 1);
+
+    if (array) {
+        if (len < 2) {
+            return -EOVERFLOW;
+        }
+        buf[pos++] = '[';
+    }
+    for (unsigned i = 0; i < b->numof; i++) {
+        if (i > 0) {
+            if (pos + 1 >= len) {
+                return -EOVERFLOW;
+            }
+            buf[pos++] = ',';
+        }
+        int res = telemetry_json_encode(buf + pos, len - pos, &b->sample[i]);
+        if (res < 0) {
+            return res;
+        }
+        pos += res;
+    }
+    if (array) {
+        if (pos + 1 >= len) {
+            return -EOVERFLOW;
+        }
+        buf[pos++] = ']';
+        buf[pos] = '\0';
+    }
+    return (int)pos;
+}
+
+int telemetry_batch_delta_encode(uint8_t *buf, size_t len,
+                                 const telemetry_batch_t *b)
+{
+    int32_t column[TELEMETRY_BATCH_MAX];
+    size_t pos = TELEMETRY_DELTA_HDR_LEN;
+    int res;
+
+    if ((b->numof == 0) || (len < TELEMETRY_DELTA_HDR_LEN)) {
+        return (b->numof == 0) ? -EINVAL : -EOVERFLOW;
+    }
+    for (unsigned i = 1; i < b->numof; i++) {
+        if ((b->sample[i].device != b->sample[0].device) ||
+            (b->sample[i].mask != b->sample[0].mask)) {
+            return -EINVAL;
+        }
+    }
+
+    buf[0] = TELEMETRY_DELTA_VERSION;
+    buf[1] = b->sample[0].device;
+    buf[2] = (uint8_t)b->numof;
+    buf[3] = b->sample[0].mask;
+
+    for (unsigned i = 0; i < b->numof; i++) {
+        column[i] = (int32_t)b->sample[i].ts;
+    }
+    res = delta_encode(buf + pos, len - pos, column, b->numof);
+    if (res < 0) {
+        return res;
+    }
+    pos += res;
+
+    for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+        if (!(buf[3] & (1U << f))) {
+            continue;
+        }
+        for (unsigned i = 0; i < b->numof; i++) {
+            column[i] = b->sample[i].value[f];
+        }
+        res = delta_encode(buf + pos, len - pos, column, b->numof);
+        if (res < 0) {
+            return res;
+        }
+        pos += res;
+    }
+
+    return (int)pos;
+}
+
+int telemetry_batch_delta_decode(telemetry_batch_t *b, const uint8_t *buf,
+                                 size_t len)
+{
+    int32_t column[TELEMETRY_BATCH_MAX];
+    size_t pos = TELEMETRY_DELTA_HDR_LEN;
+    int res;
+
+    if ((len < TELEMETRY_DELTA_HDR_LEN) ||
+        (buf[0] != TELEMETRY_DELTA_VERSION) ||
+        (buf[2] > TELEMETRY_BATCH_MAX) ||
+        (buf[3] >> TELEMETRY_FIELD_NUMOF)) {
+        return -EBADMSG;
+    }
+
+    b->numof = buf[2];
+    res = delta_decode(column, b->numof, buf + pos, len - pos);
+    if (res < 0) {
+        return res;
+    }
+    pos += res;
+    for (unsigned i = 0; i < b->numof; i++) {
+        telemetry_sample_init(&b->sample[i], buf[1], (uint32_t)column[i]);
+    }
+
+    for (unsigned f = 0; f < TELEMETRY_FIELD_NUMOF; f++) {
+        if (!(buf[3] & (1U << f))) {
+            continue;
+        }
+        res = delta_decode(column, b->numof, buf + pos, len - pos);
+        if (res < 0) {
+            return res;
+        }
+        pos += res;
+        for (unsigned i = 0; i < b->numof; i++) {
+            telemetry_sample_set(&b->sample[i], f, column[i]);
+        }
+    }
+
+    return (int)pos;
+}
@@ -0,0 +1,22 @@
+/*
+ * Generated by Gateway/gen_topics.sh from Gateway/predefined_topics.csv,
+ * do not edit.
+ */
+
+#ifndef PREDEFINED_TOPICS_H
+#define PREDEFINED_TOPICS_H
+
+#define PREDEF_TOPIC_TELEMETRY_ID (1U)
+#define PREDEF_TOPIC_TELEMETRY "v1/devices/me/telemetry"
+#define PREDEF_TOPIC_ATTRIBUTES_ID (2U)
+#define PREDEF_TOPIC_ATTRIBUTES "v1/devices/me/attributes"
+#define PREDEF_TOPIC_TELEMETRY_BIN_ID (3U)
+#define PREDEF_TOPIC_TELEMETRY_BIN "riot/telemetry/bin"
+
+#define PREDEF_TOPICS_INIT { \
+    { PREDEF_TOPIC_TELEMETRY, PREDEF_TOPIC_TELEMETRY_ID }, \
+    { PREDEF_TOPIC_ATTRIBUTES, PREDEF_TOPIC_ATTRIBUTES_ID }, \
+    { PREDEF_TOPIC_TELEMETRY_BIN, PREDEF_TOPIC_TELEMETRY_BIN_ID }, \
+}
+
+#endif /* PREDEFINED_TOPICS_H */
@@ -0,0 +1,92 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    topic_cache MQTT-SN topic ID cache
+ * @{
+ *
+ * @file
+ * @brief       Resolves topic names to MQTT-SN topic IDs without a REGISTER
+ *              round trip for every publish
+ *
+ * Topics listed in Gateway/predefined_topics.csv are mapped to their
+ * predefined ID and never registered. Any other topic is registered once per
+ * connection and the ID is kept until topic_cache_invalidate() is called,
+ * which has to happen whenever the client (re)connects to a gateway.
+ *
+ * @}
+ */
+
+#ifndef TOPIC_CACHE_H
+#define TOPIC_CACHE_H
+
+#include <stdint.h>
+
+#include "net/emcute.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Use the predefined topic IDs, the gateway needs PredefinedTopic=YES
+ */
+#ifndef TOPIC_CACHE_PREDEF
+#define TOPIC_CACHE_PREDEF          (1)
+#endif
+
+/**
+ * @brief   Number of registered (non predefined) topics kept per connection
+ */
+#ifndef TOPIC_CACHE_SIZE
+#define TOPIC_CACHE_SIZE            (4U)
+#endif
+
+/**
+ * @brief   Maximum length of a cached topic name, including the terminator
+ */
+#ifndef TOPIC_CACHE_NAME_MAXLEN
+#define TOPIC_CACHE_NAME_MAXLEN     (64U)
+#endif
+
+/**
+ * @brief   Counters of the topic cache
+ */
+typedef struct {
+    uint32_t predef;        /**< lookups answered by the predefined table */
+    uint32_t hits;          /**< lookups answered by the cache */
+    uint32_t registrations; /**< REGISTER round trips sent to the gateway */
+} topic_cache_stats_t;
+
+/**
+ * @brief   Get the topic ID for @p name, registering it if needed
+ *
+ * @param[out] topic    topic to fill, topic->name is set to @p name
+ * @param[out] flags    topic ID type is OR-ed in (EMCUTE_TIT_PREDEF for
+ *                      predefined topics), pass the result to emcute_pub()
+ * @param[in]  name     topic name, must stay valid as long as @p topic is used
+ *
+ * @return  EMCUTE_OK on success
+ * @return  the emcute_reg() error code if the registration failed
+ */
+int topic_cache_get(emcute_topic_t *topic, unsigned *flags, const char *name);
+
+/**
+ * @brief   Forget all registered topic IDs, call on every (re)connect
+ */
+void topic_cache_invalidate(void);
+
+/**
+ * @brief   Get a copy of the cache counters
+ */
+void topic_cache_get_stats(topic_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPIC_CACHE_H */
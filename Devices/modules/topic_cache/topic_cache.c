@@ -0,0 +1,124 @@
+/*
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     topic_cache
+ * @{
+ *
+ * @file
+ * @brief       MQTT-SN topic ID cache implementation
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "mutex.h"
+#include "topic_cache.h"
+#include "predefined_topics.h"
+#ifdef MODULE_PUBSTATS
+#include "pubstats.h"
+#include "xtimer.h"
+#endif
+
+typedef struct {
+    const char *name;
+    uint16_t id;
+} predef_topic_t;
+
+typedef struct {
+    char name[TOPIC_CACHE_NAME_MAXLEN];
+    uint16_t id;
+} cache_entry_t;
+
+static const predef_topic_t predef[] = PREDEF_TOPICS_INIT;
+
+static cache_entry_t cache[TOPIC_CACHE_SIZE];
+static unsigned next_victim;
+static topic_cache_stats_t stats;
+static mutex_t lock = MUTEX_INIT;
+
+static int _lookup_predef(const char *name)
+{
+    for (unsigned i = 0; i < (sizeof(predef) / sizeof(predef[0])); i++) {
+        if (strcmp(predef[i].name, name) == 0) {
+            return predef[i].id;
+        }
+    }
+    return -1;
+}
+
+static cache_entry_t *_lookup(const char *name)
+{
+    for (unsigned i = 0; i < TOPIC_CACHE_SIZE; i++) {
+        if ((cache[i].id != 0) && (strcmp(cache[i].name, name) == 0)) {
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+int topic_cache_get(emcute_topic_t *topic, unsigned *flags, const char *name)
+{
+    topic->name = name;
+
+    if (TOPIC_CACHE_PREDEF) {
+        int id = _lookup_predef(name);
+        if (id > 0) {
+            topic->id = (uint16_t)id;
+            *flags = (*flags & ~EMCUTE_TIT_MASK) | EMCUTE_TIT_PREDEF;
+            mutex_lock(&lock);
+            stats.predef++;
+            mutex_unlock(&lock);
+            return EMCUTE_OK;
+        }
+    }
+
+    /* the lock also keeps two threads from registering the same topic */
+    mutex_lock(&lock);
+    cache_entry_t *entry = _lookup(name);
+    if (entry) {
+        topic->id = entry->id;
+        stats.hits++;
+        mutex_unlock(&lock);
+        return EMCUTE_OK;
+    }
+
+#ifdef MODULE_PUBSTATS
+    uint32_t start = xtimer_now_usec();
+#endif
+    int res = emcute_reg(topic);
+    stats.registrations++;
+#ifdef MODULE_PUBSTATS
+    pubstats_record(PUBSTATS_REGISTER, name, 0, xtimer_now_usec() - start, res);
+#endif
+    if ((res == EMCUTE_OK) && (strlen(name) < TOPIC_CACHE_NAME_MAXLEN)) {
+        /* round robin replacement, the cache only holds a few topics */
+        entry = &cache[next_victim];
+        next_victim = (next_victim + 1) % TOPIC_CACHE_SIZE;
+        strcpy(entry->name, name);
+        entry->id = topic->id;
+    }
+    mutex_unlock(&lock);
+
+    return res;
+}
+
+void topic_cache_invalidate(void)
+{
+    mutex_lock(&lock);
+    memset(cache, 0, sizeof(cache));
+    next_victim = 0;
+    mutex_unlock(&lock);
+}
+
+void topic_cache_get_stats(topic_cache_stats_t *out)
+{
+    mutex_lock(&lock);
+    *out = stats;
+    mutex_unlock(&lock);
+}
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Generates the gateway PredefinedTopicList file and the C header used by the
+# RIOT clients from the single table in predefined_topics.csv, so that both
+# sides always agree on the topic IDs.
+#
+
+cd "$(dirname "$0")" || exit 1
+
+TABLE=predefined_topics.csv
+CONF=predefinedTopic.conf
+HEADER=../Devices/modules/topic_cache/include/predefined_topics.h
+
+# gateway side: "ClientId, TopicName, TopicId", '*' applies to every client
+awk -F '[ \t]*,[ \t]*' '
+BEGIN {
+    print "#"
+    print "# Generated by gen_topics.sh from predefined_topics.csv, do not edit."
+    print "#"
+    print "# ClientId, TopicName, TopicId"
+    print "#"
+}
+/^[ \t]*(#|$)/ { next }
+{ printf "*, %s, %d\n", $3, $1 }
+' "$TABLE" > "$CONF" || exit 1
+
+# client side: one define per topic plus the lookup table
+awk -F '[ \t]*,[ \t]*' '
+BEGIN {
+    print "/*"
+    print " * Generated by Gateway/gen_topics.sh from Gateway/predefined_topics.csv,"
+    print " * do not edit."
+    print " */"
+    print ""
+    print "#ifndef PREDEFINED_TOPICS_H"
+    print "#define PREDEFINED_TOPICS_H"
+    print ""
+}
+/^[ \t]*(#|$)/ { next }
+{
+    n++
+    id[n] = $1; sym[n] = $2; name[n] = $3
+    printf "#define PREDEF_TOPIC_%s_ID (%dU)\n", $2, $1
+    printf "#define PREDEF_TOPIC_%s \"%s\"\n", $2, $3
+}
+END {
+    print ""
+    print "#define PREDEF_TOPICS_INIT { \\"
+    for (i = 1; i <= n; i++) {
+        printf "    { PREDEF_TOPIC_%s, PREDEF_TOPIC_%s_ID }, \\\n", sym[i], sym[i]
+    }
+    print "}"
+    print ""
+    print "#endif /* PREDEFINED_TOPICS_H */"
+}
+' "$TABLE" > "$HEADER" || exit 1
+
+echo "generated $CONF and $HEADER"
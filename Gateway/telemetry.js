@@ -0,0 +1,146 @@
+// Host side decoder of the binary telemetry records sent by the RIOT clients.
+// Keep in sync with Devices/modules/telemetry/include/telemetry.h and
+// Devices/modules/delta_codec/include/delta_codec.h
+
+const BIN_VERSION = 1;
+const BIN_HDR_LEN = 7;
+const DELTA_VERSION = 2;
+const DELTA_HDR_LEN = 4;
+const VARINT_MAXLEN = 5;
+
+// Fields in wire order, signed fields can be negative
+const FIELDS = [
+    { name: 'temperature', signed: true },
+    { name: 'humidity', signed: false },
+    { name: 'windDirection', signed: false },
+    { name: 'windIntensity', signed: false },
+    { name: 'rainHeight', signed: false },
+];
+
+// Values are sent in hundredths, Thingsboard gets strings with two decimals
+function fixed(value) {
+    return (value / 100).toFixed(2);
+}
+
+// Decodes one version 1 record starting at offset, returns the Thingsboard
+// telemetry object and the number of bytes used
+function decodeRecord(buf, offset) {
+    var pos = offset + BIN_HDR_LEN;
+
+    if (buf.length - offset < BIN_HDR_LEN || buf[offset] !== BIN_VERSION) {
+        throw new Error('not a telemetry record');
+    }
+    var mask = buf[offset + 6];
+    if (mask >> FIELDS.length) {
+        throw new Error('unknown fields in mask 0x' + mask.toString(16));
+    }
+
+    // values are strings with two decimals, exactly like the JSON the
+    // clients send themselves
+    var values = { device: String(buf[offset + 1]) };
+    FIELDS.forEach(function (field, i) {
+        if (!(mask & (1 << i))) {
+            return;
+        }
+        if (pos + 2 > buf.length) {
+            throw new Error('truncated record');
+        }
+        var raw = field.signed ? buf.readInt16BE(pos) : buf.readUInt16BE(pos);
+        values[field.name] = fixed(raw);
+        pos += 2;
+    });
+
+    return {
+        telemetry: { ts: buf.readUInt32BE(offset + 2) * 1000, values: values },
+        length: pos - offset,
+    };
+}
+
+// Reads one varint column of n values: zigzag encoded differences to the
+// previous value, modulo 2^32
+function decodeColumn(buf, pos, n) {
+    var values = [];
+    var prev = 0;
+
+    for (var i = 0; i < n; i++) {
+        var raw = 0;
+        var len = 0;
+        var byte;
+        do {
+            if (pos + len >= buf.length || len >= VARINT_MAXLEN) {
+                throw new Error('truncated column');
+            }
+            byte = buf[pos + len];
+            // the fifth byte only holds bits 28 to 31
+            if (len === VARINT_MAXLEN - 1 && (byte & 0xf0)) {
+                throw new Error('varint longer than 32 bit');
+            }
+            raw += (byte & 0x7f) * Math.pow(2, 7 * len);
+            len++;
+        } while (byte & 0x80);
+        pos += len;
+        raw = raw >>> 0;
+        var diff = (raw >>> 1) ^ -(raw & 1);
+        prev = (prev + diff) | 0;
+        values.push(prev);
+    }
+    return { values: values, pos: pos };
+}
+
+// Decodes one version 2 record, a batch stored column by column
+function decodeDelta(buf, offset) {
+    if (buf.length - offset < DELTA_HDR_LEN || buf[offset] !== DELTA_VERSION) {
+        throw new Error('not a delta record');
+    }
+    var device = String(buf[offset + 1]);
+    var n = buf[offset + 2];
+    var mask = buf[offset + 3];
+    if (mask >> FIELDS.length) {
+        throw new Error('unknown fields in mask 0x' + mask.toString(16));
+    }
+
+    var col = decodeColumn(buf, offset + DELTA_HDR_LEN, n);
+    var res = col.values.map(function (ts) {
+        return { ts: (ts >>> 0) * 1000, values: { device: device } };
+    });
+    var pos = col.pos;
+    FIELDS.forEach(function (field, i) {
+        if (!(mask & (1 << i))) {
+            return;
+        }
+        col = decodeColumn(buf, pos, n);
+        col.values.forEach(function (v, j) {
+            res[j].values[field.name] = fixed(v);
+        });
+        pos = col.pos;
+    });
+
+    return { telemetry: res, length: pos - offset };
+}
+
+// Decodes a payload into a list of Thingsboard telemetry objects
+function decode(buf) {
+    var res = [];
+    var offset = 0;
+
+    while (offset < buf.length) {
+        var rec;
+        if (buf[offset] === DELTA_VERSION) {
+            rec = decodeDelta(buf, offset);
+            res = res.concat(rec.telemetry);
+        }
+        else {
+            rec = decodeRecord(buf, offset);
+            res.push(rec.telemetry);
+        }
+        offset += rec.length;
+    }
+    return res;
+}
+
+// Binary payloads never start with '{' or '['
+function isBinary(buf) {
+    return buf.length > 0 && buf[0] !== 0x7b && buf[0] !== 0x5b;
+}
+
+module.exports = { FIELDS: FIELDS, decode: decode, isBinary: isBinary };
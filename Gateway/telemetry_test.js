@@ -0,0 +1,79 @@
+// Decodes the records of Devices/RIOT_OS_Tests/tests-telemetry.c, the bytes
+// telemetry_bin_encode() and telemetry_batch_delta_encode() produce, and
+// checks the telemetry Thingsboard gets. Keep both files in sync.
+//
+//     node telemetry_test.js
+
+var assert = require('assert');
+var telemetry = require('./telemetry');
+
+var tests = [
+    {
+        name: 'binary record',
+        bytes: [0x01, 0x01, 0x65, 0x53, 0xf1, 0x00, 0x03, 0xfb, 0x2e, 0x16,
+                0x2e],
+        // the same object the client sends in JSON
+        telemetry: [
+            { ts: 1700000000000,
+              values: { device: '1', temperature: '-12.34',
+                        humidity: '56.78' } },
+        ],
+    },
+    {
+        name: 'saturated binary record',
+        bytes: [0x01, 0x02, 0x00, 0x00, 0x00, 0x01, 0x11, 0x80, 0x00, 0xff,
+                0xff],
+        telemetry: [
+            { ts: 1000,
+              values: { device: '2', temperature: '-327.68',
+                        rainHeight: '655.35' } },
+        ],
+    },
+    {
+        name: 'delta record',
+        bytes: [0x02, 0x03, 0x04, 0x01, 0x80, 0xc4, 0x9f, 0xd5, 0x0c, 0x78,
+                0x78, 0x78, 0xcc, 0x21, 0x01, 0xd3, 0x21, 0x00],
+        telemetry: [
+            { ts: 1700000000000, values: { device: '3', temperature: '21.50' } },
+            { ts: 1700000060000, values: { device: '3', temperature: '21.49' } },
+            { ts: 1700000120000, values: { device: '3', temperature: '-0.05' } },
+            { ts: 1700000180000, values: { device: '3', temperature: '-0.05' } },
+        ],
+    },
+];
+
+var failed = 0;
+
+tests.forEach(function (t) {
+    var buf = Buffer.from(t.bytes);
+    try {
+        assert.ok(telemetry.isBinary(buf));
+        assert.deepStrictEqual(telemetry.decode(buf), t.telemetry);
+        // every byte is needed
+        for (var cut = 1; cut < buf.length; cut++) {
+            assert.throws(function () {
+                telemetry.decode(buf.subarray(0, cut));
+            });
+        }
+        console.log('ok      ' + t.name);
+    }
+    catch (e) {
+        console.log('FAILED  ' + t.name + ': ' + e.message);
+        failed++;
+    }
+});
+
+// a batch sent as records one after the other
+var batch = Buffer.concat([Buffer.from(tests[0].bytes),
+                           Buffer.from(tests[1].bytes)]);
+try {
+    assert.deepStrictEqual(telemetry.decode(batch),
+                           tests[0].telemetry.concat(tests[1].telemetry));
+    console.log('ok      batch of records');
+}
+catch (e) {
+    console.log('FAILED  batch of records: ' + e.message);
+    failed++;
+}
+
+process.exit(failed ? 1 : 0);
@@ -0,0 +1,42 @@
+var mqtt = require('mqtt');
+var telemetry = require('./telemetry');
+
+// The local mosquitto the MQTT-SN gateway publishes to (BrokerPortNo in gateway.conf)
+const brokerUrl = process.env.BROKER_URL || 'mqtt://localhost:1884';
+// Topic the RIOT clients send their binary records to
+const binaryTopic = process.env.BINARY_TOPIC || 'riot/telemetry/bin';
+// Topic bridged to Thingsboard by mosquitto_bridge.conf
+const telemetryTopic = 'v1/devices/me/telemetry';
+
+console.log('Connecting to: %s', brokerUrl);
+var client = mqtt.connect(brokerUrl);
+
+client.on('connect', function () {
+    console.log('Translating %s to %s', binaryTopic, telemetryTopic);
+    client.subscribe(binaryTopic);
+});
+
+client.on('message', function (topic, payload) {
+    var records;
+
+    if (!telemetry.isBinary(payload)) {
+        // already JSON, pass it on unchanged
+        client.publish(telemetryTopic, payload);
+        return;
+    }
+    try {
+        records = telemetry.decode(payload);
+    }
+    catch (err) {
+        console.log('Dropping %d bytes on %s: %s', payload.length, topic, err.message);
+        return;
+    }
+    // Thingsboard takes a single object or an array of {ts, values}
+    var json = JSON.stringify(records.length === 1 ? records[0] : records);
+    console.log('%d bytes -> %s', payload.length, json);
+    client.publish(telemetryTopic, json);
+});
+
+client.on('error', function (err) {
+    console.log('MQTT error: %s', err.message);
+});